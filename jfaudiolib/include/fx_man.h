@@ -108,7 +108,15 @@ int FX_PlayRaw( char *ptr, unsigned int length, unsigned rate,
 int FX_PlayLoopedRaw( char *ptr, unsigned int length, char *loopstart,
        char *loopend, unsigned rate, int pitchoffset, int vol, int left,
        int right, int priority, unsigned int callbackval );
+int FX_DecodeSound( char *ptr, unsigned int ptrlength, char *dest,
+       unsigned int *rate, int *bits, int *channels );
+int FX_PlayLoopedPCM( char *ptr, unsigned int length, int loopstart, int loopend,
+       unsigned rate, int bits, int channels, int pitchoffset, int vol, int left,
+       int right, int priority, unsigned int callbackval );
+int FX_PlayPCM3D( char *ptr, unsigned int length, unsigned rate, int bits, int channels,
+       int pitchoffset, int angle, int distance, int priority, unsigned int callbackval );
 int FX_Pan3D( int handle, int angle, int distance );
+int FX_Pan3DBatch( int *handles, int *angles, int *distances, int count );
 int FX_SoundActive( int handle );
 int FX_SoundsPlaying( void );
 int FX_StopSound( int handle );
@@ -90,6 +90,10 @@ void  MUSIC_StopFade( void );
 void  MUSIC_RerouteMidiChannel( int channel, int ( *function )( int event, int c1, int c2 ) );
 void  MUSIC_RegisterTimbreBank( unsigned char *timbres );
 
+// midisynth.c
+int   MUSIC_RenderSong( char *song, int songlen, int rate, int maxseconds,
+                        volatile int *cancel, char **wave, int *wavelen );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,250 @@
+/*
+ This file is part of VibeDuke3D, the Duke Nukem 3D port for the Xbox, and
+ is distributed under the same licence as the rest of jfaudiolib.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ */
+
+/**
+ * Checks for MV_DecodeSound. Decodes well-formed VOC and WAV files and
+ * compares the PCM, then feeds it every truncation of them and a set of
+ * malformed headers and blocks, which must be rejected or decoded without
+ * reading outside the buffer. Each input sits in its own exactly-sized
+ * allocation, so building with -fsanitize=address catches stray reads.
+ *
+ * Build alongside the library sources, eg.
+ *   cc -g -fsanitize=address -Iinclude -Isrc -o decodetest src/decodetest.c \
+ *      src/fx_man.c src/multivoc.c src/mix.c src/mixst.c src/pitch.c \
+ *      src/drivers.c src/driver_nosound.c src/asssys.c
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fx_man.h"
+#include "multivoc.h"
+
+#define NUMSAMPLES 64
+
+static int failures = 0;
+
+#define CHECK(cond, what) \
+    do { if (!(cond)) { printf("FAIL: %s (line %d)\n", what, __LINE__); failures++; } } while (0)
+
+static unsigned char buf[1024];
+static int buflen;
+
+static void put8(int v) { buf[buflen++] = (unsigned char)v; }
+static void put16(int v) { put8(v & 255); put8((v >> 8) & 255); }
+static void put24(int v) { put16(v & 65535); put8((v >> 16) & 255); }
+static void put32(int v) { put16(v & 65535); put16((v >> 16) & 65535); }
+static void putstr(const char *s) { while (*s) put8(*s++); }
+
+static void putsamples(int bytes)
+{
+    int i;
+    for (i = 0; i < bytes; i++) put8(i * 7 + 3);
+}
+
+static int samplesmatch(const char *pcm, int bytes)
+{
+    int i;
+    for (i = 0; i < bytes; i++) {
+        if ((unsigned char)pcm[i] != (unsigned char)(i * 7 + 3)) return 0;
+    }
+    return 1;
+}
+
+static void vocheader(void)
+{
+    buflen = 0;
+    putstr("Creative Voice File");
+    put8(0x1a);
+    put16(0x1a);
+    put16(0x10a);
+    put16(0x1129);
+}
+
+static void makevoc8(void)
+{
+    vocheader();
+    put8(1); put24(2 + NUMSAMPLES);
+    put8(256 - 1000000 / 11025); put8(0);
+    putsamples(NUMSAMPLES);
+    put8(0);
+}
+
+static void makevocext(void)
+{
+    vocheader();
+    put8(8); put24(4);
+    put16(65536 - 256000000 / (2 * 11025)); put8(0); put8(1);
+    put8(1); put24(2 + NUMSAMPLES);
+    put8(0); put8(0);
+    putsamples(NUMSAMPLES);
+    put8(0);
+}
+
+static void makevoc16(void)
+{
+    vocheader();
+    put8(9); put24(12 + NUMSAMPLES);
+    put32(22050); put8(16); put8(2); put16(4); put32(0);
+    putsamples(NUMSAMPLES);
+    put8(0);
+}
+
+static void makewav(int bits, int channels)
+{
+    buflen = 0;
+    putstr("RIFF"); put32(36 + NUMSAMPLES); putstr("WAVE");
+    putstr("fmt "); put32(16);
+    put16(1); put16(channels); put32(22050);
+    put32(22050 * channels * bits / 8); put16(channels * bits / 8); put16(bits);
+    putstr("data"); put32(NUMSAMPLES);
+    putsamples(NUMSAMPLES);
+}
+
+/*
+ * Decodes the first 'len' bytes of buf from a buffer of exactly that size,
+ * first measuring then copying, and checks both agree.
+ */
+static int decode(int len, unsigned int *rate, int *bits, int *channels, char **pcmout)
+{
+    char *in, *pcm;
+    int measured, copied;
+
+    in = (char *)malloc(len > 0 ? len : 1);
+    memcpy(in, buf, len);
+
+    measured = MV_DecodeSound(in, len, NULL, rate, bits, channels);
+    pcm = NULL;
+    if (measured >= 0) {
+        pcm = (char *)malloc(measured > 0 ? measured : 1);
+        copied = MV_DecodeSound(in, len, pcm, rate, bits, channels);
+        CHECK(copied == measured, "measuring and copying disagree");
+    }
+    free(in);
+
+    if (pcmout) *pcmout = pcm;
+    else free(pcm);
+    return measured;
+}
+
+static void expectgood(const char *name, unsigned int wantrate, int wantbits, int wantchannels, int wantbytes)
+{
+    unsigned int rate = 0;
+    int bits = 0, channels = 0, len, i;
+    char *pcm;
+
+    len = decode(buflen, &rate, &bits, &channels, &pcm);
+    printf("%-16s %d bytes, %u Hz, %d-bit, %d channel(s)\n", name, len, rate, bits, channels);
+    CHECK(len == wantbytes, name);
+    CHECK(bits == wantbits && channels == wantchannels, name);
+    CHECK(wantrate == 0 || rate == wantrate, name);
+    if (len > 0) CHECK(samplesmatch(pcm, len), name);
+    free(pcm);
+
+    // no truncation of a good file may read past its end
+    for (i = 0; i < buflen; i++) {
+        len = decode(i, &rate, &bits, &channels, NULL);
+        CHECK(len == MV_Error || len <= i, "truncated file decoded to more than it holds");
+    }
+}
+
+static void expectbad(const char *name)
+{
+    unsigned int rate;
+    int bits, channels, len;
+
+    len = decode(buflen, &rate, &bits, &channels, NULL);
+    printf("%-16s %s\n", name, len == MV_Error ? "rejected" : "accepted");
+    CHECK(len == MV_Error, name);
+}
+
+int main(void)
+{
+    makevoc8();
+    expectgood("voc 8-bit", 0, 8, 1, NUMSAMPLES);
+    makevocext();
+    expectgood("voc extended", 11025, 8, 2, NUMSAMPLES);
+    makevoc16();
+    expectgood("voc 16-bit", 22050, 16, 2, NUMSAMPLES);
+    makewav(8, 1);
+    expectgood("wav 8-bit mono", 22050, 8, 1, NUMSAMPLES);
+    makewav(16, 2);
+    expectgood("wav 16-bit", 22050, 16, 2, NUMSAMPLES);
+
+    // an extended block too short to hold its fields
+    vocheader();
+    put8(8); put24(2); put16(0);
+    expectbad("voc short ext");
+
+    // a sound data block too short for its header
+    vocheader();
+    put8(1); put24(1); put8(0);
+    expectbad("voc short data");
+
+    // a new sound data block too short for its header
+    vocheader();
+    put8(9); put24(8); put32(22050); put32(0);
+    expectbad("voc short new");
+
+    // the first block offset points past the end
+    makevoc8();
+    buf[0x14] = 0xff; buf[0x15] = 0x7f;
+    expectbad("voc bad offset");
+
+    // packed data
+    makevoc8();
+    buf[0x1a + 5] = 1;
+    expectbad("voc packed");
+
+    // repeat block
+    vocheader();
+    put8(6); put24(2); put16(1);
+    expectbad("voc repeat");
+
+    // a format chunk that claims to run past the end
+    makewav(16, 1);
+    buf[16] = 0xff; buf[17] = 0xff; buf[18] = 0xff; buf[19] = 0x7f;
+    expectbad("wav bad fmt size");
+
+    // not PCM
+    makewav(16, 1);
+    buf[20] = 2;
+    expectbad("wav compressed");
+
+    // impossible channel count
+    makewav(16, 1);
+    buf[22] = 0;
+    expectbad("wav 0 channels");
+
+    // a data chunk that claims more than there is
+    makewav(8, 1);
+    buf[40] = 0xff; buf[41] = 0xff;
+    expectgood("wav long data", 22050, 8, 1, NUMSAMPLES);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    puts("all checks passed");
+    return 0;
+}
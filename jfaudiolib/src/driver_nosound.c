@@ -25,6 +25,12 @@
 #include "midifuncs.h"
 #include <string.h>
 
+static char *MixBuffer = 0;
+static int MixBufferSize = 0;
+static int MixBufferCount = 0;
+static int MixBufferCurrent = 0;
+static void ( *MixCallBack )( void ) = 0;
+
 int NoSoundDrv_GetError(void)
 {
 	return 0;
@@ -49,12 +55,50 @@ void NoSoundDrv_PCM_Shutdown(void)
 int NoSoundDrv_PCM_BeginPlayback(char *BufferStart, int BufferSize,
 						int NumDivisions, void ( *CallBackFunc )( void ) )
 {
-	(void)BufferStart; (void)BufferSize; (void)NumDivisions; (void)CallBackFunc;
+	MixBuffer = BufferStart;
+	MixBufferSize = BufferSize;
+	MixBufferCount = NumDivisions;
+	MixBufferCurrent = 0;
+	MixCallBack = CallBackFunc;
+
+	// prime the buffer like a real device would
+	MixCallBack();
+
 	return 0;
 }
 
 void NoSoundDrv_PCM_StopPlayback(void)
 {
+	MixCallBack = 0;
+}
+
+/**
+ * Offline rendering: advances the ring by one division exactly as a
+ * device callback would, and returns the division that is now "playing".
+ * Nothing ever calls this during normal use, so the driver stays silent.
+ * @param size receives the division size in bytes
+ * @return pointer to the mixed division, or NULL if playback isn't running
+ */
+char * NoSoundDrv_PCM_Pump(int *size)
+{
+	char *ptr;
+
+	if (!MixCallBack) {
+		if (size) *size = 0;
+		return 0;
+	}
+
+	ptr = MixBuffer + (MixBufferCurrent * MixBufferSize);
+
+	MixCallBack();
+
+	MixBufferCurrent++;
+	if (MixBufferCurrent >= MixBufferCount) {
+		MixBufferCurrent -= MixBufferCount;
+	}
+
+	if (size) *size = MixBufferSize;
+	return ptr;
 }
 
 void NoSoundDrv_PCM_Lock(void)
@@ -29,6 +29,7 @@ int  NoSoundDrv_PCM_BeginPlayback(char *BufferStart, int BufferSize,
 void NoSoundDrv_PCM_StopPlayback(void);
 void NoSoundDrv_PCM_Lock(void);
 void NoSoundDrv_PCM_Unlock(void);
+char *NoSoundDrv_PCM_Pump(int *size);
 
 int  NoSoundDrv_CD_Init(void);
 void NoSoundDrv_CD_Shutdown(void);
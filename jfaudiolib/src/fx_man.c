@@ -845,6 +845,111 @@ int FX_PlayLoopedRaw
    }
 
 
+/*---------------------------------------------------------------------
+   Function: FX_DecodeSound
+
+   Converts a VOC or WAV file to flat PCM for FX_PlayLoopedPCM.
+---------------------------------------------------------------------*/
+
+int FX_DecodeSound
+   (
+   char *ptr,
+   unsigned int ptrlength,
+   char *dest,
+   unsigned int *rate,
+   int *bits,
+   int *channels
+   )
+
+   {
+   int length;
+
+   length = MV_DecodeSound( ptr, ptrlength, dest, rate, bits, channels );
+   if ( length < MV_Ok )
+      {
+      FX_SetErrorCode( FX_MultiVocError );
+      length = FX_Warning;
+      }
+
+   return( length );
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: FX_PlayLoopedPCM
+
+   Begin playback of flat PCM sound data with the given volume and
+   priority.
+---------------------------------------------------------------------*/
+
+int FX_PlayLoopedPCM
+   (
+   char *ptr,
+   unsigned int length,
+   int loopstart,
+   int loopend,
+   unsigned rate,
+   int bits,
+   int channels,
+   int pitchoffset,
+   int vol,
+   int left,
+   int right,
+   int priority,
+   unsigned int callbackval
+   )
+
+   {
+   int handle;
+
+   handle = MV_PlayLoopedPCM( ptr, length, loopstart, loopend, rate, bits,
+      channels, pitchoffset, vol, left, right, priority, callbackval );
+   if ( handle < MV_Ok )
+      {
+      FX_SetErrorCode( FX_MultiVocError );
+      handle = FX_Warning;
+      }
+
+   return( handle );
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: FX_PlayPCM3D
+
+   Begin playback of flat PCM sound data at specified angle and
+   distance from listener.
+---------------------------------------------------------------------*/
+
+int FX_PlayPCM3D
+   (
+   char *ptr,
+   unsigned int length,
+   unsigned rate,
+   int bits,
+   int channels,
+   int pitchoffset,
+   int angle,
+   int distance,
+   int priority,
+   unsigned int callbackval
+   )
+
+   {
+   int handle;
+
+   handle = MV_PlayPCM3D( ptr, length, rate, bits, channels, pitchoffset,
+      angle, distance, priority, callbackval );
+   if ( handle < MV_Ok )
+      {
+      FX_SetErrorCode( FX_MultiVocError );
+      handle = FX_Warning;
+      }
+
+   return( handle );
+   }
+
+
 /*---------------------------------------------------------------------
    Function: FX_Pan3D
 
@@ -873,6 +978,35 @@ int FX_Pan3D
    }
 
 
+/*---------------------------------------------------------------------
+   Function: FX_Pan3DBatch
+
+   Set the angle and distance from the listener of several voices
+   in one update.
+---------------------------------------------------------------------*/
+
+int FX_Pan3DBatch
+   (
+   int *handles,
+   int *angles,
+   int *distances,
+   int  count
+   )
+
+   {
+   int status;
+
+   status = MV_Pan3DBatch( handles, angles, distances, count );
+   if ( status != MV_Ok )
+      {
+      FX_SetErrorCode( FX_MultiVocError );
+      status = FX_Warning;
+      }
+
+   return( status );
+   }
+
+
 /*---------------------------------------------------------------------
    Function: FX_SoundActive
 
@@ -0,0 +1,858 @@
+/*
+ This file is part of VibeDuke3D, the Duke Nukem 3D port for the Xbox, and
+ is distributed under the same licence as the rest of jfaudiolib.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ */
+
+/**
+ * Offline MIDI renderer. A small two-operator FM synth, in the spirit of
+ * the OPL voices the music was written for, which renders a whole song
+ * to a mono 16-bit WAV in memory so it can be cached and then played as
+ * an ordinary looped voice.
+ *
+ * Nothing in here touches global state, so a song may be rendered on a
+ * worker thread while the mixer and the MIDI sequencer carry on.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "music.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The EMIDI controllers honoured when picking tracks, as in _midi.h.
+// Songs are rendered as the General MIDI personality would hear them.
+#define EMIDI_INCLUDE_TRACK     110
+#define EMIDI_EXCLUDE_TRACK     111
+#define EMIDI_PROGRAM_CHANGE    112
+#define EMIDI_VOLUME_CHANGE     113
+#define EMIDI_ALL_CARDS         127
+#define EMIDI_GeneralMIDI       0
+#define EMIDI_AffectsGeneralMIDI( c ) \
+    ( ( ( c ) == EMIDI_ALL_CARDS ) || ( ( c ) == EMIDI_GeneralMIDI ) )
+
+#define NUM_CHANNELS     16
+#define PERCUSSION       9
+#define MAX_VOICES       32
+#define SINE_BITS        10
+#define SINE_SIZE        ( 1 << SINE_BITS )
+#define MASTER_GAIN      0.3f
+#define SILENT_LEVEL     0.0001f
+#define RENDER_BLOCK     64
+
+enum {
+    STAGE_OFF,
+    STAGE_ATTACK,
+    STAGE_DECAY,
+    STAGE_RELEASE
+};
+
+enum {
+    DRUM_NONE,
+    DRUM_KICK,
+    DRUM_SNARE,
+    DRUM_TOM,
+    DRUM_HAT,
+    DRUM_CYMBAL,
+    DRUM_NOISE
+};
+
+typedef struct {
+    unsigned char modratio;     // modulator frequency as a multiple of the carrier, in halves
+    unsigned char modindex;     // modulation depth, 256 = pi radians
+    unsigned short attack;      // milliseconds
+    unsigned short decay;       // milliseconds to fall 60dB towards the sustain level
+    unsigned char sustain;      // 0-255
+    unsigned short release;     // milliseconds to fall 60dB
+} fmpatch;
+
+// One patch per General MIDI instrument family, eight programs apiece
+static const fmpatch familypatches[16] = {
+    {  2,  90,   2, 1500,   0, 200 },  // piano
+    {  7, 120,   1,  800,   0, 300 },  // chromatic percussion
+    {  2,  40,   5,  100, 220,  60 },  // organ
+    {  2, 110,   2, 1200,  40, 150 },  // guitar
+    {  2, 140,   2,  600, 120,  80 },  // bass
+    {  2,  70,  80,  300, 200, 300 },  // strings
+    {  2,  60, 100,  300, 200, 400 },  // ensemble
+    {  2, 160,  30,  200, 200, 150 },  // brass
+    {  6, 100,  20,  200, 200, 100 },  // reed
+    {  2,  30,  40,  100, 210, 120 },  // pipe
+    {  2, 180,   5,  200, 210, 100 },  // synth lead
+    {  1,  60, 300,  500, 200, 600 },  // synth pad
+    {  5, 100, 100,  800, 150, 600 },  // synth effects
+    {  6, 110,   2,  900,   0, 200 },  // ethnic
+    {  3, 150,   1,  400,   0, 150 },  // percussive
+    {  9, 200,  50, 1000, 100, 500 },  // sound effects
+};
+
+// Overdriven and distorted guitars are the sound of the game
+static const fmpatch distortionpatch = { 2, 230, 2, 1500, 90, 120 };
+
+typedef struct {
+    const unsigned char *pos;
+    const unsigned char *end;
+    unsigned int tick;          // absolute tick of the next event
+    unsigned char status;       // running status
+    char include;
+    char emidiprogram;
+    char emidivolume;
+} rendertrack;
+
+typedef struct {
+    unsigned char program;
+    unsigned char volume;
+    unsigned char expression;
+    unsigned char sustain;
+    float bend;                 // semitones
+} renderchannel;
+
+typedef struct {
+    char stage;
+    char drum;
+    char channel;
+    char key;
+    char held;                  // released while the sustain pedal was down
+    unsigned int age;
+
+    unsigned int cphase, cinc;
+    unsigned int mphase, minc;
+    float modscale;
+    float sweep, sweepmul;      // kick and tom pitch drop, as a carrier increment multiplier
+
+    float gain;
+    float level;
+    float attackstep;
+    float decaymul;
+    float sustain;
+    float releasemul;
+
+    unsigned int noise;
+    float lastnoise;
+} synthvoice;
+
+typedef struct {
+    int rate;
+    int division;
+    int numtracks;
+    rendertrack *tracks;
+    renderchannel channels[NUM_CHANNELS];
+    synthvoice voices[MAX_VOICES];
+    unsigned int age;
+    float sine[SINE_SIZE];
+} rendersong;
+
+static unsigned int readvarlen(const unsigned char **pos, const unsigned char *end)
+{
+    unsigned int value = 0;
+    unsigned char c;
+
+    do {
+        if (*pos >= end) return 0;
+        c = *(*pos)++;
+        value = (value << 7) | (c & 0x7f);
+    } while (c & 0x80);
+
+    return value;
+}
+
+static unsigned int readbigendian(const unsigned char *ptr, int bytes)
+{
+    unsigned int value = 0;
+
+    while (bytes-- > 0) {
+        value = (value << 8) | *ptr++;
+    }
+
+    return value;
+}
+
+static int channelmessagelength(unsigned char status)
+{
+    switch (status & 0xf0) {
+        case 0xc0:
+        case 0xd0:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+/**
+ * Reads the delta time of the next event of a track.
+ */
+static void nexteventtime(rendertrack *track)
+{
+    if (!track->pos || track->pos >= track->end) {
+        track->pos = NULL;
+        return;
+    }
+    track->tick += readvarlen(&track->pos, track->end);
+}
+
+/**
+ * Skips over one event without acting on it. Returns the status byte
+ * of channel messages, with the data bytes in c1 and c2, or 0 otherwise.
+ * Sets *tempo for tempo changes.
+ */
+static unsigned char readevent(rendertrack *track, int *c1, int *c2, unsigned int *tempo)
+{
+    unsigned char status;
+    unsigned int length;
+
+    if (!track->pos || track->pos >= track->end) {
+        track->pos = NULL;
+        return 0;
+    }
+
+    status = *track->pos;
+    if (status & 0x80) {
+        track->pos++;
+    } else {
+        status = track->status;
+    }
+
+    if (status == 0xff) {
+        unsigned char type;
+
+        if (track->pos >= track->end) {
+            track->pos = NULL;
+            return 0;
+        }
+        type = *track->pos++;
+        length = readvarlen(&track->pos, track->end);
+        if (track->pos + length > track->end) {
+            track->pos = NULL;
+            return 0;
+        }
+        if (type == 0x51 && length == 3 && tempo) {
+            *tempo = readbigendian(track->pos, 3);
+        } else if (type == 0x2f) {
+            track->pos = NULL;
+            return 0;
+        }
+        track->pos += length;
+        return 0;
+    } else if (status == 0xf0 || status == 0xf7) {
+        length = readvarlen(&track->pos, track->end);
+        track->pos += length;
+        if (track->pos > track->end) track->pos = NULL;
+        return 0;
+    } else if (status < 0x80) {
+        // data with no running status to apply it to
+        track->pos = NULL;
+        return 0;
+    }
+
+    track->status = status;
+    if (track->pos + channelmessagelength(status) > track->end) {
+        track->pos = NULL;
+        return 0;
+    }
+    *c1 = track->pos[0] & 0x7f;
+    *c2 = 0;
+    if (channelmessagelength(status) == 2) {
+        *c2 = track->pos[1] & 0x7f;
+    }
+    track->pos += channelmessagelength(status);
+
+    return status;
+}
+
+/**
+ * Finds the tracks of the file and works out which of them the EMIDI
+ * controllers want played, the same way the MIDI sequencer does.
+ */
+static int loadtracks(rendersong *song, const unsigned char *data, int length)
+{
+    const unsigned char *pos, *end;
+    int format, i;
+
+    if (length < 14 || memcmp(data, "MThd", 4) || readbigendian(data + 4, 4) < 6) {
+        return -1;
+    }
+
+    format = (int)readbigendian(data + 8, 2);
+    song->numtracks = (int)readbigendian(data + 10, 2);
+    song->division = (int)readbigendian(data + 12, 2);
+    if (format > 1 || song->numtracks < 1 || song->division <= 0 || (song->division & 0x8000)) {
+        // type 2 files and SMPTE timing aren't used by any game music
+        return -1;
+    }
+
+    song->tracks = (rendertrack *)calloc(song->numtracks, sizeof(rendertrack));
+    if (!song->tracks) {
+        return -1;
+    }
+
+    end = data + length;
+    pos = data + 8 + readbigendian(data + 4, 4);
+    for (i = 0; i < song->numtracks; i++) {
+        rendertrack scan;
+        unsigned int chunklen;
+        int c1, c2, includefound = 0;
+        unsigned char status;
+
+        if (pos + 8 > end || memcmp(pos, "MTrk", 4)) {
+            song->numtracks = i;
+            break;
+        }
+        chunklen = readbigendian(pos + 4, 4);
+        pos += 8;
+        if (chunklen > (unsigned int)(end - pos)) {
+            chunklen = (unsigned int)(end - pos);
+        }
+
+        song->tracks[i].pos = pos;
+        song->tracks[i].end = pos + chunklen;
+        song->tracks[i].include = 1;
+
+        scan = song->tracks[i];
+        for (nexteventtime(&scan); scan.pos; nexteventtime(&scan)) {
+            status = readevent(&scan, &c1, &c2, NULL);
+            if ((status & 0xf0) != 0xb0) continue;
+
+            switch (c1) {
+                case EMIDI_INCLUDE_TRACK:
+                    if (EMIDI_AffectsGeneralMIDI(c2)) {
+                        includefound = 1;
+                        song->tracks[i].include = 1;
+                    } else if (!includefound) {
+                        includefound = 1;
+                        song->tracks[i].include = 0;
+                    }
+                    break;
+                case EMIDI_EXCLUDE_TRACK:
+                    if (EMIDI_AffectsGeneralMIDI(c2)) {
+                        song->tracks[i].include = 0;
+                    }
+                    break;
+                case EMIDI_PROGRAM_CHANGE:
+                    song->tracks[i].emidiprogram = 1;
+                    break;
+                case EMIDI_VOLUME_CHANGE:
+                    song->tracks[i].emidivolume = 1;
+                    break;
+            }
+        }
+
+        pos += chunklen;
+    }
+
+    for (i = 0; i < song->numtracks; i++) {
+        nexteventtime(&song->tracks[i]);
+    }
+
+    return song->numtracks > 0 ? 0 : -1;
+}
+
+static unsigned int frequencytoinc(rendersong *song, float frequency)
+{
+    return (unsigned int)(frequency * 4294967296.0 / song->rate);
+}
+
+static float keyfrequency(float key)
+{
+    return 440.f * (float)pow(2.0, (key - 69.f) / 12.0);
+}
+
+static float decaymultiplier(rendersong *song, int milliseconds)
+{
+    // -60dB over the given time
+    if (milliseconds <= 0) return 0.f;
+    return (float)exp(log(0.001) * 1000.0 / ((double)milliseconds * song->rate));
+}
+
+static void setvoicepitch(rendersong *song, synthvoice *voice)
+{
+    const fmpatch *patch;
+    float frequency;
+    int program;
+
+    if (voice->drum) return;
+
+    program = song->channels[(int)voice->channel].program;
+    patch = (program == 29 || program == 30) ? &distortionpatch : &familypatches[program >> 3];
+    frequency = keyfrequency(voice->key + song->channels[(int)voice->channel].bend);
+
+    voice->cinc = frequencytoinc(song, frequency);
+    voice->minc = frequencytoinc(song, frequency * patch->modratio * 0.5f);
+}
+
+static void noteoff(rendersong *song, int channel, int key)
+{
+    int i;
+
+    for (i = 0; i < MAX_VOICES; i++) {
+        synthvoice *voice = &song->voices[i];
+
+        if (voice->stage == STAGE_OFF || voice->stage == STAGE_RELEASE ||
+            voice->channel != channel || voice->key != key || voice->held) {
+            continue;
+        }
+        if (voice->drum) {
+            // drums always play out their decay
+            continue;
+        }
+        if (song->channels[channel].sustain) {
+            voice->held = 1;
+        } else {
+            voice->stage = STAGE_RELEASE;
+        }
+    }
+}
+
+static void releaseheld(rendersong *song, int channel)
+{
+    int i;
+
+    for (i = 0; i < MAX_VOICES; i++) {
+        synthvoice *voice = &song->voices[i];
+
+        if (voice->held && voice->channel == channel) {
+            voice->held = 0;
+            voice->stage = STAGE_RELEASE;
+        }
+    }
+}
+
+static synthvoice * allocvoice(rendersong *song)
+{
+    synthvoice *best = NULL;
+    int i;
+
+    for (i = 0; i < MAX_VOICES; i++) {
+        synthvoice *voice = &song->voices[i];
+
+        if (voice->stage == STAGE_OFF) {
+            return voice;
+        }
+        // steal the oldest releasing voice, else the oldest voice
+        if (voice->stage == STAGE_RELEASE) {
+            if (!best || best->stage != STAGE_RELEASE || voice->age < best->age) {
+                best = voice;
+            }
+        } else if (!best || (best->stage != STAGE_RELEASE && voice->age < best->age)) {
+            best = voice;
+        }
+    }
+
+    return best;
+}
+
+static void noteon(rendersong *song, int channel, int key, int velocity)
+{
+    renderchannel *chan = &song->channels[channel];
+    synthvoice *voice;
+    const fmpatch *patch;
+    float vel;
+    int attack;
+
+    if (velocity == 0) {
+        noteoff(song, channel, key);
+        return;
+    }
+
+    voice = allocvoice(song);
+    memset(voice, 0, sizeof(synthvoice));
+
+    voice->channel = channel;
+    voice->key = key;
+    voice->age = song->age++;
+    voice->noise = 0x12345u + key * 7919u;
+
+    vel = velocity / 127.f;
+    voice->gain = vel * vel * MASTER_GAIN;
+
+    if (channel == PERCUSSION) {
+        float frequency = 0.f;
+        int decay;
+
+        switch (key) {
+            case 35: case 36:
+                voice->drum = DRUM_KICK; frequency = 150.f; decay = 220; break;
+            case 37: case 38: case 39: case 40:
+                voice->drum = DRUM_SNARE; frequency = 190.f; decay = 180; break;
+            case 41: case 43: case 45: case 47: case 48: case 50:
+                voice->drum = DRUM_TOM; frequency = keyfrequency(key - 12); decay = 350; break;
+            case 42: case 44:
+                voice->drum = DRUM_HAT; decay = 60; break;
+            case 46:
+                voice->drum = DRUM_HAT; decay = 300; break;
+            case 49: case 51: case 52: case 53: case 55: case 57: case 59:
+                voice->drum = DRUM_CYMBAL; decay = 1200; break;
+            default:
+                voice->drum = DRUM_NOISE; decay = 150; break;
+        }
+
+        voice->cinc = frequencytoinc(song, frequency);
+        voice->sweep = 1.f;
+        voice->sweepmul = (voice->drum == DRUM_KICK || voice->drum == DRUM_TOM) ?
+            decaymultiplier(song, decay * 2) : 1.f;
+        voice->level = 1.f;
+        voice->stage = STAGE_DECAY;
+        voice->decaymul = decaymultiplier(song, decay);
+        voice->releasemul = voice->decaymul;
+        voice->sustain = 0.f;
+        return;
+    }
+
+    patch = (chan->program == 29 || chan->program == 30) ? &distortionpatch : &familypatches[chan->program >> 3];
+
+    attack = patch->attack * song->rate / 1000;
+    voice->attackstep = attack > 0 ? 1.f / attack : 1.f;
+    voice->decaymul = decaymultiplier(song, patch->decay);
+    voice->sustain = patch->sustain / 255.f;
+    voice->releasemul = decaymultiplier(song, patch->release);
+    voice->modscale = patch->modindex * 8388608.f;      // 256 = pi radians of phase
+    voice->stage = STAGE_ATTACK;
+
+    setvoicepitch(song, voice);
+}
+
+static float channelgain(renderchannel *chan)
+{
+    float vol = chan->volume / 127.f;
+    return vol * vol * (chan->expression / 127.f);
+}
+
+static void controlchange(rendersong *song, rendertrack *track, int channel, int number, int value)
+{
+    renderchannel *chan = &song->channels[channel];
+    int i;
+
+    switch (number) {
+        case 7:
+            if (!track->emidivolume) chan->volume = value;
+            break;
+        case EMIDI_VOLUME_CHANGE:
+            if (track->emidivolume) chan->volume = value;
+            break;
+        case EMIDI_PROGRAM_CHANGE:
+            if (track->emidiprogram) chan->program = value;
+            break;
+        case 11:
+            chan->expression = value;
+            break;
+        case 64:
+            chan->sustain = value >= 64;
+            if (!chan->sustain) releaseheld(song, channel);
+            break;
+        case 120:   // all sound off
+            for (i = 0; i < MAX_VOICES; i++) {
+                if (song->voices[i].channel == channel) song->voices[i].stage = STAGE_OFF;
+            }
+            break;
+        case 121:   // reset controllers
+            chan->expression = 127;
+            chan->sustain = 0;
+            chan->bend = 0.f;
+            releaseheld(song, channel);
+            break;
+        case 123:   // all notes off
+            for (i = 0; i < MAX_VOICES; i++) {
+                synthvoice *voice = &song->voices[i];
+                if (voice->channel == channel && voice->stage != STAGE_OFF && !voice->drum) {
+                    voice->held = 0;
+                    voice->stage = STAGE_RELEASE;
+                }
+            }
+            break;
+    }
+}
+
+static void channelevent(rendersong *song, rendertrack *track, unsigned char status, int c1, int c2)
+{
+    int channel = status & 0x0f;
+    int i;
+
+    switch (status & 0xf0) {
+        case 0x80:
+            noteoff(song, channel, c1);
+            break;
+        case 0x90:
+            noteon(song, channel, c1, c2);
+            break;
+        case 0xb0:
+            controlchange(song, track, channel, c1, c2);
+            break;
+        case 0xc0:
+            if (!track->emidiprogram) song->channels[channel].program = c1;
+            break;
+        case 0xe0:
+            song->channels[channel].bend = (((c2 << 7) | c1) - 8192) * (2.f / 8192.f);
+            for (i = 0; i < MAX_VOICES; i++) {
+                if (song->voices[i].stage != STAGE_OFF && song->voices[i].channel == channel) {
+                    setvoicepitch(song, &song->voices[i]);
+                }
+            }
+            break;
+    }
+}
+
+/**
+ * Adds 'count' samples of every sounding voice to mix.
+ */
+static void synthesize(rendersong *song, float *mix, int count)
+{
+    const float *sine = song->sine;
+    int i, n;
+
+    for (i = 0; i < MAX_VOICES; i++) {
+        synthvoice *voice = &song->voices[i];
+        float gain, level, sample;
+
+        if (voice->stage == STAGE_OFF) continue;
+
+        gain = voice->gain * channelgain(&song->channels[(int)voice->channel]);
+        level = voice->level;
+
+        for (n = 0; n < count; n++) {
+            switch (voice->stage) {
+                case STAGE_ATTACK:
+                    level += voice->attackstep;
+                    if (level >= 1.f) {
+                        level = 1.f;
+                        voice->stage = STAGE_DECAY;
+                    }
+                    break;
+                case STAGE_DECAY:
+                    level = voice->sustain + (level - voice->sustain) * voice->decaymul;
+                    break;
+                case STAGE_RELEASE:
+                    level *= voice->releasemul;
+                    break;
+            }
+
+            if (voice->drum) {
+                float noise;
+
+                voice->noise = voice->noise * 1664525u + 1013904223u;
+                noise = (int)voice->noise * (1.f / 2147483648.f);
+
+                switch (voice->drum) {
+                    case DRUM_KICK:
+                    case DRUM_TOM:
+                        sample = sine[voice->cphase >> (32 - SINE_BITS)];
+                        voice->cphase += (unsigned int)(voice->cinc * voice->sweep);
+                        voice->sweep = 0.4f + (voice->sweep - 0.4f) * voice->sweepmul;
+                        break;
+                    case DRUM_SNARE:
+                        sample = sine[voice->cphase >> (32 - SINE_BITS)] * 0.5f + noise * 0.7f;
+                        voice->cphase += voice->cinc;
+                        break;
+                    case DRUM_HAT:
+                    case DRUM_CYMBAL:
+                        // a first difference keeps only the hiss
+                        sample = (noise - voice->lastnoise) * 0.35f;
+                        voice->lastnoise = noise;
+                        break;
+                    default:
+                        sample = noise * 0.5f;
+                        break;
+                }
+            } else {
+                float mod = sine[voice->mphase >> (32 - SINE_BITS)] * voice->modscale * level;
+                sample = sine[(voice->cphase + (unsigned int)(int)mod) >> (32 - SINE_BITS)];
+                voice->mphase += voice->minc;
+                voice->cphase += voice->cinc;
+            }
+
+            mix[n] += sample * level * gain;
+        }
+
+        voice->level = level;
+        if (level < SILENT_LEVEL && voice->stage != STAGE_ATTACK &&
+            (voice->stage == STAGE_RELEASE || voice->sustain < SILENT_LEVEL)) {
+            voice->stage = STAGE_OFF;
+        }
+    }
+}
+
+/**
+ * Runs the song through the sequencer. With 'out' NULL it only measures
+ * the length in samples, otherwise it synthesises up to 'maxsamples'.
+ */
+static int sequence(rendersong *song, short *out, int maxsamples, volatile int *cancel)
+{
+    float mix[RENDER_BLOCK];
+    unsigned int tempo = 500000, tick = 0;
+    double samplepos = 0.0;
+    int written = 0, i, c1, c2, block;
+    unsigned char status;
+
+    for (;;) {
+        rendertrack *next = NULL;
+        int target;
+
+        for (i = 0; i < song->numtracks; i++) {
+            if (song->tracks[i].pos && (!next || song->tracks[i].tick < next->tick)) {
+                next = &song->tracks[i];
+            }
+        }
+        if (!next) break;
+
+        // advance time up to the event
+        samplepos += (double)(next->tick - tick) * tempo * song->rate / (1000000.0 * song->division);
+        tick = next->tick;
+        target = (int)samplepos;
+        if (target > maxsamples) target = maxsamples;
+
+        while (written < target) {
+            if (cancel && *cancel) return -1;
+
+            block = target - written;
+            if (block > RENDER_BLOCK) block = RENDER_BLOCK;
+            if (out) {
+                memset(mix, 0, sizeof(float) * block);
+                synthesize(song, mix, block);
+                for (i = 0; i < block; i++) {
+                    int sample = (int)(mix[i] * 32767.f);
+                    if (sample < -32768) sample = -32768;
+                    else if (sample > 32767) sample = 32767;
+                    out[written + i] = (short)sample;
+                }
+            }
+            written += block;
+        }
+        if (written >= maxsamples) break;
+
+        status = readevent(next, &c1, &c2, &tempo);
+        if (status && next->include && out) {
+            channelevent(song, next, status, c1, c2);
+        }
+        if (next->pos) {
+            nexteventtime(next);
+        }
+    }
+
+    return written;
+}
+
+static void resetsong(rendersong *song, const unsigned char *data, int length)
+{
+    int i;
+
+    free(song->tracks);
+    song->tracks = NULL;
+    loadtracks(song, data, length);
+
+    memset(song->voices, 0, sizeof(song->voices));
+    for (i = 0; i < NUM_CHANNELS; i++) {
+        song->channels[i].program = 0;
+        song->channels[i].volume = 100;
+        song->channels[i].expression = 127;
+        song->channels[i].sustain = 0;
+        song->channels[i].bend = 0.f;
+    }
+    song->age = 0;
+}
+
+static void putle(unsigned char *ptr, unsigned int value, int bytes)
+{
+    while (bytes-- > 0) {
+        *ptr++ = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+/**
+ * Renders a MIDI song to a 16-bit mono WAV image.
+ * @param song the MIDI file image
+ * @param songlen its length
+ * @param rate the sample rate to render at
+ * @param maxseconds the longest render to produce
+ * @param cancel if not NULL, polled during the render; non-zero aborts
+ * @param wave receives the malloc()'d WAV image
+ * @param wavelen receives the WAV image length
+ * @return MUSIC_Ok, or MUSIC_Error if the song is unusable, out of
+ *   memory, or cancelled. MUSIC_ErrorCode is left alone so this may be
+ *   called from any thread.
+ */
+int MUSIC_RenderSong(char *song, int songlen, int rate, int maxseconds,
+                     volatile int *cancel, char **wave, int *wavelen)
+{
+    rendersong *state;
+    unsigned char *image;
+    int samples, i;
+
+    *wave = NULL;
+    *wavelen = 0;
+
+    state = (rendersong *)calloc(1, sizeof(rendersong));
+    if (!state) {
+        return MUSIC_Error;
+    }
+    state->rate = rate;
+    for (i = 0; i < SINE_SIZE; i++) {
+        state->sine[i] = (float)sin(i * 2.0 * M_PI / SINE_SIZE);
+    }
+
+    if (loadtracks(state, (const unsigned char *)song, songlen) < 0) {
+        free(state->tracks);
+        free(state);
+        return MUSIC_Error;
+    }
+
+    samples = sequence(state, NULL, maxseconds * rate, cancel);
+    image = samples > 0 ? (unsigned char *)malloc(44 + samples * 2) : NULL;
+    if (!image) {
+        free(state->tracks);
+        free(state);
+        return MUSIC_Error;
+    }
+
+    resetsong(state, (const unsigned char *)song, songlen);
+    if (sequence(state, (short *)(image + 44), samples, cancel) != samples) {
+        free(image);
+        free(state->tracks);
+        free(state);
+        return MUSIC_Error;
+    }
+    free(state->tracks);
+    free(state);
+
+#ifdef BIGENDIAN
+    for (i = 0; i < samples; i++) {
+        unsigned char *s = image + 44 + i * 2, t = s[0];
+        s[0] = s[1];
+        s[1] = t;
+    }
+#endif
+
+    memcpy(image, "RIFF", 4);
+    putle(image + 4, 36 + samples * 2, 4);
+    memcpy(image + 8, "WAVEfmt ", 8);
+    putle(image + 16, 16, 4);
+    putle(image + 20, 1, 2);            // PCM
+    putle(image + 22, 1, 2);            // mono
+    putle(image + 24, rate, 4);
+    putle(image + 28, rate * 2, 4);
+    putle(image + 32, 2, 2);
+    putle(image + 34, 16, 2);
+    memcpy(image + 36, "data", 4);
+    putle(image + 40, samples * 2, 4);
+
+    *wave = (char *)image;
+    *wavelen = 44 + samples * 2;
+
+    return MUSIC_Ok;
+}
@@ -20,6 +20,12 @@
 
 #include "_multivc.h"
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__MMX__)
+# include <mmintrin.h>
+#endif
+
 extern char  *MV_HarshClipTable;
 extern char  *MV_MixDestination;			// pointer to the next output sample
 extern unsigned int MV_MixPosition;		// return value of where the source pointer got to
@@ -285,69 +291,73 @@ void MV_Mix16BitStereo16( unsigned int position, unsigned int rate,
     MV_MixDestination = (char *) dest;
 }
 
-void MV_16BitReverb( char *src, char *dest, VOLUME16 *volume, unsigned int count )
+/*
+ Adds the reverb send in src to the bus in dest, scaled by scale/32768
+ with saturation. This is the only per-sample reverb work done for each
+ buffer, so it is vectorised where the target allows it.
+ */
+void MV_16BitReverbMix( char *src, char *dest, int scale, unsigned int count )
 {
-    unsigned short * input = (unsigned short *) src;
+    short * input = (short *) src;
     short * output = (short *) dest;
-    short sample0l, sample0h, sample0;
-    
-    do {
-        sample0 = *input;
-#ifdef BIGENDIAN
-        sample0l = sample0 >> 8;
-        sample0h = (sample0 & 255) ^ 128;
-#else
-        sample0l = sample0 & 255;
-        sample0h = (sample0 >> 8) ^ 128;
+    int sample0;
+
+#if defined(__SSE2__)
+    __m128i vscale = _mm_set1_epi16((short) scale);
+    __m128i in, lo, hi, wet;
+
+    for (; count >= 8; count -= 8) {
+        in = _mm_loadu_si128((__m128i *) input);
+        lo = _mm_mullo_epi16(in, vscale);
+        hi = _mm_mulhi_epi16(in, vscale);
+        wet = _mm_packs_epi32(_mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15),
+                              _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15));
+        _mm_storeu_si128((__m128i *) output,
+                         _mm_adds_epi16(_mm_loadu_si128((__m128i *) output), wet));
+        input += 8;
+        output += 8;
+    }
+#elif defined(__MMX__)
+    __m64 vscale = _mm_set1_pi16((short) scale);
+    __m64 in, lo, hi, wet;
+
+    for (; count >= 4; count -= 4) {
+        in = *(__m64 *) input;
+        lo = _mm_mullo_pi16(in, vscale);
+        hi = _mm_mulhi_pi16(in, vscale);
+        wet = _mm_packs_pi32(_mm_srai_pi32(_mm_unpacklo_pi16(lo, hi), 15),
+                             _mm_srai_pi32(_mm_unpackhi_pi16(lo, hi), 15));
+        *(__m64 *) output = _mm_adds_pi16(*(__m64 *) output, wet);
+        input += 4;
+        output += 4;
+    }
+    _mm_empty();
 #endif
-        
-        sample0l = ((short *) volume)[sample0l] >> 8;
-        sample0h = ((short *) volume)[sample0h];
-        *output = (short) (sample0l + sample0h + 128);
-        
+
+    for (; count > 0; count--) {
+        sample0 = *output + ((*input * scale) >> 15);
+        if (sample0 < -32768) sample0 = -32768;
+        else if (sample0 > 32767) sample0 = 32767;
+        *output = (short) sample0;
+
         input++;
         output++;
-    } while (--count > 0);
+    }
 }
 
-void MV_8BitReverb( signed char *src, signed char *dest, VOLUME16 *volume, unsigned int count )
+void MV_8BitReverbMix( char *src, char *dest, int scale, unsigned int count )
 {
     unsigned char * input = (unsigned char *) src;
     unsigned char * output = (unsigned char *) dest;
-    
-    do {
-        *output = ((short *) volume)[*input] + 128;
-        
-        input++;
-        output++;
-    } while (--count > 0);
-}
+    int sample0;
+
+    for (; count > 0; count--) {
+        sample0 = *output + (((*input - 128) * scale) >> 15);
+        if (sample0 < 0) sample0 = 0;
+        else if (sample0 > 255) sample0 = 255;
+        *output = (unsigned char) sample0;
 
-void MV_16BitReverbFast( char *src, char *dest, unsigned int count, int shift )
-{
-    short * input = (short *) src;
-    short * output = (short *) dest;
-    
-    do {
-        *output = *input >> shift;
-        
         input++;
         output++;
-    } while (--count > 0);
-}
-
-void MV_8BitReverbFast( signed char *src, signed char *dest, unsigned int count, int shift )
-{
-    unsigned char sample0, c;
-    
-    c = 128 - (128 >> shift);
-    
-    do {
-        sample0 = *((unsigned char *) src) >> shift;
-        *dest = sample0 + c + ((sample0 ^ 128) >> 7);
-        
-        src++;
-        dest++;
-    } while (--count > 0);
+    }
 }
-
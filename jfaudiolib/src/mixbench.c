@@ -0,0 +1,486 @@
+/*
+ This file is part of VibeDuke3D, the Duke Nukem 3D port for the Xbox, and
+ is distributed under the same licence as the rest of jfaudiolib.
+
+ This program is free software; you can redistribute it and/or
+ modify it under the terms of the GNU General Public License
+ as published by the Free Software Foundation; either version 2
+ of the License, or (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+ See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+ */
+
+/**
+ * Offline mixer benchmark. Drives MultiVoc through the "no sound" driver
+ * as fast as the mixer can go, optionally writing the result to a WAV
+ * file, and reports throughput and per-buffer mix latency.
+ *
+ * Build alongside the library sources, eg.
+ *   cc -O2 -Iinclude -Isrc -o mixbench src/mixbench.c src/fx_man.c \
+ *      src/multivoc.c src/mix.c src/mixst.c src/pitch.c src/drivers.c \
+ *      src/driver_nosound.c src/asssys.c
+ * (add -DHAVE_VORBIS and src/vorbis.c to benchmark OGG music)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#include "fx_man.h"
+#include "drivers.h"
+#include "driver_nosound.h"
+
+#define MAXBENCHVOICES 64
+#define MAXFORMATS 8
+
+#define bound(l,n,u) ((n) < (l) ? (l) : ((n) > (u) ? (u) : (n)))
+
+enum {
+    FMT_VOC8M,
+    FMT_WAV8M,
+    FMT_WAV16M,
+    FMT_WAV8S,
+    FMT_WAV16S,
+};
+
+static const struct {
+    const char *name;
+    int voc, bits, channels;
+} formatnames[] = {
+    { "voc",  1, 8,  1 },
+    { "8m",   0, 8,  1 },
+    { "16m",  0, 16, 1 },
+    { "8s",   0, 8,  2 },
+    { "16s",  0, 16, 2 },
+};
+
+typedef struct {
+    char *data;
+    int length;
+} benchsound;
+
+static benchsound sounds[MAXFORMATS];
+static int formats[MAXFORMATS];
+static int numformats = 0;
+
+static int voicehandle[MAXBENCHVOICES];
+static volatile int voicedone[MAXBENCHVOICES];
+static int retriggers = 0;
+
+static double gettime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static void put16(char *p, unsigned v)
+{
+    p[0] = v & 255; p[1] = (v >> 8) & 255;
+}
+
+static void put32(char *p, unsigned v)
+{
+    put16(p, v & 65535); put16(p + 2, v >> 16);
+}
+
+/**
+ * Synthesises a decaying tone in the requested container and format so
+ * the benchmark exercises the same header parsing and mix paths as game data.
+ */
+static int makesound(benchsound *snd, int fmt, int rate, int samples, double freq)
+{
+    int bits = formatnames[fmt].bits, channels = formatnames[fmt].channels;
+    int datalen = samples * channels * (bits / 8);
+    int hdrlen = formatnames[fmt].voc ? (0x1a + 6) : 44;
+    int i, c;
+    char *p;
+
+    snd->length = hdrlen + datalen + (formatnames[fmt].voc ? 5 : 0);
+    snd->data = (char *) malloc(snd->length);
+    if (!snd->data) {
+        return -1;
+    }
+
+    p = snd->data;
+    if (formatnames[fmt].voc) {
+        memcpy(p, "Creative Voice File\x1a", 20);
+        put16(p + 0x14, 0x1a);
+        put16(p + 0x16, 0x010a);
+        put16(p + 0x18, ~0x010a + 0x1234);
+        p += 0x1a;
+        p[0] = 1;   // sound data block
+        put32(p + 1, datalen + 2);  // top byte overwritten by time constant
+        p[4] = (char)(256 - 1000000 / rate);
+        p[5] = 0;   // 8-bit unpacked
+        p += 6;
+    } else {
+        memcpy(p, "RIFF", 4); put32(p + 4, 36 + datalen);
+        memcpy(p + 8, "WAVEfmt ", 8); put32(p + 16, 16);
+        put16(p + 20, 1); put16(p + 22, channels);
+        put32(p + 24, rate); put32(p + 28, rate * channels * (bits / 8));
+        put16(p + 32, channels * (bits / 8)); put16(p + 34, bits);
+        memcpy(p + 36, "data", 4); put32(p + 40, datalen);
+        p += 44;
+    }
+
+    for (i = 0; i < samples; i++) {
+        double env = 1.0 - (double)i / samples;
+        for (c = 0; c < channels; c++) {
+            double v = sin(2.0 * 3.14159265 * freq * (c + 1) * i / rate) * env * 0.8;
+            if (bits == 8) {
+                *(p++) = (char)(128 + (int)(v * 127));
+            } else {
+                put16(p, (unsigned)(int)(v * 32767) & 65535);
+                p += 2;
+            }
+        }
+    }
+
+    if (formatnames[fmt].voc) {
+        memset(p, 0, 5);    // terminator block, padded for the 32-bit header read
+    }
+
+    return 0;
+}
+
+static int startvoice(int v)
+{
+    const benchsound *snd = &sounds[formats[v % numformats]];
+    int pitch = ((v * 37) % 9 - 4) * 128;   // spread voices across resampling rates
+
+    voicedone[v] = 0;
+    voicehandle[v] = FX_PlayAuto3D(snd->data, snd->length, pitch,
+                                   (v * 5) & 31, (v * 3) & 63, 1, v);
+    return voicehandle[v];
+}
+
+static void voicecallback(unsigned int val)
+{
+    if (val < MAXBENCHVOICES) {
+        voicedone[val] = 1;
+    }
+}
+
+static int cmpdouble(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static int parseformats(const char *list)
+{
+    char tok[8];
+    int i, n;
+
+    numformats = 0;
+    while (*list && numformats < MAXFORMATS) {
+        for (n = 0; list[n] && list[n] != ',' && n < (int)sizeof(tok) - 1; n++) {
+            tok[n] = list[n];
+        }
+        tok[n] = 0;
+        list += n;
+        if (*list == ',') list++;
+
+        for (i = 0; i < (int)(sizeof(formatnames) / sizeof(formatnames[0])); i++) {
+            if (!strcmp(tok, formatnames[i].name)) {
+                formats[numformats++] = i;
+                break;
+            }
+        }
+        if (i == (int)(sizeof(formatnames) / sizeof(formatnames[0]))) {
+            fprintf(stderr, "Unknown format '%s'\n", tok);
+            return -1;
+        }
+    }
+    return numformats > 0 ? 0 : -1;
+}
+
+static char *loadfile(const char *fn, int *length)
+{
+    FILE *fp;
+    char *data;
+
+    fp = fopen(fn, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    *length = (int)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = (char *) malloc(*length);
+    if (data && fread(data, *length, 1, fp) != 1) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+static void writewavheader(FILE *fp, int rate, int channels, int bits, int datalen)
+{
+    char hdr[44];
+
+    memcpy(hdr, "RIFF", 4); put32(hdr + 4, 36 + datalen);
+    memcpy(hdr + 8, "WAVEfmt ", 8); put32(hdr + 16, 16);
+    put16(hdr + 20, 1); put16(hdr + 22, channels);
+    put32(hdr + 24, rate); put32(hdr + 28, rate * channels * (bits / 8));
+    put16(hdr + 32, channels * (bits / 8)); put16(hdr + 34, bits);
+    memcpy(hdr + 36, "data", 4); put32(hdr + 40, datalen);
+
+    fseek(fp, 0, SEEK_SET);
+    fwrite(hdr, sizeof(hdr), 1, fp);
+}
+
+int main(int argc, char ** argv)
+{
+    int NumVoices = 8;
+    int NumChannels = 2;
+    int NumBits = 16;
+    int MixRate = 44100;
+    int seconds = 60;
+    int panevery = 1, panbatch = 0;
+    int panhandle[MAXBENCHVOICES], panangle[MAXBENCHVOICES], pandist[MAXBENCHVOICES];
+    int numpan;
+    int reverb = 0, fastreverb = 0, reverbdelay = 0;
+    int music = 0;
+    const char *musicfile = NULL;
+    const char *outfile = NULL;
+    const char *formatlist = "voc,8m,16m,16s";
+
+    FILE *outfp = NULL;
+    char *musicdata = NULL;
+    int musiclength = 0;
+    int musicvoice = -1;
+    double *timings, t0, t1, total;
+    int arg, v, i, status;
+    int numbuffers, buffer, bufsize = 0, written = 0, framesize;
+    char *mixed;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (argv[arg][0] != '-') continue;
+        switch (argv[arg][1]) {
+            case 'h':
+                puts("mixbench [options]");
+                puts("");
+                puts("-h       This text.");
+                puts("-vn      Play 'n' simultaneous voices (default 8)");
+                puts("-fa,b,.. Voice formats, cycled across voices: voc 8m 16m 8s 16s");
+                puts("-cn      Set 'n' output channels (1 or 2)");
+                puts("-bn      Set 'n' output bits-per-sample (8 or 16)");
+                puts("-sx      Set 'x' output sample rate (8000 to 48000)");
+                puts("-tn      Render 'n' seconds of audio (default 60)");
+                puts("-pn      Pan3D every voice each 'n' buffers (0 = never)");
+                puts("-Pn      As -p, but submit the voices as one Pan3DBatch");
+                puts("-rn      Reverb level 'n' (table reverb, 0 = off)");
+                puts("-Rn      Fast reverb shift 'n' (0 = off)");
+                puts("-dn      Reverb delay 'n' samples");
+                puts("-m[file] Play music: a looped WAV/OGG file, or synthesised");
+                puts("-ofile   Write the output to a WAV file");
+                return 0;
+            case 'v': NumVoices = atoi(argv[arg] + 2); break;
+            case 'f': formatlist = argv[arg] + 2; break;
+            case 'c': NumChannels = atoi(argv[arg] + 2); break;
+            case 'b': NumBits = atoi(argv[arg] + 2); break;
+            case 's': MixRate = atoi(argv[arg] + 2); break;
+            case 't': seconds = atoi(argv[arg] + 2); break;
+            case 'p': panevery = atoi(argv[arg] + 2); panbatch = 0; break;
+            case 'P': panevery = atoi(argv[arg] + 2); panbatch = 1; break;
+            case 'r': reverb = atoi(argv[arg] + 2); break;
+            case 'R': fastreverb = atoi(argv[arg] + 2); break;
+            case 'd': reverbdelay = atoi(argv[arg] + 2); break;
+            case 'm':
+                music = 1;
+                if (argv[arg][2]) musicfile = argv[arg] + 2;
+                break;
+            case 'o': outfile = argv[arg] + 2; break;
+        }
+    }
+
+    NumVoices = bound(1, NumVoices, MAXBENCHVOICES);
+    NumChannels = bound(1, NumChannels, 2);
+    NumBits = bound(1, (NumBits >> 3), 2) << 3;
+    MixRate = bound(8000, MixRate, 48000);
+    seconds = bound(1, seconds, 3600);
+
+    if (parseformats(formatlist)) {
+        return 1;
+    }
+
+    // one extra voice for the music
+    status = FX_Init(ASS_NoSound, NumVoices + 1, &NumChannels, &NumBits, &MixRate, NULL);
+    if (status != FX_Ok) {
+        fprintf(stderr, "FX_Init error %s\n", FX_ErrorString(status));
+        return 1;
+    }
+    FX_SetCallBack(voicecallback);
+
+    if (reverb > 0) {
+        FX_SetReverb(reverb);
+    } else if (fastreverb > 0) {
+        FX_SetFastReverb(fastreverb);
+    }
+    if (reverbdelay > 0) {
+        FX_SetReverbDelay(reverbdelay);
+    }
+
+    for (i = 0; i < numformats; i++) {
+        if (makesound(&sounds[i], formats[i], 11025 * (1 + (i & 1)), 11025 + i * 2000, 220.0 * (i + 1))) {
+            fprintf(stderr, "Out of memory\n");
+            FX_Shutdown();
+            return 1;
+        }
+        formats[i] = i;     // sounds[] is now indexed by slot
+    }
+
+    if (music) {
+        if (musicfile) {
+            musicdata = loadfile(musicfile, &musiclength);
+            if (!musicdata) {
+                fprintf(stderr, "Error opening %s\n", musicfile);
+            }
+        } else {
+            benchsound tmp;
+            if (!makesound(&tmp, FMT_WAV16S, 22050, 22050 * 4, 110.0)) {
+                musicdata = tmp.data;
+                musiclength = tmp.length;
+            }
+        }
+        if (musicdata) {
+            musicvoice = FX_PlayLoopedAuto(musicdata, musiclength, 0, -1, 0,
+                255, 255, 255, FX_MUSIC_PRIORITY, MAXBENCHVOICES);
+            if (musicvoice < FX_Ok) {
+                fprintf(stderr, "Error playing music: %s\n", FX_ErrorString(FX_ErrorCode));
+            }
+        }
+    }
+
+    for (v = 0; v < NumVoices; v++) {
+        startvoice(v);
+    }
+
+    if (outfile) {
+        outfp = fopen(outfile, "wb");
+        if (!outfp) {
+            fprintf(stderr, "Error opening %s\n", outfile);
+        } else {
+            writewavheader(outfp, MixRate, NumChannels, NumBits, 0);
+        }
+    }
+
+    framesize = NumChannels * (NumBits / 8);
+    NoSoundDrv_PCM_Pump(&bufsize);
+    if (bufsize <= 0) {
+        fprintf(stderr, "The driver did not mix a buffer\n");
+        if (outfp) fclose(outfp);
+        FX_Shutdown();
+        return 1;
+    }
+    numbuffers = (int)(((double)seconds * MixRate * framesize) / bufsize);
+    timings = (double *) malloc(sizeof(double) * numbuffers);
+    if (!timings) {
+        fprintf(stderr, "Out of memory\n");
+        FX_Shutdown();
+        return 1;
+    }
+
+    total = 0.0;
+    for (buffer = 0; buffer < numbuffers; buffer++) {
+        // game-side work between mixes: retrigger finished voices, move emitters
+        numpan = 0;
+        for (v = 0; v < NumVoices; v++) {
+            if (voicedone[v]) {
+                startvoice(v);
+                retriggers++;
+            } else if (panevery > 0 && (buffer % panevery) == 0) {
+                panhandle[numpan] = voicehandle[v];
+                panangle[numpan] = (v * 5 + buffer / 8) & 31;
+                pandist[numpan] = (v * 3 + buffer / 4) & 63;
+                if (!panbatch) {
+                    FX_Pan3D(panhandle[numpan], panangle[numpan], pandist[numpan]);
+                } else {
+                    numpan++;
+                }
+            }
+        }
+        if (numpan > 0) {
+            FX_Pan3DBatch(panhandle, panangle, pandist, numpan);
+        }
+
+        t0 = gettime();
+        mixed = NoSoundDrv_PCM_Pump(&bufsize);
+        t1 = gettime();
+
+        timings[buffer] = t1 - t0;
+        total += t1 - t0;
+
+        if (outfp && mixed) {
+            written += (int)fwrite(mixed, 1, bufsize, outfp);
+        }
+    }
+
+    if (outfp) {
+        writewavheader(outfp, MixRate, NumChannels, NumBits, written);
+        fclose(outfp);
+    }
+
+    qsort(timings, numbuffers, sizeof(double), cmpdouble);
+
+    {
+        double frames = (double)numbuffers * bufsize / framesize;
+
+        printf("Format        %dHz %d-bit %d-channel, %d voices (%s)%s\n",
+               MixRate, NumBits, NumChannels, NumVoices, formatlist,
+               musicvoice >= FX_Ok ? " + music" : "");
+        printf("Reverb        %s\n", reverb > 0 ? "table" : (fastreverb > 0 ? "fast" : "off"));
+        printf("Rendered      %d buffers of %d bytes, %.1f seconds of audio\n",
+               numbuffers, bufsize, frames / MixRate);
+        printf("Mix time      %.3f ms total, %.1fx realtime\n",
+               total * 1000.0, total > 0.0 ? (frames / MixRate) / total : 0.0);
+        printf("Throughput    %.0f samples/s\n", total > 0.0 ? frames / total : 0.0);
+        printf("Per buffer    p50 %.2fus  p90 %.2fus  p99 %.2fus  max %.2fus\n",
+               timings[numbuffers * 50 / 100] * 1e6,
+               timings[numbuffers * 90 / 100] * 1e6,
+               timings[numbuffers * 99 / 100] * 1e6,
+               timings[numbuffers - 1] * 1e6);
+        printf("Retriggers    %d\n", retriggers);
+    }
+
+    free(timings);
+    FX_Shutdown();
+
+    for (i = 0; i < numformats; i++) {
+        free(sounds[i].data);
+    }
+    free(musicdata);
+
+    return 0;
+}
+
+/*
+ * vim:ts=4:
+ */
@@ -53,7 +53,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 static int       MV_ReverbLevel;
 static int       MV_ReverbDelay;
-static VOLUME16 *MV_ReverbTable = NULL;
+static int       MV_ReverbFast;
+static char     *MV_ReverbBuffer = NULL;
+static unsigned int MV_ReverbPosition;
 
 //static signed short MV_VolumeTable[ MV_MaxVolume + 1 ][ 256 ];
 static signed short MV_VolumeTable[ 63 + 1 ][ 256 ];
@@ -245,7 +247,10 @@ static void MV_Mix
    MV_LeftVolume        = voice->LeftVolume;
    MV_RightVolume       = voice->RightVolume;
 
-   if ( ( MV_Channels == 2 ) && ( IS_QUIET( MV_LeftVolume ) ) )
+   // Stereo sources always mix both channels (see MV_SetVoiceMixMode),
+   // so only mono sources may skip the silent left channel.
+   if ( ( MV_Channels == 2 ) && ( voice->channels == 1 ) &&
+      ( IS_QUIET( MV_LeftVolume ) ) )
       {
       MV_LeftVolume      = MV_RightVolume;
       MV_MixDestination += MV_RightChannelOffset;
@@ -356,67 +361,97 @@ static void MV_StopVoice
 
 
 /*---------------------------------------------------------------------
-   Function: MV_ServiceVoc
-
-   Starts playback of the waiting buffer and mixes the next one.
-
-   JBF: no synchronisation happens inside MV_ServiceVoc nor the
-        supporting functions it calls. This would cause a deadlock
-        between the mixer thread in the driver vs the nested
-        locking in the user-space functions of MultiVoc. The call
-        to MV_ServiceVoc is synchronised in the driver.
+   Function: MV_MixVoiceList
 
-        Known functions called by MV_ServiceVoc and its helpers:
-           MV_Mix (and its MV_Mix*bit* workers)
-           MV_GetNextVOCBlock
-           MV_GetNextWAVBlock
-           MV_SetVoiceMixMode
+   Mixes either the effect voices or the music voices into the current
+   page, retiring any voices that finish.
 ---------------------------------------------------------------------*/
-static void MV_ServiceVoc
+
+static void MV_MixVoiceList
    (
-   void
+   int music
    )
 
    {
    VoiceNode *voice;
    VoiceNode *next;
-   //int        flags;
 
-   // Toggle which buffer we'll mix next
-   MV_MixPage++;
-   if ( MV_MixPage >= MV_NumberOfBuffers )
+   for( voice = VoiceList.next; voice != &VoiceList; voice = next )
       {
-      MV_MixPage -= MV_NumberOfBuffers;
-      }
+      next = voice->next;
 
-   if ( MV_ReverbLevel == 0 )
-      {
-      // Initialize buffer
-      //Commented out so that the buffer is always cleared.
-      //This is so the guys at Echo Speech can mix into the
-      //buffer even when no sounds are playing.
-      //if ( !MV_BufferEmpty[ MV_MixPage ] )
+      if ( voice->Paused ||
+         ( ( voice->priority == MV_MUSIC_PRIORITY ) != music ) )
          {
-         ClearBuffer_DW( MV_MixBuffer[ MV_MixPage ], MV_Silence, MV_BufferSize >> 2 );
-         MV_BufferEmpty[ MV_MixPage ] = TRUE;
+         continue;
+         }
+
+      MV_BufferEmpty[ MV_MixPage ] = FALSE;
+
+      MV_MixFunction( voice, MV_MixPage );
+
+      next = voice->next;
+
+      // Is this voice done?
+      if ( !voice->Playing )
+         {
+         //JBF: prevent a deadlock caused by MV_StopVoice grabbing the mutex again
+         //MV_StopVoice( voice );
+         LL_Remove( voice, next, prev );
+         LL_Add( (VoiceNode*) &VoicePool, voice, next, prev );
+
+         if ( MV_CallBackFunc )
+            {
+            MV_CallBackFunc( voice->callbackval );
+            }
          }
       }
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: MV_ApplyReverb
+
+   Feeds the effects bus held in the current page through the reverb
+   delay line.  The delay line is separate from the output ring so the
+   music voices, which are mixed afterwards, stay dry.  The cost is one
+   pass over a single buffer regardless of how many voices are playing.
+---------------------------------------------------------------------*/
+
+static void MV_ApplyReverb
+   (
+   void
+   )
+
+   {
+   char *end;
+   char *source;
+   char *dest;
+   unsigned int count;
+   unsigned int length;
+   int   scale;
+
+   if ( MV_ReverbFast )
+      {
+      scale = 32768 >> MV_ReverbLevel;
+      }
    else
       {
-      char *end;
-      char *source;
-      char *dest;
-      unsigned int   count;
-      unsigned int   length;
+      // matches the gain MV_CreateVolumeTable gives MV_VolumeTable[ MV_ReverbLevel ]
+      scale = ( ( MV_ReverbLevel * MV_TotalVolume ) / MV_MaxTotalVolume << 15 ) / MV_MaxVolume;
+      }
+   scale = min( scale, 32767 );
 
-      end = MV_MixBuffer[ 0 ] + MV_BufferLength;;
-      dest = MV_MixBuffer[ MV_MixPage ];
-      source = MV_MixBuffer[ MV_MixPage ] - MV_ReverbDelay;
-      if ( source < MV_MixBuffer[ 0 ] )
-         {
-         source += MV_BufferLength;
-         }
+   end    = MV_ReverbBuffer + MV_BufferLength;
+   dest   = MV_MixBuffer[ MV_MixPage ];
+   source = MV_ReverbBuffer + MV_ReverbPosition - MV_ReverbDelay;
+   if ( source < MV_ReverbBuffer )
+      {
+      source += MV_BufferLength;
+      }
 
+   if ( scale > 0 )
+      {
       length = MV_BufferSize;
       while( length > 0 )
          {
@@ -428,34 +463,70 @@ static void MV_ServiceVoc
 
          if ( MV_Bits == 16 )
             {
-            if ( MV_ReverbTable != NULL )
-               {
-               MV_16BitReverb( source, dest, MV_ReverbTable, count / 2 );
-               }
-            else
-               {
-               MV_16BitReverbFast( source, dest, count / 2, MV_ReverbLevel );
-               }
+            MV_16BitReverbMix( source, dest, scale, count / 2 );
             }
          else
             {
-            if ( MV_ReverbTable != NULL )
-               {
-               MV_8BitReverb( (signed char *) source, (signed char *) dest, MV_ReverbTable, count );
-               }
-            else
-               {
-               MV_8BitReverbFast( (signed char *) source, (signed char *) dest, count, MV_ReverbLevel );
-               }
+            MV_8BitReverbMix( source, dest, scale, count );
             }
 
          // if we go through the loop again, it means that we've wrapped around the buffer
-         source  = MV_MixBuffer[ 0 ];
+         source  = MV_ReverbBuffer;
          dest   += count;
          length -= count;
          }
       }
 
+   // The wet bus feeds back into the delay line
+   memcpy( MV_ReverbBuffer + MV_ReverbPosition, MV_MixBuffer[ MV_MixPage ], MV_BufferSize );
+   MV_ReverbPosition += MV_BufferSize;
+   if ( MV_ReverbPosition >= MV_BufferLength )
+      {
+      MV_ReverbPosition = 0;
+      }
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: MV_ServiceVoc
+
+   Starts playback of the waiting buffer and mixes the next one.
+
+   JBF: no synchronisation happens inside MV_ServiceVoc nor the
+        supporting functions it calls. This would cause a deadlock
+        between the mixer thread in the driver vs the nested
+        locking in the user-space functions of MultiVoc. The call
+        to MV_ServiceVoc is synchronised in the driver.
+
+        Known functions called by MV_ServiceVoc and its helpers:
+           MV_Mix (and its MV_Mix*bit* workers)
+           MV_GetNextVOCBlock
+           MV_GetNextWAVBlock
+           MV_SetVoiceMixMode
+---------------------------------------------------------------------*/
+static void MV_ServiceVoc
+   (
+   void
+   )
+
+   {
+   // Toggle which buffer we'll mix next
+   MV_MixPage++;
+   if ( MV_MixPage >= MV_NumberOfBuffers )
+      {
+      MV_MixPage -= MV_NumberOfBuffers;
+      }
+
+   // Initialize buffer
+   //Commented out so that the buffer is always cleared.
+   //This is so the guys at Echo Speech can mix into the
+   //buffer even when no sounds are playing.
+   //if ( !MV_BufferEmpty[ MV_MixPage ] )
+      {
+      ClearBuffer_DW( MV_MixBuffer[ MV_MixPage ], MV_Silence, MV_BufferSize >> 2 );
+      MV_BufferEmpty[ MV_MixPage ] = TRUE;
+      }
+
    // Play any waiting voices
    //flags = DisableInterrupts();
 
@@ -472,35 +543,16 @@ static void MV_ServiceVoc
    }
 #endif
 
-   for( voice = VoiceList.next; voice != &VoiceList; voice = next )
-      {
-      if ( voice->Paused )
-         {
-         next = voice->next;
-         continue;
-         }
-
-      MV_BufferEmpty[ MV_MixPage ] = FALSE;
-
-      MV_MixFunction( voice, MV_MixPage );
-
-      next = voice->next;
-
-      // Is this voice done?
-      if ( !voice->Playing )
-         {
-         //JBF: prevent a deadlock caused by MV_StopVoice grabbing the mutex again
-         //MV_StopVoice( voice );
-         LL_Remove( voice, next, prev );
-         LL_Add( (VoiceNode*) &VoicePool, voice, next, prev );
+   // Sound effects make up the reverb send, music is mixed in dry after it
+   MV_MixVoiceList( FALSE );
 
-         if ( MV_CallBackFunc )
-            {
-            MV_CallBackFunc( voice->callbackval );
-            }
-         }
+   if ( MV_ReverbLevel != 0 )
+      {
+      MV_ApplyReverb();
       }
 
+   MV_MixVoiceList( TRUE );
+
    //RestoreInterrupts(flags);
    }
 
@@ -1803,6 +1855,93 @@ int MV_Pan3D
    }
 
 
+/*---------------------------------------------------------------------
+   Function: MV_Pan3DBatch
+
+   Sets the angle and distance from the listener of several voices at
+   once.  The voice list is locked once for the whole batch rather than
+   once per voice, and the volumes change together within one buffer.
+---------------------------------------------------------------------*/
+
+int MV_Pan3DBatch
+   (
+   int *handles,
+   int *angles,
+   int *distances,
+   int  count
+   )
+
+   {
+   VoiceNode *voice;
+   int index;
+   int angle;
+   int distance;
+   int volume;
+   int status;
+   int flags;
+
+   if ( !MV_Installed )
+      {
+      MV_SetErrorCode( MV_NotInstalled );
+      return( MV_Error );
+      }
+
+   status = MV_Ok;
+
+   flags = DisableInterrupts();
+
+   for( index = 0; index < count; index++ )
+      {
+      voice = MV_GetVoice( handles[ index ] );
+      if ( voice == NULL )
+         {
+         status = MV_Warning;
+         continue;
+         }
+
+      angle    = angles[ index ];
+      distance = distances[ index ];
+      if ( distance < 0 )
+         {
+         distance  = -distance;
+         angle    += MV_NumPanPositions / 2;
+         }
+
+      volume = MIX_VOLUME( distance );
+      angle &= MV_MaxPanPosition;
+
+      MV_SetVoiceVolume( voice, max( 0, 255 - distance ),
+         MV_PanTable[ angle ][ volume ].left,
+         MV_PanTable[ angle ][ volume ].right );
+      }
+
+   RestoreInterrupts( flags );
+
+   return( status );
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: MV_ClearReverb
+
+   Silences the reverb delay line so stale effects from the last time
+   reverb was enabled aren't heard again.
+---------------------------------------------------------------------*/
+
+static void MV_ClearReverb
+   (
+   void
+   )
+
+   {
+   if ( MV_ReverbBuffer )
+      {
+      ClearBuffer_DW( MV_ReverbBuffer, MV_Silence, TotalBufferSize >> 2 );
+      }
+   MV_ReverbPosition = 0;
+   }
+
+
 /*---------------------------------------------------------------------
    Function: MV_SetReverb
 
@@ -1815,8 +1954,16 @@ void MV_SetReverb
    )
 
    {
+   int flags;
+
+   flags = DisableInterrupts();
+   if ( MV_ReverbLevel == 0 )
+      {
+      MV_ClearReverb();
+      }
    MV_ReverbLevel = MIX_VOLUME( reverb );
-   MV_ReverbTable = &MV_VolumeTable[ MV_ReverbLevel ];
+   MV_ReverbFast  = FALSE;
+   RestoreInterrupts( flags );
    }
 
 
@@ -1832,8 +1979,16 @@ void MV_SetFastReverb
    )
 
    {
+   int flags;
+
+   flags = DisableInterrupts();
+   if ( MV_ReverbLevel == 0 )
+      {
+      MV_ClearReverb();
+      }
    MV_ReverbLevel = max( 0, min( 16, reverb ) );
-   MV_ReverbTable = NULL;
+   MV_ReverbFast  = TRUE;
+   RestoreInterrupts( flags );
    }
 
 
@@ -1979,6 +2134,7 @@ int MV_StartPlayback
 
    // Initialize the buffers
    ClearBuffer_DW( MV_MixBuffer[ 0 ], MV_Silence, TotalBufferSize >> 2 );
+   MV_ClearReverb();
    for( buffer = 0; buffer < MV_NumberOfBuffers; buffer++ )
       {
       MV_BufferEmpty[ buffer ] = TRUE;
@@ -2238,6 +2394,153 @@ int MV_PlayLoopedRaw
    }
 
 
+/*---------------------------------------------------------------------
+   Function: MV_PlayLoopedPCM
+
+   Begin playback of flat interleaved PCM (as produced by
+   MV_DecodeSound) with the given sound levels and priority.
+   Length and loop points are in sample frames; a loopend of -1
+   loops to the end of the sound.
+---------------------------------------------------------------------*/
+
+int MV_PlayLoopedPCM
+   (
+   char *ptr,
+   unsigned int length,
+   int   loopstart,
+   int   loopend,
+   unsigned rate,
+   int   bits,
+   int   channels,
+   int   pitchoffset,
+   int   vol,
+   int   left,
+   int   right,
+   int   priority,
+   unsigned int callbackval
+   )
+
+   {
+   VoiceNode *voice;
+   int framesize;
+
+   if ( !MV_Installed )
+      {
+      MV_SetErrorCode( MV_NotInstalled );
+      return( MV_Error );
+      }
+
+   if ( ( bits != 8 && bits != 16 ) || ( channels != 1 && channels != 2 ) )
+      {
+      MV_SetErrorCode( MV_InvalidMixMode );
+      return( MV_Error );
+      }
+
+   // Request a voice from the voice pool
+   voice = MV_AllocVoice( priority );
+   if ( voice == NULL )
+      {
+      MV_SetErrorCode( MV_NoVoices );
+      return( MV_Error );
+      }
+
+   framesize = channels * bits / 8;
+
+   voice->wavetype    = Raw;
+   voice->bits        = bits;
+   voice->channels    = channels;
+   voice->GetSound    = MV_GetNextRawBlock;
+   voice->Playing     = TRUE;
+   voice->Paused      = FALSE;
+   voice->DemandFeed  = NULL;
+   voice->NextBlock   = ptr;
+   voice->position    = 0;
+   voice->BlockLength = length;
+   voice->length      = 0;
+   voice->next        = NULL;
+   voice->prev        = NULL;
+   voice->priority    = priority;
+   voice->callbackval = callbackval;
+   voice->LoopCount   = 0;
+   voice->LoopStart   = NULL;
+   voice->LoopEnd     = NULL;
+   voice->LoopSize    = 0;
+
+   if ( ( loopstart >= 0 ) && ( (unsigned int)loopstart < length ) )
+      {
+      if ( ( loopend < loopstart ) || ( (unsigned int)loopend >= length ) )
+         {
+         loopend = length - 1;
+         }
+      voice->LoopStart = ptr + loopstart * framesize;
+      voice->LoopEnd   = ptr + loopend * framesize;
+      voice->LoopSize  = loopend - loopstart + 1;
+      }
+
+   MV_SetVoicePitch( voice, rate, pitchoffset );
+   MV_SetVoiceVolume( voice, vol, left, right );
+   MV_PlayVoice( voice );
+
+   return( voice->handle );
+   }
+
+
+/*---------------------------------------------------------------------
+   Function: MV_PlayPCM3D
+
+   Begin playback of flat interleaved PCM at specified angle and
+   distance from listener.
+---------------------------------------------------------------------*/
+
+int MV_PlayPCM3D
+   (
+   char *ptr,
+   unsigned int length,
+   unsigned rate,
+   int  bits,
+   int  channels,
+   int  pitchoffset,
+   int  angle,
+   int  distance,
+   int  priority,
+   unsigned int callbackval
+   )
+
+   {
+   int left;
+   int right;
+   int mid;
+   int volume;
+   int status;
+
+   if ( !MV_Installed )
+      {
+      MV_SetErrorCode( MV_NotInstalled );
+      return( MV_Error );
+      }
+
+   if ( distance < 0 )
+      {
+      distance  = -distance;
+      angle    += MV_NumPanPositions / 2;
+      }
+
+   volume = MIX_VOLUME( distance );
+
+   // Ensure angle is within 0 - 31
+   angle &= MV_MaxPanPosition;
+
+   left  = MV_PanTable[ angle ][ volume ].left;
+   right = MV_PanTable[ angle ][ volume ].right;
+   mid   = max( 0, 255 - distance );
+
+   status = MV_PlayLoopedPCM( ptr, length, -1, -1, rate, bits, channels,
+      pitchoffset, mid, left, right, priority, callbackval );
+
+   return( status );
+   }
+
+
 /*---------------------------------------------------------------------
    Function: MV_PlayWAV
 
@@ -2696,6 +2999,245 @@ int MV_PlayLoopedVOC
    }
 
 
+/*---------------------------------------------------------------------
+   Function: MV_DecodeSound
+
+   Parses a VOC or WAV file once and copies its sample data out as
+   flat interleaved PCM (unsigned 8-bit or signed 16-bit, as stored)
+   for MV_PlayLoopedPCM.  Returns the number of bytes of PCM, or
+   MV_Error for files that only the streaming parsers can play:
+   packed VOC data, VOC repeat blocks, or a format change between
+   blocks.  Pass a NULL dest to measure without copying.
+---------------------------------------------------------------------*/
+
+int MV_DecodeSound
+   (
+   char *ptr,
+   unsigned int length,
+   char *dest,
+   unsigned int *rate,
+   int  *bits,
+   int  *channels
+   )
+
+   {
+   unsigned char *p   = (unsigned char *)ptr;
+   unsigned char *end = p + length;
+   unsigned int   blocklength;
+   unsigned int   samplespeed = 0;
+   unsigned int   tc = 0;
+   unsigned int   total = 0;
+   int            capacity = 0;
+   int            blocktype, lastblocktype = 0;
+   int            packtype = VOC_8BIT, voicemode = 0;
+   int            fbits = 0, fchannels = 0;
+   int            bbits, bchannels;
+
+   if ( ( length >= 44 ) && !memcmp( p, "RIFF", 4 ) && !memcmp( p + 8, "WAVE", 4 ) )
+      {
+      riff_header   riff;
+      format_header format;
+      data_header   data;
+
+      memcpy( &riff, p, sizeof( riff_header ) );
+      p += sizeof( riff_header );
+      if ( memcmp( riff.fmt, "fmt ", 4 ) != 0 )
+         {
+         MV_SetErrorCode( MV_InvalidWAVFile );
+         return( MV_Error );
+         }
+
+      memcpy( &format, p, sizeof( format_header ) );
+      if ( LITTLE32( riff.format_size ) > (unsigned int)( end - p ) - sizeof( data_header ) )
+         {
+         MV_SetErrorCode( MV_InvalidWAVFile );
+         return( MV_Error );
+         }
+      p += LITTLE32( riff.format_size );
+      if ( p + sizeof( data_header ) > end )
+         {
+         MV_SetErrorCode( MV_InvalidWAVFile );
+         return( MV_Error );
+         }
+      memcpy( &data, p, sizeof( data_header ) );
+      p += sizeof( data_header );
+
+      *bits     = LITTLE16( format.nBitsPerSample );
+      *channels = LITTLE16( format.nChannels );
+      *rate     = LITTLE32( format.nSamplesPerSec );
+      total     = LITTLE32( data.size );
+
+      if ( ( LITTLE16( format.wFormatTag ) != 1 ) ||
+         ( *channels != 1 && *channels != 2 ) ||
+         ( *bits != 8 && *bits != 16 ) ||
+         ( memcmp( data.DATA, "data", 4 ) != 0 ) )
+         {
+         MV_SetErrorCode( MV_InvalidWAVFile );
+         return( MV_Error );
+         }
+
+      total = min( total, (unsigned int)( end - p ) );
+      total &= ~( ( *channels * *bits / 8 ) - 1 );
+      if ( dest )
+         {
+         memcpy( dest, p, total );
+         }
+      return( (int)total );
+      }
+
+   if ( ( length < 0x1a ) || memcmp( p, "Creative Voice File", 19 ) )
+      {
+      MV_SetErrorCode( MV_InvalidVOCFile );
+      return( MV_Error );
+      }
+
+   // The length returned is trimmed to whole samples, and that is all
+   // the caller will have made room for.
+   if ( dest )
+      {
+      capacity = MV_DecodeSound( ptr, length, NULL, rate, bits, channels );
+      if ( capacity == MV_Error )
+         {
+         return( MV_Error );
+         }
+      }
+
+   if ( LITTLE16( *( unsigned short * )( p + 0x14 ) ) > length )
+      {
+      MV_SetErrorCode( MV_InvalidVOCFile );
+      return( MV_Error );
+      }
+   p += LITTLE16( *( unsigned short * )( p + 0x14 ) );
+
+   while ( p + 4 <= end && *p != 0 )
+      {
+      blocktype   = *p;
+      blocklength = p[ 1 ] | ( p[ 2 ] << 8 ) | ( p[ 3 ] << 16 );
+      p += 4;
+
+      if ( p + blocklength > end )
+         {
+         blocklength = (unsigned int)( end - p );
+         }
+
+      bbits = 0;
+      bchannels = 0;
+
+      switch ( blocktype )
+         {
+         case 1 :
+            // Sound data block
+            if ( blocklength < 2 )
+               {
+               MV_SetErrorCode( MV_InvalidVOCFile );
+               return( MV_Error );
+               }
+            if ( lastblocktype != 8 )
+               {
+               tc = ( unsigned int )*p << 8;
+               packtype = *( p + 1 );
+               }
+            if ( packtype != VOC_8BIT )
+               {
+               MV_SetErrorCode( MV_InvalidVOCFile );
+               return( MV_Error );
+               }
+            bbits = 8;
+            bchannels = voicemode + 1;
+            samplespeed = 256000000L / ( bchannels * ( 65536 - tc ) );
+            p += 2;
+            blocklength -= 2;
+            voicemode = 0;
+            break;
+
+         case 2 :
+            // Sound continuation block
+            bbits = fbits;
+            bchannels = fchannels;
+            break;
+
+         case 3 :
+         case 4 :
+         case 5 :
+            // Silence, marker, ASCII string
+            break;
+
+         case 8 :
+            // Extended block
+            if ( blocklength < 4 )
+               {
+               MV_SetErrorCode( MV_InvalidVOCFile );
+               return( MV_Error );
+               }
+            tc = LITTLE16( *( unsigned short * )p );
+            packtype = *( p + 2 );
+            voicemode = *( p + 3 );
+            break;
+
+         case 9 :
+            // New sound data block
+            if ( blocklength < 12 )
+               {
+               MV_SetErrorCode( MV_InvalidVOCFile );
+               return( MV_Error );
+               }
+            samplespeed = LITTLE32( *( unsigned int * )p );
+            bbits = *( p + 4 );
+            bchannels = *( p + 5 );
+            if ( !( bbits == 8 && LITTLE16( *( unsigned short * )( p + 6 ) ) == VOC_8BIT ) &&
+                 !( bbits == 16 && LITTLE16( *( unsigned short * )( p + 6 ) ) == VOC_16BIT ) )
+               {
+               MV_SetErrorCode( MV_InvalidVOCFile );
+               return( MV_Error );
+               }
+            p += 12;
+            blocklength -= 12;
+            break;
+
+         default :
+            // Repeats and unknown blocks need the streaming parser.
+            MV_SetErrorCode( MV_InvalidVOCFile );
+            return( MV_Error );
+         }
+
+      if ( bbits )
+         {
+         if ( fbits == 0 )
+            {
+            fbits = bbits;
+            fchannels = bchannels;
+            *rate = samplespeed;
+            }
+         else if ( fbits != bbits || fchannels != bchannels || *rate != samplespeed )
+            {
+            MV_SetErrorCode( MV_InvalidVOCFile );
+            return( MV_Error );
+            }
+
+         if ( dest && total < (unsigned int)capacity )
+            {
+            memcpy( dest + total, p, min( blocklength, (unsigned int)capacity - total ) );
+            }
+         total += blocklength;
+         }
+
+      p += blocklength;
+      lastblocktype = blocktype;
+      }
+
+   if ( fbits == 0 || fchannels < 1 || fchannels > 2 )
+      {
+      MV_SetErrorCode( MV_InvalidVOCFile );
+      return( MV_Error );
+      }
+
+   *bits = fbits;
+   *channels = fchannels;
+
+   return( (int)( total & ~( ( fchannels * fbits / 8 ) - 1 ) ) );
+   }
+
+
 /*---------------------------------------------------------------------
    Function: MV_CreateVolumeTable
 
@@ -2932,7 +3474,7 @@ int MV_Init
 
    MV_SetErrorCode( MV_Ok );
 
-   MV_TotalMemory = Voices * sizeof( VoiceNode ) + sizeof( HARSH_CLIP_TABLE_8 ) + TotalBufferSize;
+   MV_TotalMemory = Voices * sizeof( VoiceNode ) + sizeof( HARSH_CLIP_TABLE_8 ) + TotalBufferSize * 2;
    ptr = (char *) malloc( MV_TotalMemory );
    if ( !ptr )
       {
@@ -2948,6 +3490,9 @@ int MV_Init
    MV_HarshClipTable = ptr;
    ptr += sizeof(HARSH_CLIP_TABLE_8);
 
+   MV_ReverbBuffer = ptr;
+   ptr += TotalBufferSize;
+
    // Set number of voices before calculating volume table
    MV_MaxVoices = Voices;
 
@@ -2976,6 +3521,7 @@ int MV_Init
       free( MV_Voices );
       MV_Voices      = NULL;
       MV_HarshClipTable = NULL;
+      MV_ReverbBuffer = NULL;
       MV_TotalMemory = 0;
 
       MV_SetErrorCode( status );
@@ -2987,7 +3533,7 @@ int MV_Init
    MV_RecordFunc   = NULL;
    MV_Recording    = FALSE;
    MV_ReverbLevel  = 0;
-   MV_ReverbTable  = NULL;
+   MV_ReverbFast   = FALSE;
 
    // Set the sampling rate
    MV_RequestedMixRate = *MixRate;
@@ -3062,6 +3608,7 @@ int MV_Shutdown
    // Free any voices we allocated
    free( MV_Voices );
    MV_Voices      = NULL;
+   MV_ReverbBuffer = NULL;
    MV_TotalMemory = 0;
 
    LL_Reset( (VoiceNode*) &VoiceList, next, prev );
@@ -67,6 +67,7 @@ int   MV_GetFrequency( int handle, int *frequency );
 int   MV_EndLooping( int handle );
 int   MV_SetPan( int handle, int vol, int left, int right );
 int   MV_Pan3D( int handle, int angle, int distance );
+int   MV_Pan3DBatch( int *handles, int *angles, int *distances, int count );
 void  MV_SetReverb( int reverb );
 void  MV_SetFastReverb( int reverb );
 int   MV_GetMaxReverbDelay( void );
@@ -87,6 +88,13 @@ int   MV_PlayLoopedRaw( char *ptr, unsigned int length,
          char *loopstart, char *loopend, unsigned rate, int pitchoffset,
          int vol, int left, int right, int priority,
          unsigned int callbackval );
+int   MV_PlayLoopedPCM( char *ptr, unsigned int length, int loopstart, int loopend,
+         unsigned rate, int bits, int channels, int pitchoffset, int vol, int left,
+         int right, int priority, unsigned int callbackval );
+int   MV_PlayPCM3D( char *ptr, unsigned int length, unsigned rate, int bits, int channels,
+         int pitchoffset, int angle, int distance, int priority, unsigned int callbackval );
+int   MV_DecodeSound( char *ptr, unsigned int length, char *dest,
+         unsigned int *rate, int *bits, int *channels );
 int   MV_PlayWAV( char *ptr, unsigned int length, int pitchoffset, int vol, int left,
          int right, int priority, unsigned int callbackval );
 int   MV_PlayWAV3D( char *ptr, unsigned int length, int pitchoffset, int angle, int distance,
@@ -76,6 +76,17 @@ unsigned int getticks(void);
 unsigned int getusecticks(void);
 int gettimerfreq(void);
 
+// threads
+// bthread_create() returns NULL where threads aren't available, in which case
+// the caller should do the work itself or go without.
+void *bthread_create(int (*func)(void *), void *arg, int lowpriority);
+int bthread_wait(void *thread);
+int bthread_cpucount(void);
+void *bmutex_create(void);
+void bmutex_destroy(void *mutex);
+void bmutex_lock(void *mutex);
+void bmutex_unlock(void *mutex);
+
 // If 'strict' is zero and 'fullsc' is zero, only 'bitspp' needs be valid
 // and VIDEOMODE_RELAXED is returned, otherwise the mode matched, or -1 if none.
 #define VIDEOMODE_RELAXED 0x7fffffff
@@ -282,6 +282,7 @@ extern palette_t curpalette[256], curpalettefaded[256], palfadergb;
 extern unsigned char palfadedelta;
 
 extern int dommxoverlay, novoxmips;
+extern int tileprefetch;	// KB of nearby tiles loaded ahead of view each frame, 0 = off
 
 extern int tiletovox[MAXTILES];
 extern int usevoxels, voxscale[MAXVOXELS];
@@ -398,12 +399,15 @@ int    preinitengine(void);	// a partial setup of the engine used for launch win
 int    initengine(void);
 void   uninitengine(void);
 void   initspritelists(void);
+void   initmapaccel(void);
 int   loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *daposz, short *daang, short *dacursectnum);
 int   loadmaphack(char *filename);
 int   saveboard(char *filename, int *daposx, int *daposy, int *daposz, short *daang, short *dacursectnum);
 int   saveoldboard(char *filename, int *daposx, int *daposy, int *daposz, short *daang, short *dacursectnum);
 int   loadpics(char *filename, int askedsize);
 void   loadtile(short tilenume);
+int   precachetiles_begin(void);
+int   precachetiles_run(int *done, int *total);
 int   qloadkvx(int voxindex, char *filename);
 intptr_t allocatepermanenttile(short tilenume, int xsiz, int ysiz);
 void   copytilepiece(int tilenume1, int sx1, int sy1, int xsiz, int ysiz, int tilenume2, int sx2, int sy2);
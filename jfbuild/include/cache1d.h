@@ -38,6 +38,18 @@ int 	kfilelength(int handle);
 int 	ktell(int handle);
 void	kclose(int handle);
 
+// Maps a file opened by kopen4load() into memory read-only, if the file and the
+// platform allow it, returning NULL otherwise. Release with kunmap(*maphandle).
+const void *kmap(int handle, int *length, void **maphandle);
+void	kunmap(void *maphandle);
+
+// kplib keeps its inflate state in globals, so threads decoding images with it
+// take turns with cache1d's zip reads through this lock. kplibinitlock() must be
+// called by the main thread before any other thread uses kplib.
+int	kplibinitlock(void);
+void	kpliblock(void);
+void	kplibunlock(void);
+
 enum {
 	CACHE1D_FIND_FILE = 1,
 	CACHE1D_FIND_DIR = 2,
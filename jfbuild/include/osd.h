@@ -16,6 +16,8 @@ typedef struct {
 #define OSDCMD_OK	0
 #define OSDCMD_SHOWHELP 1
 
+typedef struct osdscript osdscript_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,6 +77,16 @@ void OSD_DispatchQueued(void);
 // executes a string
 int OSD_Dispatch(const char *cmd);
 
+// parses a script of commands separated by lines or semicolons once, for running
+// with OSD_RunScript as often as needed. Returns NULL if any command is undefined.
+osdscript_t *OSD_CompileScript(const char *text);
+
+// executes every command of a compiled script
+int OSD_RunScript(const osdscript_t *script);
+
+// releases a compiled script
+void OSD_FreeScript(osdscript_t *script);
+
 // registers a function
 //   name = name of the function
 //   help = a short help string
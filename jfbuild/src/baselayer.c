@@ -454,6 +454,11 @@ static int osdcmd_vars(const osdfuncparm_t *parm)
 		else { novoxmips = (atoi(parm->parms[0]) != 0); }
 		return OSDCMD_OK;
 	}
+	else if (!Bstrcasecmp(parm->name, "tileprefetch")) {
+		if (showval) { buildprintf("tileprefetch is %d\n", tileprefetch); }
+		else { tileprefetch = max(0, atoi(parm->parms[0])); }
+		return OSDCMD_OK;
+	}
 	else if (!Bstrcasecmp(parm->name, "usevoxels")) {
 		if (showval) { buildprintf("usevoxels is %d\n", usevoxels); }
 		else { usevoxels = (atoi(parm->parms[0]) != 0); }
@@ -555,6 +560,7 @@ int baselayer_init(void)
 	OSD_RegisterFunction("screencaptureformat","screencaptureformat: sets the output format for screenshots (TGA, PCX, PNG)",osdcmd_vars);
 
 	OSD_RegisterFunction("novoxmips","novoxmips: turn off/on the use of mipmaps when rendering 8-bit voxels",osdcmd_vars);
+	OSD_RegisterFunction("tileprefetch","tileprefetch: KB of tiles near the viewer to load ahead of view each frame (0=off)",osdcmd_vars);
 	OSD_RegisterFunction("usevoxels","usevoxels: enable/disable automatic sprite->voxel rendering",osdcmd_vars);
 	OSD_RegisterFunction("usegammabrightness","usegammabrightness: set brightness using system gamma (2), shader (1), or palette (0)",osdcmd_vars);
 	OSD_RegisterFunction("maxrefreshfreq", "maxrefreshfreq: maximum display frequency to set for fullscreen modes (0=no maximum)", osdcmd_vars);
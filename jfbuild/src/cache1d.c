@@ -10,6 +10,19 @@
 #include "build.h"
 #include "cache1d.h"
 #include "pragmas.h"
+#include "baselayer.h"
+
+#if defined(_XBOX)
+	// No file mapping on the Xbox, so kmap() always fails
+#elif defined(_WIN32)
+# define KMAP_WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# define KMAP_POSIX
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
 
 #ifdef WITHKPLIB
 #include "kplib.h"
@@ -29,6 +42,24 @@ static int kzipopen(const char *filnam)
 
 #endif
 
+static void *kplibmutex = NULL;
+
+int kplibinitlock(void)
+{
+	if (!kplibmutex) kplibmutex = bmutex_create();
+	return (kplibmutex != NULL);
+}
+
+void kpliblock(void)
+{
+	if (kplibmutex) bmutex_lock(kplibmutex);
+}
+
+void kplibunlock(void)
+{
+	if (kplibmutex) bmutex_unlock(kplibmutex);
+}
+
 
 //   This module keeps track of a standard linear cacheing system.
 //   To use this module, here's all you need to do:
@@ -428,6 +459,23 @@ static int filehan[MAXOPENFILES] =
 #ifdef WITHKPLIB
 static char filenamsav[MAXOPENFILES][260];
 static int kzcurhand = -1;
+
+	// kplib inflates one ZIPped file at a time, and switching between handles
+	// means starting that file's inflate over. Files up to this size are
+	// inflated whole when opened and read from memory (filegrp 253) instead.
+#define KZMEMFILESIZ (256<<10)
+static char *filemem[MAXOPENFILES];
+static int filememleng[MAXOPENFILES];
+#endif
+
+#if defined(KMAP_WIN32) || defined(KMAP_POSIX)
+struct kmapping {
+	void *view;
+	size_t size;
+#if defined(KMAP_WIN32)
+	HANDLE mapping;
+#endif
+};
 #endif
 
 int initgroupfile(const char *filename)
@@ -544,7 +592,7 @@ void uninitsinglegroupfile(int grphandle)
 
 	// fix up the open files that need attention
 	for(i=0;i<MAXOPENFILES;i++) {
-		if (filegrp[i] >= 254)         // external file (255) or ZIPped file (254)
+		if (filegrp[i] >= 253)         // external file (255) or ZIPped file (254, 253)
 			continue;
 		else if (filegrp[i] == grpnum)   // close file in group we closed
 			filehan[i] = -1;
@@ -569,7 +617,7 @@ void uninitgroupfile(void)
 
 	// JBF 20040111: "close" any files open in groups
 	for(i=0;i<MAXOPENFILES;i++) {
-		if (filegrp[i] < 254)   // JBF 20040130: not external or ZIPped
+		if (filegrp[i] < 253)   // JBF 20040130: not external or ZIPped
 			filehan[i] = -1;
 	}
 }
@@ -602,19 +650,33 @@ int kopen4load(const char *filename, char searchfirst)
 	for (; toupperlookup[(int)(unsigned char)*filename] == '/'; filename++);
 	
 #ifdef WITHKPLIB
+	kpliblock();
 	if ((kzcurhand != newhandle) && (kztell() >= 0))
 	{
 		if (kzcurhand >= 0) filepos[kzcurhand] = kztell();
 		kzclose();
 	}
 	if (searchfirst != 1 && (i = kzipopen(filename)) != 0) {
-		kzcurhand = newhandle;
-		filegrp[newhandle] = 254;
 		filehan[newhandle] = i;
 		filepos[newhandle] = 0;
+
+		j = kzfilelength();
+		if ((j <= KZMEMFILESIZ) && (filemem[newhandle] = (char *)kmalloc(max(j,1))) != NULL) {
+			filememleng[newhandle] = kzread(filemem[newhandle],j);
+			kzclose();
+			kzcurhand = -1;
+			filegrp[newhandle] = 253;
+			kplibunlock();
+			return newhandle;
+		}
+
+		kzcurhand = newhandle;
+		filegrp[newhandle] = 254;
 		strcpy(filenamsav[newhandle],filename);
+		kplibunlock();
 		return newhandle;
 	}
+	kplibunlock();
 #endif
 
 	for(k=numgroupfiles-1;k>=0;k--)
@@ -656,8 +718,17 @@ int kread(int handle, void *buffer, unsigned leng)
 	if (leng > INT_MAX) { errno = EINVAL; return -1; }
 	if (groupnum == 255) return((int)read(filenum,buffer,leng));
 #ifdef WITHKPLIB
+	else if (groupnum == 253)
+	{
+		i = min((int)leng, filememleng[handle]-filepos[handle]);
+		if (i <= 0) return(0);
+		memcpy(buffer, &filemem[handle][filepos[handle]], i);
+		filepos[handle] += i;
+		return(i);
+	}
 	else if (groupnum == 254)
 	{
+		kpliblock();
 		if (kzcurhand != handle)
 		{
 			if (kztell() >= 0) { filepos[kzcurhand] = kztell(); kzclose(); }
@@ -665,7 +736,9 @@ int kread(int handle, void *buffer, unsigned leng)
 			kzipopen(filenamsav[handle]);
 			kzseek(filepos[handle],SEEK_SET);
 		}
-		return(kzread(buffer,leng));
+		i = kzread(buffer,leng);
+		kplibunlock();
+		return(i);
 	}
 #endif
 
@@ -707,8 +780,20 @@ int klseek(int handle, int offset, int whence)
 
 	if (groupnum == 255) return((int)lseek(filehan[handle],offset,whence));
 #ifdef WITHKPLIB
+	else if (groupnum == 253)
+	{
+		switch(whence)
+		{
+			case BSEEK_SET: filepos[handle] = offset; break;
+			case BSEEK_END: filepos[handle] = filememleng[handle]+offset; break;
+			case BSEEK_CUR: filepos[handle] += offset; break;
+		}
+		filepos[handle] = max(0, min(filepos[handle], filememleng[handle]));
+		return(filepos[handle]);
+	}
 	else if (groupnum == 254)
 	{
+		kpliblock();
 		if (kzcurhand != handle)
 		{
 			if (kztell() >= 0) { filepos[kzcurhand] = kztell(); kzclose(); }
@@ -716,7 +801,9 @@ int klseek(int handle, int offset, int whence)
 			kzipopen(filenamsav[handle]);
 			kzseek(filepos[handle],SEEK_SET);
 		}
-		return(kzseek(offset,whence));
+		i = kzseek(offset,whence);
+		kplibunlock();
+		return(i);
 	}
 #endif
 
@@ -744,8 +831,10 @@ int kfilelength(int handle)
 		return (int)Bfilelength(filehan[handle]);
 	}
 #ifdef WITHKPLIB
+	else if (groupnum == 253) return(filememleng[handle]);
 	else if (groupnum == 254)
 	{
+		kpliblock();
 		if (kzcurhand != handle)
 		{
 			if (kztell() >= 0) { filepos[kzcurhand] = kztell(); kzclose(); }
@@ -753,7 +842,9 @@ int kfilelength(int handle)
 			kzipopen(filenamsav[handle]);
 			kzseek(filepos[handle],SEEK_SET);
 		}
-		return kzfilelength();
+		i = kzfilelength();
+		kplibunlock();
+		return(i);
 	}
 #endif
 	i = filehan[handle];
@@ -762,14 +853,16 @@ int kfilelength(int handle)
 
 int ktell(int handle)
 {
-	int groupnum;
+	int i, groupnum;
 
 	groupnum = filegrp[handle];
 
 	if (groupnum == 255) return((int)lseek(filehan[handle],0,SEEK_CUR));
 #ifdef WITHKPLIB
+	else if (groupnum == 253) return(filepos[handle]);
 	else if (groupnum == 254)
 	{
+		kpliblock();
 		if (kzcurhand != handle)
 		{
 			if (kztell() >= 0) { filepos[kzcurhand] = kztell(); kzclose(); }
@@ -777,7 +870,9 @@ int ktell(int handle)
 			kzipopen(filenamsav[handle]);
 			kzseek(filepos[handle],SEEK_SET);
 		}
-		return kztell();
+		i = kztell();
+		kplibunlock();
+		return(i);
 	}
 #endif
 	if (groupfil[groupnum] != -1)
@@ -790,15 +885,107 @@ void kclose(int handle)
 	if (handle < 0) return;
 	if (filegrp[handle] == 255) Bclose(filehan[handle]);
 #ifdef WITHKPLIB
+	else if (filegrp[handle] == 253)
+	{
+		kfree(filemem[handle]);
+		filemem[handle] = NULL;
+	}
 	else if (filegrp[handle] == 254)
 	{
-		kzclose();
-		kzcurhand = -1;
+		kpliblock();
+		if (kzcurhand == handle)
+		{
+			kzclose();
+			kzcurhand = -1;
+		}
+		kplibunlock();
 	}
 #endif
 	filehan[handle] = -1;
 }
 
+	// Maps the file open as 'handle' into memory, read-only, for files on disk and
+	// files inside group files. ZIPped files, and platforms without file mapping,
+	// return NULL and must be read with kread() instead. The mapping outlives the
+	// handle and is released by passing *maphandle to kunmap().
+const void *kmap(int handle, int *length, void **maphandle)
+{
+#if defined(KMAP_WIN32) || defined(KMAP_POSIX)
+	struct kmapping *m;
+	int fd, offs, leng, delta, groupnum;
+#if defined(KMAP_WIN32)
+	SYSTEM_INFO si;
+#endif
+
+	*maphandle = NULL;
+	if ((unsigned)handle >= (unsigned)MAXOPENFILES || filehan[handle] == -1) return NULL;
+
+	groupnum = filegrp[handle];
+	if (groupnum == 255)
+	{
+		fd = filehan[handle];
+		offs = 0;
+		leng = (int)Bfilelength(fd);
+	}
+	else if ((groupnum < numgroupfiles) && (groupfil[groupnum] != -1))
+	{
+		fd = groupfil[groupnum];
+		offs = gfileoffs[groupnum][filehan[handle]] + ((gnumfiles[groupnum]+1)<<4);
+		leng = gfileoffs[groupnum][filehan[handle]+1] - gfileoffs[groupnum][filehan[handle]];
+	}
+	else return NULL;	// ZIPped
+	if (leng <= 0) return NULL;
+
+		// views have to start on an allocation boundary
+#if defined(KMAP_WIN32)
+	GetSystemInfo(&si);
+	delta = offs % (int)si.dwAllocationGranularity;
+#else
+	delta = offs % (int)sysconf(_SC_PAGESIZE);
+#endif
+
+	m = (struct kmapping *)kmalloc(sizeof(struct kmapping));
+	if (!m) return NULL;
+	m->size = (size_t)leng + delta;
+
+#if defined(KMAP_WIN32)
+	m->mapping = CreateFileMapping((HANDLE)_get_osfhandle(fd), NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!m->mapping) { kfree(m); return NULL; }
+	m->view = MapViewOfFile(m->mapping, FILE_MAP_READ, 0, offs-delta, m->size);
+	if (!m->view) { CloseHandle(m->mapping); kfree(m); return NULL; }
+#else
+	m->view = mmap(NULL, m->size, PROT_READ, MAP_SHARED, fd, offs-delta);
+	if (m->view == MAP_FAILED) { kfree(m); return NULL; }
+#endif
+
+	*length = leng;
+	*maphandle = (void *)m;
+	return (const void *)((const char *)m->view + delta);
+#else
+	(void)handle; (void)length;
+	*maphandle = NULL;
+	return NULL;
+#endif
+}
+
+void kunmap(void *maphandle)
+{
+#if defined(KMAP_WIN32) || defined(KMAP_POSIX)
+	struct kmapping *m = (struct kmapping *)maphandle;
+
+	if (!m) return;
+#if defined(KMAP_WIN32)
+	UnmapViewOfFile(m->view);
+	CloseHandle(m->mapping);
+#else
+	munmap(m->view, m->size);
+#endif
+	kfree(m);
+#else
+	(void)maphandle;
+#endif
+}
+
 static int klistaddentry(CACHE1D_FIND_REC **rec, char *name, int type, int source, unsigned usersize)
 {
 	CACHE1D_FIND_REC *r = NULL, *attach = NULL;
@@ -46,6 +46,7 @@ int usevoxels = 1;
 #define kloadvoxel loadvoxel
 
 int novoxmips = 0;
+int tileprefetch = 32;	// KB of tiles near the viewer to load ahead each frame, 0 = off
 
 	//These variables need to be copied into BUILD
 #define MAXXSIZ 256
@@ -521,6 +522,14 @@ static int colnext[256];
 static unsigned char coldist[8] = {0,1,2,3,4,3,2,1};
 static int colscan[27];
 
+	// getclosestcol's answer for every 6-bit colour, filled in as they're asked
+	// for. The bitmap of answers found follows the 64*64*64 answers themselves.
+#define CLOSESTCOLCUBESIZ (64*64*64)
+static unsigned char *closestcolcube = NULL;
+
+#define PALCACHEFILE "palette.cache"
+static const char palcachesig[16] = { 'B','u','i','l','d','P','a','l','C','a','c','h','e',0,0,1 };
+
 static short clipnum, hitwalls[4];
 int hitscangoalx = (1<<29)-1, hitscangoaly = (1<<29)-1;
 #if USE_POLYMOST
@@ -570,6 +579,40 @@ short searchsector, searchwall, searchstat;     //search output
 static char artfilename[20];
 static int numtilefiles, artfil = -1, artfilnum, artfilplc;
 
+	// ART files mapped into memory with kmap(). Unmodified tiles point straight
+	// into these instead of being read into the cache; a tile gets its own copy
+	// in the cache (unmaptile) before anything writes to it.
+static const char *artmapbase[256];
+static int artmapleng[256];
+static void *artmaphand[256];
+static unsigned char tilemapped[(MAXTILES+7)>>3];
+static void unmapartfiles(void);
+
+#define PRECACHEBUFSIZ (512<<10)	// largest single read made by precachetiles_run()
+#define PRECACHEGAP (16<<10)		// unwanted bytes read through rather than seeked over
+static short precachelist[MAXTILES];
+static int precachenum, precachepos, precachedone, precachetotal;
+static char *precachebuf;
+
+	// Per-map lookups built by initmapaccel() when a map is loaded. The game
+	// only moves walls through dragpoint(), which keeps them current; the editor
+	// reshapes maps freely so it always takes the slow paths.
+static short wallsect[MAXWALLS];		// sector each wall belongs to
+static int sectbox[MAXSECTORS][4];		// x1,y1,x2,y2 bounds of each sector's walls
+static int sectslopelen[MAXSECTORS];	// length<<5 of each sector's first wall, for slopes
+static char mapaccelvalid = 0;
+#define MAPACCEL (mapaccelvalid && !editstatus)
+
+	// Tiles of the sectors around the viewer, loaded a few per frame by
+	// prefetchtiles() so they're in memory before they come into view
+#define PREFETCHDEPTH 3			// sectors away from the viewer's that are prefetched
+#define PREFETCHMAXSECTS 64
+static short prefetchlist[1024];
+static int prefetchnum = 0, prefetchpos = 0;
+static size_t prefetchbytes = 0;
+static short prefetchsect = -1;
+static unsigned char prefetchqueued[(MAXTILES+7)>>3];
+
 char inpreparemirror = 0;
 static int mirrorsx1, mirrorsy1, mirrorsx2, mirrorsy2;
 
@@ -4979,6 +5022,52 @@ static void initfastcolorlookup(int rscale, int gscale, int bscale)
 			for(z=-1;z<=1;z++)
 				colscan[i++] = x+y+z;
 	i = colscan[13]; colscan[13] = colscan[26]; colscan[26] = i;
+
+	if (closestcolcube) clearbufbyte(closestcolcube+CLOSESTCOLCUBESIZ,CLOSESTCOLCUBESIZ>>3,0L);
+}
+
+
+//
+// loadpalettecache / savepalettecache (internal)
+//  The shade and translucency tables worked out for an old format palette are
+//  kept in palette.cache, keyed on the CRC of the palette, so they're only
+//  calculated the first time that palette is seen
+//
+static int loadpalettecache(unsigned int crc)
+{
+	BFILE *fh;
+	char sig[16];
+	unsigned int head[2];
+	int ok = 0;
+
+	if (!(fh = Bfopen(PALCACHEFILE,"rb"))) return 0;
+	if (Bfread(sig,16,1,fh) == 1 && !memcmp(sig,palcachesig,16) &&
+		Bfread(head,sizeof(head),1,fh) == 1 &&
+		B_LITTLE32(head[0]) == crc && (int)B_LITTLE32(head[1]) == numpalookups &&
+		Bfread(palookup[0],numpalookups<<8,1,fh) == 1 &&
+		Bfread(transluc,65536,1,fh) == 1) ok = 1;
+	Bfclose(fh);
+	return ok;
+}
+
+static void savepalettecache(unsigned int crc)
+{
+	BFILE *fh;
+	unsigned int head[2];
+
+	if (!(fh = Bfopen(PALCACHEFILE,"wb"))) return;
+	head[0] = B_LITTLE32(crc);
+	head[1] = B_LITTLE32(numpalookups);
+	if (Bfwrite(palcachesig,16,1,fh) != 1 ||
+		Bfwrite(head,sizeof(head),1,fh) != 1 ||
+		Bfwrite(palookup[0],numpalookups<<8,1,fh) != 1 ||
+		Bfwrite(transluc,65536,1,fh) != 1)
+	{
+		Bfclose(fh);
+		remove(PALCACHEFILE);
+		return;
+	}
+	Bfclose(fh);
 }
 
 
@@ -5114,20 +5203,25 @@ static int loadpalette(void)
 		// The guts of transpal.
 		int i,j;
 		unsigned char col;
+		unsigned int crc = crc32once(palette,768);
 
-		for(i=0;i<numpalookups;i++)
-			for(j=0;j<256;j++)
-			{
-				col = calcpalookup((char)i,(unsigned char)j);
-				palookup[0][(i<<8)+j] = col;
-			}
+		if (!loadpalettecache(crc)) {
+			for(i=0;i<numpalookups;i++)
+				for(j=0;j<256;j++)
+				{
+					col = calcpalookup((char)i,(unsigned char)j);
+					palookup[0][(i<<8)+j] = col;
+				}
 
-		for(i=0;i<256;i++)
-			for(j=0;j<256;j++)
-			{
-				col = calctrans((unsigned char)i,(unsigned char)j,128);
-				transluc[(i<<8)+j] = col;
-			}
+			for(i=0;i<256;i++)
+				for(j=0;j<256;j++)
+				{
+					col = calctrans((unsigned char)i,(unsigned char)j,128);
+					transluc[(i<<8)+j] = col;
+				}
+
+			savepalettecache(crc);
+		}
 	}
 
 	return 0;
@@ -5142,7 +5236,7 @@ badpalette:
 //
 // getclosestcol
 //
-int getclosestcol(int r, int g, int b)
+static int findclosestcol(int r, int g, int b)
 {
 	int i, j, k, dist, mindist, retcol;
 	unsigned char *pal1;
@@ -5189,6 +5283,29 @@ int getclosestcol(int r, int g, int b)
 	return(retcol);
 }
 
+int getclosestcol(int r, int g, int b)
+{
+	int i;
+	unsigned char *have;
+
+	if ((r|g|b)&~63) return(findclosestcol(r,g,b));
+	if (!closestcolcube)
+	{
+		if ((closestcolcube = (unsigned char *)kmalloc(CLOSESTCOLCUBESIZ+(CLOSESTCOLCUBESIZ>>3))) == NULL)
+			return(findclosestcol(r,g,b));
+		clearbufbyte(closestcolcube+CLOSESTCOLCUBESIZ,CLOSESTCOLCUBESIZ>>3,0L);
+	}
+
+	i = (r<<12)+(g<<6)+b;
+	have = &closestcolcube[CLOSESTCOLCUBESIZ+(i>>3)];
+	if (!(*have & pow2char[i&7]))
+	{
+		closestcolcube[i] = (unsigned char)findclosestcol(r,g,b);
+		*have |= pow2char[i&7];
+	}
+	return(closestcolcube[i]);
+}
+
 
 //
 // insertspritesect (internal)
@@ -5614,8 +5731,11 @@ void uninitengine(void)
 	logfile = NULL;
 
 	if (artfil != -1) kclose(artfil);
+	unmapartfiles();
+	if (precachebuf) { kfree(precachebuf); precachebuf = NULL; }
 
 	if (transluc != NULL) { kfree(transluc); transluc = NULL; }
+	if (closestcolcube != NULL) { kfree(closestcolcube); closestcolcube = NULL; }
 	if (pic != NULL) { kfree(pic); pic = NULL; }
 	if (lookups != NULL) { kfree(lookups); lookups = NULL; }
 	for(i=0;i<MAXPALOOKUPS;i++)
@@ -5657,6 +5777,159 @@ void initspritelists(void)
 }
 
 
+//
+// initmapaccel
+//  Builds the wall and sector lookups for the loaded map. Call again after
+//  replacing the map's walls or sectors by any means but loadboard.
+//
+static int calcslopelen(int sectnum)
+{
+	walltype *wal;
+	int dx, dy;
+
+	wal = &wall[sector[sectnum].wallptr];
+	dx = wall[wal->point2].x-wal->x; dy = wall[wal->point2].y-wal->y;
+	return((int)(nsqrtasm(dx*dx+dy*dy)<<5));
+}
+
+void initmapaccel(void)
+{
+	int i, j, endwall, *box;
+
+	mapaccelvalid = 0;
+	prefetchsect = -1;
+	prefetchnum = prefetchpos = 0;
+	clearbuf(prefetchqueued,(int)(sizeof(prefetchqueued)>>2),0L);
+	for(i=0;i<numsectors;i++)
+	{
+		j = sector[i].wallptr; endwall = j+sector[i].wallnum;
+		if ((j < 0) || (sector[i].wallnum <= 0) || (endwall > numwalls)) return;
+
+		box = sectbox[i];
+		box[0] = box[2] = wall[j].x;
+		box[1] = box[3] = wall[j].y;
+		for(;j<endwall;j++)
+		{
+			wallsect[j] = (short)i;
+			if (wall[j].x < box[0]) box[0] = wall[j].x;
+			if (wall[j].y < box[1]) box[1] = wall[j].y;
+			if (wall[j].x > box[2]) box[2] = wall[j].x;
+			if (wall[j].y > box[3]) box[3] = wall[j].y;
+		}
+		sectslopelen[i] = calcslopelen(i);
+	}
+	mapaccelvalid = 1;
+}
+
+//
+// movemapaccel (internal)
+//  Follows a wall point moved by dragpoint. Sector bounds only ever grow here,
+//  which keeps them safe to reject against without rescanning the sector.
+//
+static void movemapaccel(short point)
+{
+	int sectnum, *box;
+
+	if (!mapaccelvalid) return;
+	sectnum = wallsect[point];
+	box = sectbox[sectnum];
+	if (wall[point].x < box[0]) box[0] = wall[point].x;
+	if (wall[point].y < box[1]) box[1] = wall[point].y;
+	if (wall[point].x > box[2]) box[2] = wall[point].x;
+	if (wall[point].y > box[3]) box[3] = wall[point].y;
+	if ((point == sector[sectnum].wallptr) || (point == wall[sector[sectnum].wallptr].point2))
+		sectslopelen[sectnum] = calcslopelen(sectnum);
+}
+
+
+//
+// queueprefetch (internal)
+//  Lists the tiles used in the sectors within PREFETCHDEPTH of 'sectnum' that
+//  aren't in memory yet
+//
+static void queueprefetchtile(int tilenume)
+{
+	int i, j, k;
+
+	if ((unsigned)tilenume >= (unsigned)MAXTILES) return;
+
+		// every frame of an animation; backward ones count down from tilenume
+	j = k = tilenume;
+	switch(picanm[tilenume]&192)
+	{
+		case 64: case 128: k = min(tilenume+(picanm[tilenume]&63),MAXTILES-1); break;
+		case 192: j = max(tilenume-(picanm[tilenume]&63),0); break;
+	}
+	for(i=j;i<=k;i++)
+	{
+		if (prefetchnum >= (int)(sizeof(prefetchlist)/sizeof(prefetchlist[0]))) return;
+		if (waloff[i] || (tilesizx[i] <= 0) || (tilesizy[i] <= 0)) continue;
+		if (prefetchqueued[i>>3] & pow2char[i&7]) continue;
+		prefetchqueued[i>>3] |= pow2char[i&7];
+		prefetchlist[prefetchnum++] = (short)i;
+	}
+}
+
+static void queueprefetch(short sectnum)
+{
+	short sects[PREFETCHMAXSECTS];
+	unsigned char depth[PREFETCHMAXSECTS];
+	int i, j, k, numsects, s, w, endwall;
+
+	for(i=0;i<prefetchnum;i++)
+		prefetchqueued[prefetchlist[i]>>3] &= ~pow2char[prefetchlist[i]&7];
+	prefetchnum = prefetchpos = 0;
+	prefetchbytes = 0;
+
+	sects[0] = sectnum; depth[0] = 0; numsects = 1;
+	for(i=0;i<numsects;i++)
+	{
+		s = sects[i];
+		queueprefetchtile(sector[s].ceilingpicnum);
+		queueprefetchtile(sector[s].floorpicnum);
+
+		w = sector[s].wallptr; endwall = w+sector[s].wallnum;
+		for(;w<endwall;w++)
+		{
+			queueprefetchtile(wall[w].picnum);
+			if (wall[w].cstat&(16|32)) queueprefetchtile(wall[w].overpicnum);
+
+			k = wall[w].nextsector;
+			if ((k < 0) || (depth[i] >= PREFETCHDEPTH) || (numsects >= PREFETCHMAXSECTS)) continue;
+			for(j=numsects-1;j>=0;j--) if (sects[j] == k) break;
+			if (j < 0) { sects[numsects] = k; depth[numsects] = depth[i]+1; numsects++; }
+		}
+
+		for(j=headspritesect[s];j>=0;j=nextspritesect[j])
+			if (!(sprite[j].cstat&32768)) queueprefetchtile(sprite[j].picnum);
+	}
+}
+
+//
+// prefetchtiles (internal)
+//  Loads up to 'tileprefetch' KB of the tiles queued by queueprefetch(). What
+//  one sector's worth of prefetching may load is held to a quarter of the cache.
+//
+static void prefetchtiles(void)
+{
+	int i, dasiz, budget;
+
+	budget = tileprefetch<<10;
+	while ((prefetchpos < prefetchnum) && (budget > 0))
+	{
+		i = prefetchlist[prefetchpos++];
+		if (waloff[i]) continue;
+
+		dasiz = tilesizx[i]*tilesizy[i];
+		if (prefetchbytes+dasiz > (cachesize>>2)) { prefetchpos = prefetchnum; break; }
+
+		loadtile((short)i);	// locked at 199 like a tile loaded to be drawn
+		prefetchbytes += dasiz;
+		budget -= dasiz;
+	}
+}
+
+
 //
 // drawrooms
 //
@@ -5691,6 +5964,13 @@ void drawrooms(int daposx, int daposy, int daposz,
 	globalcursectnum = dacursectnum;
 	totalclocklock = totalclock;
 
+	if (tileprefetch && MAPACCEL && !offscreenrendering && !inpreparemirror &&
+		(dacursectnum != prefetchsect) && ((unsigned)dacursectnum < (unsigned)numsectors))
+	{
+		prefetchsect = dacursectnum;
+		queueprefetch(dacursectnum);
+	}
+
 	cosglobalang = sintable[(globalang+512)&2047];
 	singlobalang = sintable[globalang&2047];
 	cosviewingrangeglobalang = mulscale16(cosglobalang,viewingrange);
@@ -6288,6 +6568,54 @@ void drawmapview(int dax, int day, int zoome, short ang)
 }
 
 
+//
+// openboardfile / readboard / closeboardfile
+//  Map files are decoded from memory: the whole file is mapped with kmap(), or
+//  failing that fetched with a single kread(), instead of read field by field.
+//
+typedef struct {
+	const unsigned char *pos, *end;
+	unsigned char *buf;
+	void *maphandle;
+} boardfile;
+
+static int openboardfile(boardfile *bf, int fil)
+{
+	const unsigned char *data;
+	int leng;
+
+	bf->buf = NULL;
+	data = (const unsigned char *)kmap(fil, &leng, &bf->maphandle);
+	if (!data)
+	{
+		leng = kfilelength(fil);
+		if (leng <= 0 || !(bf->buf = (unsigned char *)kmalloc(leng))) return -1;
+		if (kread(fil, bf->buf, leng) != leng)
+			{ kfree(bf->buf); bf->buf = NULL; return -1; }
+		data = bf->buf;
+	}
+	bf->pos = data;
+	bf->end = data + leng;
+	return 0;
+}
+
+static int readboard(boardfile *bf, void *buffer, int leng)
+{
+	if (bf->end - bf->pos < leng) return 0;
+	memcpy(buffer, bf->pos, leng);
+	bf->pos += leng;
+	return leng;
+}
+
+static void closeboardfile(boardfile *bf)
+{
+	if (bf->maphandle) kunmap(bf->maphandle);
+	if (bf->buf) kfree(bf->buf);
+	bf->maphandle = NULL;
+	bf->buf = NULL;
+}
+
+
 //
 // loadboard
 //
@@ -6296,13 +6624,19 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 {
 	short fil, i, numsprites;
 	short maxsectors, maxwalls, maxsprites;
+	boardfile bf;
 
 	i = strlen(filename)-1;
 	if ((unsigned char)filename[i] == 255) { filename[i] = 0; fromwhere = 1; }	// JBF 20040119: "compatibility"
 	if ((fil = kopen4load(filename,fromwhere)) == -1)
 		{ mapversion = 7L; return(-1); }
 
-	kread(fil,&mapversion,4); mapversion = B_LITTLE32(mapversion);
+	i = openboardfile(&bf,fil);
+	kclose(fil);
+	if (i) { mapversion = 7L; return(-3); }
+
+	if (readboard(&bf,&mapversion,4) != 4) goto readerror;
+	mapversion = B_LITTLE32(mapversion);
 	if (mapversion == 7)
 	{
 		maxsectors = MAXSECTORSV7;
@@ -6317,7 +6651,7 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 	}
 	else
 	{
-		kclose(fil);
+		closeboardfile(&bf);
 		return(-2);
 	}
 
@@ -6334,15 +6668,23 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 	clearbuf(&show2dsprite[0],(int)((MAXSPRITES+3)>>5),0L);
 	clearbuf(&show2dwall[0],(int)((MAXWALLS+3)>>5),0L);
 
-	kread(fil,daposx,4); *daposx = B_LITTLE32(*daposx);
-	kread(fil,daposy,4); *daposy = B_LITTLE32(*daposy);
-	kread(fil,daposz,4); *daposz = B_LITTLE32(*daposz);
-	kread(fil,daang,2);  *daang  = B_LITTLE16(*daang);
-	kread(fil,dacursectnum,2); *dacursectnum = B_LITTLE16(*dacursectnum);
+	if (readboard(&bf,daposx,4) != 4) goto readerror;
+	if (readboard(&bf,daposy,4) != 4) goto readerror;
+	if (readboard(&bf,daposz,4) != 4) goto readerror;
+	if (readboard(&bf,daang,2) != 2) goto readerror;
+	if (readboard(&bf,dacursectnum,2) != 2) goto readerror;
+	*daposx = B_LITTLE32(*daposx);
+	*daposy = B_LITTLE32(*daposy);
+	*daposz = B_LITTLE32(*daposz);
+	*daang  = B_LITTLE16(*daang);
+	*dacursectnum = B_LITTLE16(*dacursectnum);
 
-	kread(fil,&numsectors,2); numsectors = B_LITTLE16(numsectors);
-	if (numsectors > maxsectors) { kclose(fil); return(-2); }
-	kread(fil,&sector[0],sizeof(sectortype)*numsectors);
+	if (readboard(&bf,&numsectors,2) != 2) goto readerror;
+	numsectors = B_LITTLE16(numsectors);
+	if (numsectors > maxsectors) { closeboardfile(&bf); return(-2); }
+	if (readboard(&bf,&sector[0],sizeof(sectortype)*numsectors) != (int)sizeof(sectortype)*numsectors)
+		goto readerror;
+#if B_BIG_ENDIAN != 0
 	for (i=numsectors-1; i>=0; i--) {
 		sector[i].wallptr       = B_LITTLE16(sector[i].wallptr);
 		sector[i].wallnum       = B_LITTLE16(sector[i].wallnum);
@@ -6358,10 +6700,14 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 		sector[i].hitag         = B_LITTLE16(sector[i].hitag);
 		sector[i].extra         = B_LITTLE16(sector[i].extra);
 	}
+#endif
 
-	kread(fil,&numwalls,2); numwalls = B_LITTLE16(numwalls);
-	if (numwalls > maxwalls) { kclose(fil); return(-2); }
-	kread(fil,&wall[0],sizeof(walltype)*numwalls);
+	if (readboard(&bf,&numwalls,2) != 2) goto readerror;
+	numwalls = B_LITTLE16(numwalls);
+	if (numwalls > maxwalls) { closeboardfile(&bf); return(-2); }
+	if (readboard(&bf,&wall[0],sizeof(walltype)*numwalls) != (int)sizeof(walltype)*numwalls)
+		goto readerror;
+#if B_BIG_ENDIAN != 0
 	for (i=numwalls-1; i>=0; i--) {
 		wall[i].x          = B_LITTLE32(wall[i].x);
 		wall[i].y          = B_LITTLE32(wall[i].y);
@@ -6375,11 +6721,18 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 		wall[i].hitag      = B_LITTLE16(wall[i].hitag);
 		wall[i].extra      = B_LITTLE16(wall[i].extra);
 	}
+#endif
+
+	if (readboard(&bf,&numsprites,2) != 2) goto readerror;
+	numsprites = B_LITTLE16(numsprites);
+	if (numsprites > maxsprites) { closeboardfile(&bf); return(-2); }
+	if (readboard(&bf,&sprite[0],sizeof(spritetype)*numsprites) != (int)sizeof(spritetype)*numsprites)
+		goto readerror;
+
+	closeboardfile(&bf);
 
-	kread(fil,&numsprites,2); numsprites = B_LITTLE16(numsprites);
-	if (numsprites > maxsprites) { kclose(fil); return(-2); }
-	kread(fil,&sprite[0],sizeof(spritetype)*numsprites);
-	for (i=numsprites-1; i>=0; i--) {
+	for (i=0; i<numsprites; i++) {
+#if B_BIG_ENDIAN != 0
 		sprite[i].x       = B_LITTLE32(sprite[i].x);
 		sprite[i].y       = B_LITTLE32(sprite[i].y);
 		sprite[i].z       = B_LITTLE32(sprite[i].z);
@@ -6395,24 +6748,26 @@ int loadboard(char *filename, char fromwhere, int *daposx, int *daposy, int *dap
 		sprite[i].lotag   = B_LITTLE16(sprite[i].lotag);
 		sprite[i].hitag   = B_LITTLE16(sprite[i].hitag);
 		sprite[i].extra   = B_LITTLE16(sprite[i].extra);
-	}
-
-	for(i=0;i<numsprites;i++) {
+#endif
 		if ((sprite[i].cstat & 48) == 48) sprite[i].cstat &= ~48;
 		insertsprite(sprite[i].sectnum,sprite[i].statnum);
 	}
 
+	initmapaccel();
+
 		//Must be after loading sectors, etc!
 	updatesector(*daposx,*daposy,dacursectnum);
 
-	kclose(fil);
-
 #if USE_POLYMOST && USE_OPENGL
 	memset(spriteext, 0, sizeof(spriteext));
 #endif
 	guniqhudid = 0;
 
 	return(0);
+
+readerror:
+	closeboardfile(&bf);
+	return -3;
 }
 
 
@@ -6532,25 +6887,25 @@ struct spritetypev6
 	short lotag, hitag, extra;
 };
 
-static int readv4sect(int fil, struct sectortypev4 *sect)
-{
-	if (kread(fil, &sect->wallptr, 2) != 2) return -1;
-	if (kread(fil, &sect->wallnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingstat, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingshade, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingz, 4) != 4) return -1;
-	if (kread(fil, &sect->ceilingpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorstat, 1) != 1) return -1;
-	if (kread(fil, &sect->floorxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorshade, 1) != 1) return -1;
-	if (kread(fil, &sect->floorz, 4) != 4) return -1;
-	if (kread(fil, &sect->floorpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->tag, 4) != 4) return -1;
+static int readv4sect(boardfile *bf, struct sectortypev4 *sect)
+{
+	if (readboard(bf, &sect->wallptr, 2) != 2) return -1;
+	if (readboard(bf, &sect->wallnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingz, 4) != 4) return -1;
+	if (readboard(bf, &sect->ceilingpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorz, 4) != 4) return -1;
+	if (readboard(bf, &sect->floorpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->tag, 4) != 4) return -1;
 
 	sect->wallptr = B_LITTLE16(sect->wallptr);
 	sect->wallnum = B_LITTLE16(sect->wallnum);
@@ -6591,24 +6946,24 @@ static void convertv4sectv5(struct sectortypev4 *from, struct sectortypev5 *to)
 	to->extra = -1;
 }
 
-static int readv4wall(int fil, struct walltypev4 *wall)
-{
-	if (kread(fil, &wall->x, 4) != 4) return -1;
-	if (kread(fil, &wall->y, 4) != 4) return -1;
-	if (kread(fil, &wall->point2, 2) != 2) return -1;
-	if (kread(fil, &wall->cstat, 1) != 1) return -1;
-	if (kread(fil, &wall->shade, 1) != 1) return -1;
-	if (kread(fil, &wall->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->xpanning, 1) != 1) return -1;
-	if (kread(fil, &wall->ypanning, 1) != 1) return -1;
-	if (kread(fil, &wall->picnum, 2) != 2) return -1;
-	if (kread(fil, &wall->overpicnum, 2) != 2) return -1;
-	if (kread(fil, &wall->nextsector1, 2) != 2) return -1;
-	if (kread(fil, &wall->nextwall1, 2) != 2) return -1;
-	if (kread(fil, &wall->nextsector2, 2) != 2) return -1;
-	if (kread(fil, &wall->nextwall2, 2) != 2) return -1;
-	if (kread(fil, &wall->tag, 4) != 4) return -1;
+static int readv4wall(boardfile *bf, struct walltypev4 *wall)
+{
+	if (readboard(bf, &wall->x, 4) != 4) return -1;
+	if (readboard(bf, &wall->y, 4) != 4) return -1;
+	if (readboard(bf, &wall->point2, 2) != 2) return -1;
+	if (readboard(bf, &wall->cstat, 1) != 1) return -1;
+	if (readboard(bf, &wall->shade, 1) != 1) return -1;
+	if (readboard(bf, &wall->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->xpanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->ypanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->picnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->overpicnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextsector1, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextwall1, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextsector2, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextwall2, 2) != 2) return -1;
+	if (readboard(bf, &wall->tag, 4) != 4) return -1;
 
 	wall->x = B_LITTLE32(wall->x);
 	wall->y = B_LITTLE32(wall->y);
@@ -6646,25 +7001,25 @@ static void convertv4wallv5(struct walltypev4 *from, struct walltypev5 *to)
 	to->extra = -1;
 }
 
-static int readv4sprite(int fil, struct spritetypev4 *spr)
-{
-	if (kread(fil, &spr->x, 4) != 4) return -1;
-	if (kread(fil, &spr->y, 4) != 4) return -1;
-	if (kread(fil, &spr->z, 4) != 4) return -1;
-	if (kread(fil, &spr->cstat, 1) != 1) return -1;
-	if (kread(fil, &spr->shade, 1) != 1) return -1;
-	if (kread(fil, &spr->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->picnum, 2) != 2) return -1;
-	if (kread(fil, &spr->ang, 2) != 2) return -1;
-	if (kread(fil, &spr->xvel, 2) != 2) return -1;
-	if (kread(fil, &spr->yvel, 2) != 2) return -1;
-	if (kread(fil, &spr->zvel, 2) != 2) return -1;
-	if (kread(fil, &spr->owner, 2) != 2) return -1;
-	if (kread(fil, &spr->sectnum, 2) != 2) return -1;
-	if (kread(fil, &spr->statnum, 2) != 2) return -1;
-	if (kread(fil, &spr->tag, 4) != 4) return -1;
-	if (kread(fil, &spr->extra, 4) != 4) return -1;
+static int readv4sprite(boardfile *bf, struct spritetypev4 *spr)
+{
+	if (readboard(bf, &spr->x, 4) != 4) return -1;
+	if (readboard(bf, &spr->y, 4) != 4) return -1;
+	if (readboard(bf, &spr->z, 4) != 4) return -1;
+	if (readboard(bf, &spr->cstat, 1) != 1) return -1;
+	if (readboard(bf, &spr->shade, 1) != 1) return -1;
+	if (readboard(bf, &spr->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->picnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->ang, 2) != 2) return -1;
+	if (readboard(bf, &spr->xvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->yvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->zvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->owner, 2) != 2) return -1;
+	if (readboard(bf, &spr->sectnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->statnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->tag, 4) != 4) return -1;
+	if (readboard(bf, &spr->extra, 4) != 4) return -1;
 
 	spr->x = B_LITTLE32(spr->x);
 	spr->y = B_LITTLE32(spr->y);
@@ -6723,30 +7078,30 @@ static short sectorofwallv5(short theline)
 	return(sucksect);
 }
 
-static int readv5sect(int fil, struct sectortypev5 *sect)
-{
-	if (kread(fil, &sect->wallptr, 2) != 2) return -1;
-	if (kread(fil, &sect->wallnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingz, 4) != 4) return -1;
-	if (kread(fil, &sect->floorz, 4) != 4) return -1;
-	if (kread(fil, &sect->ceilingshade, 1) != 1) return -1;
-	if (kread(fil, &sect->floorshade, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingstat, 1) != 1) return -1;
-	if (kread(fil, &sect->floorstat, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingpal, 1) != 1) return -1;
-	if (kread(fil, &sect->floorpal, 1) != 1) return -1;
-	if (kread(fil, &sect->visibility, 1) != 1) return -1;
-	if (kread(fil, &sect->lotag, 2) != 2) return -1;
-	if (kread(fil, &sect->hitag, 2) != 2) return -1;
-	if (kread(fil, &sect->extra, 2) != 2) return -1;
+static int readv5sect(boardfile *bf, struct sectortypev5 *sect)
+{
+	if (readboard(bf, &sect->wallptr, 2) != 2) return -1;
+	if (readboard(bf, &sect->wallnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingz, 4) != 4) return -1;
+	if (readboard(bf, &sect->floorz, 4) != 4) return -1;
+	if (readboard(bf, &sect->ceilingshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingpal, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorpal, 1) != 1) return -1;
+	if (readboard(bf, &sect->visibility, 1) != 1) return -1;
+	if (readboard(bf, &sect->lotag, 2) != 2) return -1;
+	if (readboard(bf, &sect->hitag, 2) != 2) return -1;
+	if (readboard(bf, &sect->extra, 2) != 2) return -1;
 
 	sect->wallptr = B_LITTLE16(sect->wallptr);
 	sect->wallnum = B_LITTLE16(sect->wallnum);
@@ -6846,26 +7201,26 @@ static void convertv6sectv5(struct sectortypev6 *from, struct sectortypev5 *to)
 	to->extra = from->extra;
 }
 
-static int readv5wall(int fil, struct walltypev5 *wall)
-{
-	if (kread(fil, &wall->x, 4) != 4) return -1;
-	if (kread(fil, &wall->y, 4) != 4) return -1;
-	if (kread(fil, &wall->point2, 2) != 2) return -1;
-	if (kread(fil, &wall->picnum, 2) != 2) return -1;
-	if (kread(fil, &wall->overpicnum, 2) != 2) return -1;
-	if (kread(fil, &wall->shade, 1) != 1) return -1;
-	if (kread(fil, &wall->cstat, 2) != 2) return -1;
-	if (kread(fil, &wall->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->xpanning, 1) != 1) return -1;
-	if (kread(fil, &wall->ypanning, 1) != 1) return -1;
-	if (kread(fil, &wall->nextsector1, 2) != 2) return -1;
-	if (kread(fil, &wall->nextwall1, 2) != 2) return -1;
-	if (kread(fil, &wall->nextsector2, 2) != 2) return -1;
-	if (kread(fil, &wall->nextwall2, 2) != 2) return -1;
-	if (kread(fil, &wall->lotag, 2) != 2) return -1;
-	if (kread(fil, &wall->hitag, 2) != 2) return -1;
-	if (kread(fil, &wall->extra, 2) != 2) return -1;
+static int readv5wall(boardfile *bf, struct walltypev5 *wall)
+{
+	if (readboard(bf, &wall->x, 4) != 4) return -1;
+	if (readboard(bf, &wall->y, 4) != 4) return -1;
+	if (readboard(bf, &wall->point2, 2) != 2) return -1;
+	if (readboard(bf, &wall->picnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->overpicnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->shade, 1) != 1) return -1;
+	if (readboard(bf, &wall->cstat, 2) != 2) return -1;
+	if (readboard(bf, &wall->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->xpanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->ypanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->nextsector1, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextwall1, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextsector2, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextwall2, 2) != 2) return -1;
+	if (readboard(bf, &wall->lotag, 2) != 2) return -1;
+	if (readboard(bf, &wall->hitag, 2) != 2) return -1;
+	if (readboard(bf, &wall->extra, 2) != 2) return -1;
 
 	wall->x = B_LITTLE32(wall->x);
 	wall->y = B_LITTLE32(wall->y);
@@ -6954,26 +7309,26 @@ static void convertv6wallv5(struct walltypev6 *from, struct walltypev5 *to)
 	to->extra = from->extra;
 }
 
-static int readv5sprite(int fil, struct spritetypev5 *spr)
-{
-	if (kread(fil, &spr->x, 4) != 4) return -1;
-	if (kread(fil, &spr->y, 4) != 4) return -1;
-	if (kread(fil, &spr->z, 4) != 4) return -1;
-	if (kread(fil, &spr->cstat, 1) != 1) return -1;
-	if (kread(fil, &spr->shade, 1) != 1) return -1;
-	if (kread(fil, &spr->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->picnum, 2) != 2) return -1;
-	if (kread(fil, &spr->ang, 2) != 2) return -1;
-	if (kread(fil, &spr->xvel, 2) != 2) return -1;
-	if (kread(fil, &spr->yvel, 2) != 2) return -1;
-	if (kread(fil, &spr->zvel, 2) != 2) return -1;
-	if (kread(fil, &spr->owner, 2) != 2) return -1;
-	if (kread(fil, &spr->sectnum, 2) != 2) return -1;
-	if (kread(fil, &spr->statnum, 2) != 2) return -1;
-	if (kread(fil, &spr->lotag, 2) != 2) return -1;
-	if (kread(fil, &spr->hitag, 2) != 2) return -1;
-	if (kread(fil, &spr->extra, 2) != 2) return -1;
+static int readv5sprite(boardfile *bf, struct spritetypev5 *spr)
+{
+	if (readboard(bf, &spr->x, 4) != 4) return -1;
+	if (readboard(bf, &spr->y, 4) != 4) return -1;
+	if (readboard(bf, &spr->z, 4) != 4) return -1;
+	if (readboard(bf, &spr->cstat, 1) != 1) return -1;
+	if (readboard(bf, &spr->shade, 1) != 1) return -1;
+	if (readboard(bf, &spr->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->picnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->ang, 2) != 2) return -1;
+	if (readboard(bf, &spr->xvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->yvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->zvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->owner, 2) != 2) return -1;
+	if (readboard(bf, &spr->sectnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->statnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->lotag, 2) != 2) return -1;
+	if (readboard(bf, &spr->hitag, 2) != 2) return -1;
+	if (readboard(bf, &spr->extra, 2) != 2) return -1;
 
 	spr->x = B_LITTLE32(spr->x);
 	spr->y = B_LITTLE32(spr->y);
@@ -7075,30 +7430,30 @@ static void convertv6sprv5(struct spritetypev6 *from, struct spritetypev5 *to)
 	to->extra = from->extra;
 }
 
-static int readv6sect(int fil, struct sectortypev6 *sect)
-{
-	if (kread(fil, &sect->wallptr, 2) != 2) return -1;
-	if (kread(fil, &sect->wallnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorpicnum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->floorheinum, 2) != 2) return -1;
-	if (kread(fil, &sect->ceilingz, 4) != 4) return -1;
-	if (kread(fil, &sect->floorz, 4) != 4) return -1;
-	if (kread(fil, &sect->ceilingshade, 1) != 1) return -1;
-	if (kread(fil, &sect->floorshade, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorxpanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->floorypanning, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingstat, 1) != 1) return -1;
-	if (kread(fil, &sect->floorstat, 1) != 1) return -1;
-	if (kread(fil, &sect->ceilingpal, 1) != 1) return -1;
-	if (kread(fil, &sect->floorpal, 1) != 1) return -1;
-	if (kread(fil, &sect->visibility, 1) != 1) return -1;
-	if (kread(fil, &sect->lotag, 2) != 2) return -1;
-	if (kread(fil, &sect->hitag, 2) != 2) return -1;
-	if (kread(fil, &sect->extra, 2) != 2) return -1;
+static int readv6sect(boardfile *bf, struct sectortypev6 *sect)
+{
+	if (readboard(bf, &sect->wallptr, 2) != 2) return -1;
+	if (readboard(bf, &sect->wallnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorpicnum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->floorheinum, 2) != 2) return -1;
+	if (readboard(bf, &sect->ceilingz, 4) != 4) return -1;
+	if (readboard(bf, &sect->floorz, 4) != 4) return -1;
+	if (readboard(bf, &sect->ceilingshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorshade, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorxpanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorypanning, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorstat, 1) != 1) return -1;
+	if (readboard(bf, &sect->ceilingpal, 1) != 1) return -1;
+	if (readboard(bf, &sect->floorpal, 1) != 1) return -1;
+	if (readboard(bf, &sect->visibility, 1) != 1) return -1;
+	if (readboard(bf, &sect->lotag, 2) != 2) return -1;
+	if (readboard(bf, &sect->hitag, 2) != 2) return -1;
+	if (readboard(bf, &sect->extra, 2) != 2) return -1;
 
 	sect->wallptr = B_LITTLE16(sect->wallptr);
 	sect->wallnum = B_LITTLE16(sect->wallnum);
@@ -7203,25 +7558,25 @@ static void convertv7sectv6(sectortype *from, struct sectortypev6 *to)
 	to->extra = from->extra;
 }
 
-static int readv6wall(int fil, struct walltypev6 *wall)
-{
-	if (kread(fil, &wall->x, 4) != 4) return -1;
-	if (kread(fil, &wall->y, 4) != 4) return -1;
-	if (kread(fil, &wall->point2, 2) != 2) return -1;
-	if (kread(fil, &wall->nextsector, 2) != 2) return -1;
-	if (kread(fil, &wall->nextwall, 2) != 2) return -1;
-	if (kread(fil, &wall->picnum, 2) != 2) return -1;
-	if (kread(fil, &wall->overpicnum, 2) != 2) return -1;
-	if (kread(fil, &wall->shade, 1) != 1) return -1;
-	if (kread(fil, &wall->pal, 1) != 1) return -1;
-	if (kread(fil, &wall->cstat, 2) != 2) return -1;
-	if (kread(fil, &wall->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &wall->xpanning, 1) != 1) return -1;
-	if (kread(fil, &wall->ypanning, 1) != 1) return -1;
-	if (kread(fil, &wall->lotag, 2) != 2) return -1;
-	if (kread(fil, &wall->hitag, 2) != 2) return -1;
-	if (kread(fil, &wall->extra, 2) != 2) return -1;
+static int readv6wall(boardfile *bf, struct walltypev6 *wall)
+{
+	if (readboard(bf, &wall->x, 4) != 4) return -1;
+	if (readboard(bf, &wall->y, 4) != 4) return -1;
+	if (readboard(bf, &wall->point2, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextsector, 2) != 2) return -1;
+	if (readboard(bf, &wall->nextwall, 2) != 2) return -1;
+	if (readboard(bf, &wall->picnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->overpicnum, 2) != 2) return -1;
+	if (readboard(bf, &wall->shade, 1) != 1) return -1;
+	if (readboard(bf, &wall->pal, 1) != 1) return -1;
+	if (readboard(bf, &wall->cstat, 2) != 2) return -1;
+	if (readboard(bf, &wall->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &wall->xpanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->ypanning, 1) != 1) return -1;
+	if (readboard(bf, &wall->lotag, 2) != 2) return -1;
+	if (readboard(bf, &wall->hitag, 2) != 2) return -1;
+	if (readboard(bf, &wall->extra, 2) != 2) return -1;
 
 	wall->x = B_LITTLE32(wall->x);
 	wall->y = B_LITTLE32(wall->y);
@@ -7306,30 +7661,30 @@ static void convertv7wallv6(walltype *from, struct walltypev6 *to)
 	to->extra = from->extra;
 }
 
-static int readv6sprite(int fil, struct spritetypev6 *spr)
-{
-	if (kread(fil, &spr->x, 4) != 4) return -1;
-	if (kread(fil, &spr->y, 4) != 4) return -1;
-	if (kread(fil, &spr->z, 4) != 4) return -1;
-	if (kread(fil, &spr->cstat, 2) != 2) return -1;
-	if (kread(fil, &spr->shade, 1) != 1) return -1;
-	if (kread(fil, &spr->pal, 1) != 1) return -1;
-	if (kread(fil, &spr->clipdist, 1) != 1) return -1;
-	if (kread(fil, &spr->xrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->yrepeat, 1) != 1) return -1;
-	if (kread(fil, &spr->xoffset, 1) != 1) return -1;
-	if (kread(fil, &spr->yoffset, 1) != 1) return -1;
-	if (kread(fil, &spr->picnum, 2) != 2) return -1;
-	if (kread(fil, &spr->ang, 2) != 2) return -1;
-	if (kread(fil, &spr->xvel, 2) != 2) return -1;
-	if (kread(fil, &spr->yvel, 2) != 2) return -1;
-	if (kread(fil, &spr->zvel, 2) != 2) return -1;
-	if (kread(fil, &spr->owner, 2) != 2) return -1;
-	if (kread(fil, &spr->sectnum, 2) != 2) return -1;
-	if (kread(fil, &spr->statnum, 2) != 2) return -1;
-	if (kread(fil, &spr->lotag, 2) != 2) return -1;
-	if (kread(fil, &spr->hitag, 2) != 2) return -1;
-	if (kread(fil, &spr->extra, 2) != 2) return -1;
+static int readv6sprite(boardfile *bf, struct spritetypev6 *spr)
+{
+	if (readboard(bf, &spr->x, 4) != 4) return -1;
+	if (readboard(bf, &spr->y, 4) != 4) return -1;
+	if (readboard(bf, &spr->z, 4) != 4) return -1;
+	if (readboard(bf, &spr->cstat, 2) != 2) return -1;
+	if (readboard(bf, &spr->shade, 1) != 1) return -1;
+	if (readboard(bf, &spr->pal, 1) != 1) return -1;
+	if (readboard(bf, &spr->clipdist, 1) != 1) return -1;
+	if (readboard(bf, &spr->xrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->yrepeat, 1) != 1) return -1;
+	if (readboard(bf, &spr->xoffset, 1) != 1) return -1;
+	if (readboard(bf, &spr->yoffset, 1) != 1) return -1;
+	if (readboard(bf, &spr->picnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->ang, 2) != 2) return -1;
+	if (readboard(bf, &spr->xvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->yvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->zvel, 2) != 2) return -1;
+	if (readboard(bf, &spr->owner, 2) != 2) return -1;
+	if (readboard(bf, &spr->sectnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->statnum, 2) != 2) return -1;
+	if (readboard(bf, &spr->lotag, 2) != 2) return -1;
+	if (readboard(bf, &spr->hitag, 2) != 2) return -1;
+	if (readboard(bf, &spr->extra, 2) != 2) return -1;
 
 	spr->x = B_LITTLE32(spr->x);
 	spr->y = B_LITTLE32(spr->y);
@@ -7449,16 +7804,21 @@ int loadoldboard(char *filename, char fromwhere, int *daposx, int *daposy, int *
 	struct sectortypev6 v6sect;
 	struct walltypev6   v6wall;
 	struct spritetypev6 v6spr;
+	boardfile bf;
 
 	i = strlen(filename)-1;
 	if ((unsigned char)filename[i] == 255) { filename[i] = 0; fromwhere = 1; }	// JBF 20040119: "compatibility"
 	if ((fil = kopen4load(filename,fromwhere)) == -1)
 		{ mapversion = 5L; return(-1); }
 
-	if (kread(fil,&mapversion,4) != 4) goto readerror;
+	i = openboardfile(&bf,fil);
+	kclose(fil);
+	if (i) { mapversion = 5L; return(-3); }
+
+	if (readboard(&bf,&mapversion,4) != 4) goto readerror;
 	mapversion = B_LITTLE32(mapversion);
 	if (mapversion != 4L && mapversion != 5L && mapversion != 6L) {
-		kclose(fil);
+		closeboardfile(&bf);
 		return(-2);
 	}
 
@@ -7468,11 +7828,11 @@ int loadoldboard(char *filename, char fromwhere, int *daposx, int *daposy, int *
 	clearbuf(&show2dsprite[0],(int)((MAXSPRITES+3)>>5),0L);
 	clearbuf(&show2dwall[0],(int)((MAXWALLS+3)>>5),0L);
 
-	if (kread(fil,daposx,4) != 4) goto readerror;
-	if (kread(fil,daposy,4) != 4) goto readerror;
-	if (kread(fil,daposz,4) != 4) goto readerror;
-	if (kread(fil,daang,2) != 2) goto readerror;
-	if (kread(fil,dacursectnum,2) != 2) goto readerror;
+	if (readboard(&bf,daposx,4) != 4) goto readerror;
+	if (readboard(&bf,daposy,4) != 4) goto readerror;
+	if (readboard(&bf,daposz,4) != 4) goto readerror;
+	if (readboard(&bf,daang,2) != 2) goto readerror;
+	if (readboard(&bf,dacursectnum,2) != 2) goto readerror;
 	*daposx = B_LITTLE32(*daposx);
 	*daposy = B_LITTLE32(*daposy);
 	*daposz = B_LITTLE32(*daposz);
@@ -7480,101 +7840,100 @@ int loadoldboard(char *filename, char fromwhere, int *daposx, int *daposy, int *
 	*dacursectnum = B_LITTLE16(*dacursectnum);
 
 	if (mapversion == 4) {
-		if (kread(fil,&numsectors,2) != 2) goto readerror;
-		if (kread(fil,&numwalls,2) != 2) goto readerror;
-		if (kread(fil,&numsprites,2) != 2) goto readerror;
+		if (readboard(&bf,&numsectors,2) != 2) goto readerror;
+		if (readboard(&bf,&numwalls,2) != 2) goto readerror;
+		if (readboard(&bf,&numsprites,2) != 2) goto readerror;
 	}
 
-	if (mapversion > 4 && kread(fil,&numsectors,2) != 2) goto readerror;
+	if (mapversion > 4 && readboard(&bf,&numsectors,2) != 2) goto readerror;
 	numsectors = B_LITTLE16(numsectors);
 	if (numsectors > MAXSECTORS) {
-		kclose(fil);
+		closeboardfile(&bf);
 		return(-1);
 	}
 
 	for (i=0; i<numsectors; i++) {
 		switch (mapversion) {
 			case 4:
-				if (readv4sect(fil,&v4sect)) goto readerror;
+				if (readv4sect(&bf,&v4sect)) goto readerror;
 				convertv4sectv5(&v4sect,&v5sect);
 				convertv5sectv6(&v5sect,&v6sect);
 				convertv6sectv7(&v6sect,&sector[i]);
 				break;
 			case 5:
-				if (readv5sect(fil,&v5sect)) goto readerror;
+				if (readv5sect(&bf,&v5sect)) goto readerror;
 				convertv5sectv6(&v5sect,&v6sect);
 				convertv6sectv7(&v6sect,&sector[i]);
 				break;
 			case 6:
-				if (readv6sect(fil,&v6sect)) goto readerror;
+				if (readv6sect(&bf,&v6sect)) goto readerror;
 				convertv6sectv7(&v6sect,&sector[i]);
 				break;
 		}
 	}
 
-	if (mapversion > 4 && kread(fil,&numwalls,2) != 2) goto readerror;
+	if (mapversion > 4 && readboard(&bf,&numwalls,2) != 2) goto readerror;
 	numwalls = B_LITTLE16(numwalls);
 	if (numwalls > MAXWALLS) {
-		kclose(fil);
+		closeboardfile(&bf);
 		return(-1);
 	}
 
 	for (i=0; i<numwalls; i++) {
 		switch (mapversion) {
 			case 4:
-				if (readv4wall(fil,&v4wall)) goto readerror;
+				if (readv4wall(&bf,&v4wall)) goto readerror;
 				convertv4wallv5(&v4wall,&v5wall);
 				convertv5wallv6(&v5wall,&v6wall,i);
 				convertv6wallv7(&v6wall,&wall[i]);
 				break;
 			case 5:
-				if (readv5wall(fil,&v5wall)) goto readerror;
+				if (readv5wall(&bf,&v5wall)) goto readerror;
 				convertv5wallv6(&v5wall,&v6wall,i);
 				convertv6wallv7(&v6wall,&wall[i]);
 				break;
 			case 6:
-				if (readv6wall(fil,&v6wall)) goto readerror;
+				if (readv6wall(&bf,&v6wall)) goto readerror;
 				convertv6wallv7(&v6wall,&wall[i]);
 				break;
 		}
 	}
 
-	if (mapversion > 4 && kread(fil,&numsprites,2) != 2) goto readerror;
+	if (mapversion > 4 && readboard(&bf,&numsprites,2) != 2) goto readerror;
 	numsprites = B_LITTLE16(numsprites);
 	if (numsprites > MAXSPRITES) {
-		kclose(fil);
+		closeboardfile(&bf);
 		return(-1);
 	}
 
 	for (i=0; i<numsprites; i++) {
 		switch (mapversion) {
 			case 4:
-				if (readv4sprite(fil,&v4spr)) goto readerror;
+				if (readv4sprite(&bf,&v4spr)) goto readerror;
 				convertv4sprv5(&v4spr,&v5spr);
 				convertv5sprv6(&v5spr,&v6spr);
 				convertv6sprv7(&v6spr,&sprite[i]);
 				break;
 			case 5:
-				if (readv5sprite(fil,&v5spr)) goto readerror;
+				if (readv5sprite(&bf,&v5spr)) goto readerror;
 				convertv5sprv6(&v5spr,&v6spr);
 				convertv6sprv7(&v6spr,&sprite[i]);
 				break;
 			case 6:
-				if (readv6sprite(fil,&v6spr)) goto readerror;
+				if (readv6sprite(&bf,&v6spr)) goto readerror;
 				convertv6sprv7(&v6spr,&sprite[i]);
 				break;
 		}
-	}
-
-	for(i=0;i<numsprites;i++) {
 		if ((sprite[i].cstat & 48) == 48) sprite[i].cstat &= ~48;
 		insertsprite(sprite[i].sectnum,sprite[i].statnum);
 	}
 
+	initmapaccel();
+
 		//Must be after loading sectors, etc!
 	updatesector(*daposx,*daposy,dacursectnum);
 
-	kclose(fil);
+	closeboardfile(&bf);
 
 #if USE_POLYMOST && USE_OPENGL
 	memset(spriteext, 0, sizeof(spriteext));
@@ -7584,7 +7943,7 @@ int loadoldboard(char *filename, char fromwhere, int *daposx, int *daposy, int *
 	return(0);
 
 readerror:
-	kclose(fil);
+	closeboardfile(&bf);
 	return -3;
 }
 
@@ -8117,6 +8476,8 @@ void nextpage(void)
 	}
 	faketimerhandler();
 
+	if (tileprefetch && !editstatus) prefetchtiles();
+
 	if ((totalclock >= lastageclock+8) || (totalclock < lastageclock))
 		{ lastageclock = totalclock; agecache(); }
 
@@ -8140,6 +8501,7 @@ int loadpics(char *filename, int askedsize)
 
 	Bstrcpy(artfilename,filename);
 
+	unmapartfiles();
 	for(i=0;i<MAXTILES;i++)
 	{
 		tilesizx[i] = 0;
@@ -8185,6 +8547,7 @@ int loadpics(char *filename, int askedsize)
 				offscount += dasiz;
 				artsize += ((dasiz+15)&0xfffffff0);
 			}
+			artmapbase[k] = (const char *)kmap(fil,&artmapleng[k],&artmaphand[k]);
 			kclose(fil);
 
 			numtilefiles++;
@@ -8227,32 +8590,119 @@ int loadpics(char *filename, int askedsize)
 
 
 //
-// loadtile
+// unmapartfiles
+//  Releases the ART file mappings, forgetting any tiles pointing into them
 //
-char cachedebug = 0;
-void loadtile(short tilenume)
+static void unmapartfiles(void)
 {
-	char *ptr;
-	int i, dasiz;
+	int i;
+
+	for(i=0;i<MAXTILES;i++)
+		if (tilemapped[i>>3] & pow2char[i&7]) waloff[i] = 0;
+	clearbuf(tilemapped,(int)(sizeof(tilemapped)>>2),0L);
+
+	for(i=0;i<256;i++)
+	{
+		if (artmaphand[i]) kunmap(artmaphand[i]);
+		artmapbase[i] = NULL;
+		artmapleng[i] = 0;
+		artmaphand[i] = NULL;
+	}
+}
+
+
+//
+// maptile
+//  Points a tile at its pixels in the mapped ART file. Returns 0 if the file
+//  isn't mapped, so the tile must be read into the cache instead.
+//
+static int maptile(short tilenume)
+{
+	int filenum, dasiz;
+
+	if (tilemapped[tilenume>>3] & pow2char[tilenume&7]) return 1;
+	if (waloff[tilenume]) return 0;
+
+	filenum = tilefilenum[tilenume];
+	dasiz = tilesizx[tilenume]*tilesizy[tilenume];
+	if (!artmapbase[filenum] || (tilefileoffs[tilenume]+dasiz > artmapleng[filenum])) return 0;
+
+	waloff[tilenume] = (intptr_t)(artmapbase[filenum]+tilefileoffs[tilenume]);
+	tilemapped[tilenume>>3] |= pow2char[tilenume&7];
+	return 1;
+}
+
+
+//
+// unmaptile
+//  Gives a tile pointing into a mapped ART file its own copy in the cache,
+//  so it can be written to
+//
+static void unmaptile(short tilenume)
+{
+	const char *src;
+	int dasiz, leng;
 
 	if ((unsigned)tilenume >= (unsigned)MAXTILES) return;
+	if (!(tilemapped[tilenume>>3] & pow2char[tilenume&7])) return;
+	tilemapped[tilenume>>3] &= ~pow2char[tilenume&7];
+
+	src = (const char *)waloff[tilenume];
 	dasiz = tilesizx[tilenume]*tilesizy[tilenume];
-	if (dasiz <= 0) return;
+	leng = min(dasiz, artmapleng[tilefilenum[tilenume]]-tilefileoffs[tilenume]);
+
+	waloff[tilenume] = 0;
+	if (walock[tilenume] < 200) walock[tilenume] = 199;
+	allocache((void **)&waloff[tilenume],dasiz,&walock[tilenume]);
+	memcpy((void *)waloff[tilenume],src,leng);
+	if (leng < dasiz) clearbufbyte((void *)(waloff[tilenume]+leng),dasiz-leng,0L);
+}
+
 
-	i = tilefilenum[tilenume];
-	if (i != artfilnum)
+//
+// seekartfile
+//  Makes ART file 'filenum' the open one and moves to offset 'offs' in it
+//
+static void seekartfile(int filenum, int offs)
+{
+	if (filenum != artfilnum)
 	{
 		if (artfil != -1) kclose(artfil);
-		artfilnum = i;
+		artfilnum = filenum;
 		artfilplc = 0L;
 
-		artfilename[7] = (i%10)+48;
-		artfilename[6] = ((i/10)%10)+48;
-		artfilename[5] = ((i/100)%10)+48;
+		artfilename[7] = (filenum%10)+48;
+		artfilename[6] = ((filenum/10)%10)+48;
+		artfilename[5] = ((filenum/100)%10)+48;
 		artfil = kopen4load(artfilename,0);
 		faketimerhandler();
 	}
 
+	if (artfilplc != offs)
+	{
+		klseek(artfil,offs-artfilplc,BSEEK_CUR);
+		faketimerhandler();
+	}
+}
+
+
+//
+// loadtile
+//
+char cachedebug = 0;
+void loadtile(short tilenume)
+{
+	char *ptr;
+	int dasiz;
+
+	if ((unsigned)tilenume >= (unsigned)MAXTILES) return;
+	dasiz = tilesizx[tilenume]*tilesizy[tilenume];
+	if (dasiz <= 0) return;
+
+	if (maptile(tilenume)) return;
+
+	seekartfile(tilefilenum[tilenume], tilefileoffs[tilenume]);
+
 	if (cachedebug) buildprintf("Tile:%d\n",tilenume);
 
 	if (waloff[tilenume] == 0)
@@ -8261,11 +8711,6 @@ void loadtile(short tilenume)
 		allocache((void **)&waloff[tilenume],dasiz,&walock[tilenume]);
 	}
 
-	if (artfilplc != tilefileoffs[tilenume])
-	{
-		klseek(artfil,tilefileoffs[tilenume]-artfilplc,BSEEK_CUR);
-		faketimerhandler();
-	}
 	ptr = (char *)waloff[tilenume];
 	kread(artfil,ptr,dasiz);
 	faketimerhandler();
@@ -8273,6 +8718,110 @@ void loadtile(short tilenume)
 }
 
 
+//
+// precachetiles_begin
+//  Queues every tile flagged in gotpic that isn't in the cache to be loaded
+//  by precachetiles_run(), in the order the tiles lie in the ART files.
+//  Returns the number of bytes to be loaded.
+//
+static int precachetilecmp(const void *a, const void *b)
+{
+	int i = *(const short *)a, j = *(const short *)b;
+
+	if (tilefilenum[i] != tilefilenum[j]) return (int)tilefilenum[i] - (int)tilefilenum[j];
+	return tilefileoffs[i] - tilefileoffs[j];
+}
+
+int precachetiles_begin(void)
+{
+	int i;
+
+	precachenum = precachepos = 0;
+	precachedone = precachetotal = 0;
+
+	for(i=0;i<MAXTILES;i++)
+	{
+		if (!(gotpic[i>>3] & pow2char[i&7])) continue;
+		if (waloff[i] || (tilesizx[i] <= 0) || (tilesizy[i] <= 0)) continue;
+		if (maptile((short)i)) continue;
+		precachelist[precachenum++] = (short)i;
+		precachetotal += tilesizx[i]*tilesizy[i];
+	}
+	qsort(precachelist, precachenum, sizeof(short), precachetilecmp);
+
+	if ((precachenum > 1) && !precachebuf)
+		precachebuf = (char *)kmalloc(PRECACHEBUFSIZ);
+
+	return precachetotal;
+}
+
+//
+// precachetiles_run
+//  Loads the next run of tiles queued by precachetiles_begin(). Tiles lying
+//  close together in the same ART file are fetched with a single read.
+//  Returns !0 while there are tiles left to load.
+//
+int precachetiles_run(int *done, int *total)
+{
+	int i, first, last, runstart, runend, dasiz;
+
+	if (precachepos >= precachenum)
+	{
+		if (precachebuf) { kfree(precachebuf); precachebuf = NULL; }
+		*done = precachedone;
+		*total = precachetotal;
+		return 0;
+	}
+
+	first = precachepos;
+	i = precachelist[first];
+	runstart = tilefileoffs[i];
+	runend = runstart + tilesizx[i]*tilesizy[i];
+
+	for(last=first+1;(last<precachenum) && precachebuf;last++)
+	{
+		i = precachelist[last];
+		dasiz = tilesizx[i]*tilesizy[i];
+		if (tilefilenum[i] != tilefilenum[precachelist[first]]) break;
+		if (tilefileoffs[i]-runend > PRECACHEGAP) break;
+		if (tilefileoffs[i]+dasiz-runstart > PRECACHEBUFSIZ) break;
+		runend = max(runend, tilefileoffs[i]+dasiz);
+	}
+
+	if (last == first+1)
+	{
+		loadtile(precachelist[first]);
+		precachedone += runend-runstart;
+	}
+	else
+	{
+		seekartfile(tilefilenum[precachelist[first]], runstart);
+		i = max(kread(artfil,precachebuf,runend-runstart), 0);
+		faketimerhandler();
+		artfilplc = runstart+i;
+		if (i < runend-runstart) memset(precachebuf+i, 0, runend-runstart-i);
+
+		for(;first<last;first++)
+		{
+			i = precachelist[first];
+			dasiz = tilesizx[i]*tilesizy[i];
+			if (waloff[i] == 0)
+			{
+				walock[i] = 199;
+				allocache((void **)&waloff[i],dasiz,&walock[i]);
+			}
+			memcpy((void *)waloff[i], precachebuf+tilefileoffs[i]-runstart, dasiz);
+			precachedone += dasiz;
+		}
+	}
+	precachepos = last;
+
+	*done = precachedone;
+	*total = precachetotal;
+	return 1;
+}
+
+
 //
 // allocatepermanenttile
 //
@@ -8285,6 +8834,7 @@ intptr_t allocatepermanenttile(short tilenume, int xsiz, int ysiz)
 
 	dasiz = xsiz*ysiz;
 
+	tilemapped[tilenume>>3] &= ~pow2char[tilenume&7];
 	walock[tilenume] = 255;
 	allocache((void **)&waloff[tilenume],dasiz,&walock[tilenume]);
 
@@ -8316,6 +8866,7 @@ void copytilepiece(int tilenume1, int sx1, int sy1, int xsiz, int ysiz,
 	{
 		if (waloff[tilenume1] == 0) loadtile(tilenume1);
 		if (waloff[tilenume2] == 0) loadtile(tilenume2);
+		unmaptile(tilenume2);
 
 		x1 = sx1;
 		for(i=0;i<xsiz;i++)
@@ -8450,6 +9001,11 @@ int inside(int x, int y, short sectnum)
 	unsigned int cnt;
 
 	if ((sectnum < 0) || (sectnum >= numsectors)) return(-1);
+	if (MAPACCEL)
+	{
+		if ((x < sectbox[sectnum][0]) || (x > sectbox[sectnum][2])) return(0);
+		if ((y < sectbox[sectnum][1]) || (y > sectbox[sectnum][3])) return(0);
+	}
 
 	cnt = 0;
 	wal = &wall[sector[sectnum].wallptr];
@@ -9119,6 +9675,7 @@ void dragpoint(short pointhighlight, int dax, int day)
 
 	wall[pointhighlight].x = dax;
 	wall[pointhighlight].y = day;
+	movemapaccel(pointhighlight);
 
 	cnt = MAXWALLS;
 	tempshort = pointhighlight;    //search points CCW
@@ -9129,6 +9686,7 @@ void dragpoint(short pointhighlight, int dax, int day)
 			tempshort = wall[wall[tempshort].nextwall].point2;
 			wall[tempshort].x = dax;
 			wall[tempshort].y = day;
+			movemapaccel(tempshort);
 		}
 		else
 		{
@@ -9140,6 +9698,7 @@ void dragpoint(short pointhighlight, int dax, int day)
 					tempshort = wall[lastwall(tempshort)].nextwall;
 					wall[tempshort].x = dax;
 					wall[tempshort].y = day;
+					movemapaccel(tempshort);
 				}
 				else
 				{
@@ -10346,6 +10905,7 @@ void clearview(int dacol)
 					  ((float)p.g)/255.0,
 					  ((float)p.b)/255.0,
 					  0);
+		polymost_flushrotatesprites();
 		glfunc.glScissor(windowx1,yres-(windowy2+1),windowx2-windowx1+1,windowy2-windowy1+1);
 		glfunc.glEnable(GL_SCISSOR_TEST);
 		glfunc.glClear(GL_COLOR_BUFFER_BIT);
@@ -10382,6 +10942,7 @@ void clearallviews(int dacol)
 			p.g = britable[curbrightness][ curpalette[dacol].g ];
 			p.b = britable[curbrightness][ curpalette[dacol].b ];
 		}
+		polymost_flushrotatesprites();
 		glfunc.glViewport(0,0,xdim,ydim); glox1 = -1;
 		glfunc.glClearColor(((float)p.r)/255.0,
 					  ((float)p.g)/255.0,
@@ -10434,6 +10995,8 @@ void setviewtotile(short tilenume, int xsiz, int ysiz)
 {
 	int i, j;
 
+	unmaptile(tilenume);
+
 		//DRAWROOMS TO TILE BACKUP&SET CODE
 	tilesizx[tilenume] = xsiz; tilesizy[tilenume] = ysiz;
 	bakxsiz[setviewcnt] = xsiz; bakysiz[setviewcnt] = ysiz;
@@ -10501,6 +11064,7 @@ void squarerotatetile(short tilenume)
 	int i, j, k, xsiz, ysiz;
 	unsigned char *ptr1, *ptr2;
 
+	unmaptile(tilenume);
 	xsiz = tilesizx[tilenume]; ysiz = tilesizy[tilenume];
 
 		//supports square tiles only for rotation part
@@ -10578,6 +11142,7 @@ int sectorofwall(short theline)
 	int i, gap;
 
 	if ((theline < 0) || (theline >= numwalls)) return(-1);
+	if (MAPACCEL) return(wallsect[theline]);
 	i = wall[theline].nextwall; if (i >= 0) return(wall[i].nextsector);
 
 	gap = (numsectors>>1); i = gap;
@@ -10603,7 +11168,8 @@ int getceilzofslope(short sectnum, int dax, int day)
 	if (!(sector[sectnum].ceilingstat&2)) return(sector[sectnum].ceilingz);
 	wal = &wall[sector[sectnum].wallptr];
 	dx = wall[wal->point2].x-wal->x; dy = wall[wal->point2].y-wal->y;
-	i = (nsqrtasm(dx*dx+dy*dy)<<5); if (i == 0) return(sector[sectnum].ceilingz);
+	i = MAPACCEL ? sectslopelen[sectnum] : (int)(nsqrtasm(dx*dx+dy*dy)<<5);
+	if (i == 0) return(sector[sectnum].ceilingz);
 	j = dmulscale3(dx,day-wal->y,-dy,dax-wal->x);
 	return(sector[sectnum].ceilingz+scale(sector[sectnum].ceilingheinum,j,i));
 }
@@ -10620,7 +11186,8 @@ int getflorzofslope(short sectnum, int dax, int day)
 	if (!(sector[sectnum].floorstat&2)) return(sector[sectnum].floorz);
 	wal = &wall[sector[sectnum].wallptr];
 	dx = wall[wal->point2].x-wal->x; dy = wall[wal->point2].y-wal->y;
-	i = (nsqrtasm(dx*dx+dy*dy)<<5); if (i == 0) return(sector[sectnum].floorz);
+	i = MAPACCEL ? sectslopelen[sectnum] : (int)(nsqrtasm(dx*dx+dy*dy)<<5);
+	if (i == 0) return(sector[sectnum].floorz);
 	j = dmulscale3(dx,day-wal->y,-dy,dax-wal->x);
 	return(sector[sectnum].floorz+scale(sector[sectnum].floorheinum,j,i));
 }
@@ -10641,7 +11208,8 @@ void getzsofslope(short sectnum, int dax, int day, int *ceilz, int *florz)
 	{
 		wal = &wall[sec->wallptr]; wal2 = &wall[wal->point2];
 		dx = wal2->x-wal->x; dy = wal2->y-wal->y;
-		i = (nsqrtasm(dx*dx+dy*dy)<<5); if (i == 0) return;
+		i = MAPACCEL ? sectslopelen[sectnum] : (int)(nsqrtasm(dx*dx+dy*dy)<<5);
+		if (i == 0) return;
 		j = dmulscale3(dx,day-wal->y,-dy,dax-wal->x);
 		if (sec->ceilingstat&2) *ceilz = (*ceilz)+scale(sec->ceilingheinum,j,i);
 		if (sec->floorstat&2) *florz = (*florz)+scale(sec->floorheinum,j,i);
@@ -10942,6 +11510,8 @@ static int screencapture_writeframe(BFILE *fil, char mode, void *v,
 	if (rendmode >= 3 && qsetmode == 200) {
 		char bgr = (mode & 4);
 
+		polymost_flushrotatesprites();
+
 		// OpenGL returns bottom-to-top ordered lines.
 		if (bottotop) {
 			ystart = 0;
@@ -11424,6 +11994,8 @@ void setpolymost2dview(void)
 {
 	if (rendmode < 3) return;
 
+	polymost_flushrotatesprites();
+
 	if (gloy1 != -1) {
 		glfunc.glViewport(0,0,xres,yres);
 	}
@@ -0,0 +1,842 @@
+// glbuild_null.c — recording OpenGL backend that renders nothing.
+//
+// Link this in place of glbuild.c (and build with -DGLBUILD_NULL so the
+// SDL layer skips context creation) to run Polymost without a GPU. Every
+// call through glfunc is counted, state changes are told apart from
+// redundant sets, texture and buffer uploads are totalled in bytes, and
+// the results are reported per frame. What remains of the frame time is
+// the CPU cost of the renderer and the game.
+
+#include "build.h"
+
+#if USE_OPENGL
+
+#include "glbuild_priv.h"
+#include "osd.h"
+#include "baselayer.h"
+#include "baselayer_priv.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+struct glbuild_funcs glfunc;
+
+static const GLubyte null_gl_version[]    = "2.1 Null";
+static const GLubyte null_gl_vendor[]     = "JFBuild";
+static const GLubyte null_gl_renderer[]   = "Recording null renderer";
+static const GLubyte null_gl_extensions[] = "GL_EXT_texture_filter_anisotropic "
+                                            "GL_EXT_bgra "
+                                            "GL_EXT_texture_compression_s3tc "
+                                            "GL_ARB_texture_non_power_of_two "
+                                            "GL_ARB_shading_language_100";
+static const GLubyte null_glsl_version[]  = "1.10";
+
+#define NULLMAXUNITS 4
+#define NULLMAXUNIFORMS 64
+
+struct nullglstats {
+	unsigned int calls;         // Every entry point.
+	unsigned int statechanges;  // Sets that altered tracked state.
+	unsigned int redundant;     // Sets that repeated the current state.
+	unsigned int draws;
+	unsigned int indexes;
+	unsigned int texuploads;
+	unsigned int texbytes;
+	unsigned int bufuploads;
+	unsigned int bufbytes;
+	unsigned int uniformbytes;
+	unsigned int usecs;         // Wall time from the previous frame end.
+};
+
+static struct nullglstats framestats, totalstats, peakstats;
+static unsigned int numrecorded = 0;
+static unsigned int lastframeusec = 0;
+static int glnulllog = 0;
+
+static struct {
+	unsigned char caps[16];
+	GLenum blendsrc, blenddst;
+	GLenum cullface, frontface;
+	GLenum depthfunc;
+	GLboolean depthmask;
+	GLboolean colourmask[4];
+	GLint viewport[4];
+	GLenum activetexture;
+	GLuint boundtexture[NULLMAXUNITS];
+	GLuint arraybuffer, elementbuffer;
+	GLuint program;
+	GLuint nextid;
+} nullstate;
+
+static char uniformnames[NULLMAXUNIFORMS][32];
+static int numuniformnames = 0;
+
+static int osdcmd_glinfo(const osdfuncparm_t *);
+static int osdcmd_glnullstats(const osdfuncparm_t *);
+static int osdcmd_vars(const osdfuncparm_t *);
+
+#define CALL() (framestats.calls++)
+
+static void statechange(int changed)
+{
+	if (changed) framestats.statechanges++;
+	else framestats.redundant++;
+}
+
+static int capindex(GLenum cap)
+{
+	switch (cap) {
+		case GL_BLEND:        return 0;
+		case GL_DEPTH_TEST:   return 1;
+		case GL_CULL_FACE:    return 2;
+		case GL_SCISSOR_TEST: return 3;
+		case GL_TEXTURE_2D:   return 4;
+#if (USE_OPENGL != USE_GLES2)
+		case GL_MULTISAMPLE:  return 5;
+#endif
+		default:              return 15;
+	}
+}
+
+static int texelbytes(GLenum format, GLenum type)
+{
+	int comps;
+
+	switch (format) {
+		case GL_RGBA: case GL_BGRA: comps = 4; break;
+		case GL_RGB:                comps = 3; break;
+		case GL_LUMINANCE_ALPHA:    comps = 2; break;
+		default:                    comps = 1; break;
+	}
+	if (type == GL_UNSIGNED_BYTE) return comps;
+	return comps * 4;
+}
+
+static void APIENTRY null_glClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+	(void)r; (void)g; (void)b; (void)a;
+	CALL();
+}
+
+static void APIENTRY null_glClear(GLbitfield mask)
+{
+	(void)mask;
+	CALL();
+}
+
+static void APIENTRY null_glColorMask(GLboolean r, GLboolean g, GLboolean b, GLboolean a)
+{
+	CALL();
+	statechange(nullstate.colourmask[0] != r || nullstate.colourmask[1] != g ||
+		nullstate.colourmask[2] != b || nullstate.colourmask[3] != a);
+	nullstate.colourmask[0] = r; nullstate.colourmask[1] = g;
+	nullstate.colourmask[2] = b; nullstate.colourmask[3] = a;
+}
+
+static void APIENTRY null_glBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	CALL();
+	statechange(nullstate.blendsrc != sfactor || nullstate.blenddst != dfactor);
+	nullstate.blendsrc = sfactor;
+	nullstate.blenddst = dfactor;
+}
+
+static void APIENTRY null_glCullFace(GLenum mode)
+{
+	CALL();
+	statechange(nullstate.cullface != mode);
+	nullstate.cullface = mode;
+}
+
+static void APIENTRY null_glFrontFace(GLenum mode)
+{
+	CALL();
+	statechange(nullstate.frontface != mode);
+	nullstate.frontface = mode;
+}
+
+static void APIENTRY null_glPolygonOffset(GLfloat factor, GLfloat units)
+{
+	(void)factor; (void)units;
+	CALL();
+	statechange(1);
+}
+
+#if (USE_OPENGL != USE_GLES2)
+static void APIENTRY null_glPolygonMode(GLenum face, GLenum mode)
+{
+	(void)face; (void)mode;
+	CALL();
+	statechange(1);
+}
+#endif
+
+static void APIENTRY null_glEnable(GLenum cap)
+{
+	int i = capindex(cap);
+	CALL();
+	statechange(!nullstate.caps[i]);
+	nullstate.caps[i] = 1;
+}
+
+static void APIENTRY null_glDisable(GLenum cap)
+{
+	int i = capindex(cap);
+	CALL();
+	statechange(nullstate.caps[i]);
+	nullstate.caps[i] = 0;
+}
+
+static void APIENTRY null_glGetFloatv(GLenum pname, GLfloat *data)
+{
+	CALL();
+	if (!data) return;
+#ifdef GL_EXT_texture_filter_anisotropic
+	if (pname == GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT) { *data = 16.f; return; }
+#endif
+	(void)pname;
+	*data = 0.f;
+}
+
+static void APIENTRY null_glGetIntegerv(GLenum pname, GLint *data)
+{
+	CALL();
+	if (!data) return;
+	switch (pname) {
+		case GL_MAX_TEXTURE_SIZE:        *data = 4096; break;
+		case GL_MAX_TEXTURE_IMAGE_UNITS: *data = NULLMAXUNITS; break;
+		case GL_MAX_VERTEX_ATTRIBS:      *data = 16; break;
+		case GL_VIEWPORT:                memcpy(data, nullstate.viewport, sizeof(nullstate.viewport)); break;
+		default:                         *data = 0; break;
+	}
+}
+
+static const GLubyte * APIENTRY null_glGetString(GLenum name)
+{
+	CALL();
+	switch (name) {
+		case GL_VERSION:                  return null_gl_version;
+		case GL_VENDOR:                   return null_gl_vendor;
+		case GL_RENDERER:                 return null_gl_renderer;
+		case GL_EXTENSIONS:               return null_gl_extensions;
+		case GL_SHADING_LANGUAGE_VERSION: return null_glsl_version;
+		default:                          return (const GLubyte *)"";
+	}
+}
+
+#if (USE_OPENGL == USE_GL3)
+static const GLubyte * APIENTRY null_glGetStringi(GLenum name, GLuint index)
+{
+	(void)name; (void)index;
+	CALL();
+	return (const GLubyte *)"";
+}
+#endif
+
+static GLenum APIENTRY null_glGetError(void) { CALL(); return GL_NO_ERROR; }
+static void APIENTRY null_glHint(GLenum target, GLenum mode) { (void)target; (void)mode; CALL(); }
+static void APIENTRY null_glPixelStorei(GLenum pname, GLint param) { (void)pname; (void)param; CALL(); }
+
+static void APIENTRY null_glViewport(GLint x, GLint y, GLsizei w, GLsizei h)
+{
+	CALL();
+	statechange(nullstate.viewport[0] != x || nullstate.viewport[1] != y ||
+		nullstate.viewport[2] != w || nullstate.viewport[3] != h);
+	nullstate.viewport[0] = x; nullstate.viewport[1] = y;
+	nullstate.viewport[2] = w; nullstate.viewport[3] = h;
+}
+
+static void APIENTRY null_glScissor(GLint x, GLint y, GLsizei w, GLsizei h)
+{
+	(void)x; (void)y; (void)w; (void)h;
+	CALL();
+	statechange(1);
+}
+
+#if (USE_OPENGL != USE_GLES2)
+static void APIENTRY null_glMinSampleShadingARB(GLfloat val) { (void)val; CALL(); }
+#endif
+
+static void APIENTRY null_glDepthFunc(GLenum func)
+{
+	CALL();
+	statechange(nullstate.depthfunc != func);
+	nullstate.depthfunc = func;
+}
+
+static void APIENTRY null_glDepthMask(GLboolean flag)
+{
+	CALL();
+	statechange(nullstate.depthmask != flag);
+	nullstate.depthmask = flag;
+}
+
+#if (USE_OPENGL == USE_GLES2)
+static void APIENTRY null_glDepthRangef(GLfloat n, GLfloat f)
+#else
+static void APIENTRY null_glDepthRange(GLdouble n, GLdouble f)
+#endif
+{
+	(void)n; (void)f;
+	CALL();
+	statechange(1);
+}
+
+static void APIENTRY null_glReadPixels(GLint x, GLint y, GLsizei w, GLsizei h, GLenum fmt, GLenum type, void *px)
+{
+	(void)x; (void)y;
+	CALL();
+	if (px) memset(px, 0, w * h * texelbytes(fmt, type));
+}
+
+static void APIENTRY null_glGenTextures(GLsizei n, GLuint *textures)
+{
+	GLsizei i;
+	CALL();
+	for (i = 0; i < n; i++) textures[i] = nullstate.nextid++;
+}
+
+static void APIENTRY null_glDeleteTextures(GLsizei n, const GLuint *textures)
+{
+	GLsizei i;
+	int u;
+	CALL();
+	for (i = 0; i < n; i++) {
+		for (u = 0; u < NULLMAXUNITS; u++) {
+			if (nullstate.boundtexture[u] == textures[i]) nullstate.boundtexture[u] = 0;
+		}
+	}
+}
+
+static void APIENTRY null_glBindTexture(GLenum target, GLuint texture)
+{
+	int unit = nullstate.activetexture - GL_TEXTURE0;
+	(void)target;
+	CALL();
+	if (unit < 0 || unit >= NULLMAXUNITS) unit = 0;
+	statechange(nullstate.boundtexture[unit] != texture);
+	nullstate.boundtexture[unit] = texture;
+}
+
+static void APIENTRY null_glTexImage2D(GLenum target, GLint level, GLint ifmt,
+	GLsizei w, GLsizei h, GLint border, GLenum fmt, GLenum type, const void *px)
+{
+	(void)target; (void)level; (void)ifmt; (void)border;
+	CALL();
+	framestats.texuploads++;
+	if (px) framestats.texbytes += w * h * texelbytes(fmt, type);
+}
+
+static void APIENTRY null_glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset,
+	GLsizei w, GLsizei h, GLenum fmt, GLenum type, const void *px)
+{
+	(void)target; (void)level; (void)xoffset; (void)yoffset;
+	CALL();
+	framestats.texuploads++;
+	if (px) framestats.texbytes += w * h * texelbytes(fmt, type);
+}
+
+static void APIENTRY null_glCompressedTexImage2D(GLenum target, GLint level, GLenum ifmt,
+	GLsizei w, GLsizei h, GLint border, GLsizei size, const void *data)
+{
+	(void)target; (void)level; (void)ifmt; (void)w; (void)h; (void)border;
+	CALL();
+	framestats.texuploads++;
+	if (data) framestats.texbytes += size;
+}
+
+static void APIENTRY null_glTexParameterf(GLenum target, GLenum pname, GLfloat param)
+{
+	(void)target; (void)pname; (void)param;
+	CALL();
+	statechange(1);
+}
+
+static void APIENTRY null_glTexParameteri(GLenum target, GLenum pname, GLint param)
+{
+	(void)target; (void)pname; (void)param;
+	CALL();
+	statechange(1);
+}
+
+static void APIENTRY null_glBindBuffer(GLenum target, GLuint buffer)
+{
+	GLuint *slot = (target == GL_ARRAY_BUFFER) ? &nullstate.arraybuffer : &nullstate.elementbuffer;
+	CALL();
+	statechange(*slot != buffer);
+	*slot = buffer;
+}
+
+static void APIENTRY null_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+	(void)target; (void)usage;
+	CALL();
+	framestats.bufuploads++;
+	if (data) framestats.bufbytes += (unsigned int)size;
+}
+
+static void APIENTRY null_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+{
+	(void)target; (void)offset;
+	CALL();
+	framestats.bufuploads++;
+	if (data) framestats.bufbytes += (unsigned int)size;
+}
+
+static void APIENTRY null_glGenBuffers(GLsizei n, GLuint *bufs)
+{
+	GLsizei i;
+	CALL();
+	for (i = 0; i < n; i++) bufs[i] = nullstate.nextid++;
+}
+
+static void APIENTRY null_glDeleteBuffers(GLsizei n, const GLuint *bufs)
+{
+	(void)n; (void)bufs;
+	CALL();
+}
+
+static void APIENTRY null_glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+	(void)mode; (void)type; (void)indices;
+	CALL();
+	framestats.draws++;
+	framestats.indexes += count;
+}
+
+static void APIENTRY null_glEnableVertexAttribArray(GLuint index) { (void)index; CALL(); statechange(1); }
+static void APIENTRY null_glDisableVertexAttribArray(GLuint index) { (void)index; CALL(); statechange(1); }
+
+static void APIENTRY null_glVertexAttribPointer(GLuint index, GLint size, GLenum type,
+	GLboolean norm, GLsizei stride, const void *ptr)
+{
+	(void)index; (void)size; (void)type; (void)norm; (void)stride; (void)ptr;
+	CALL();
+	statechange(1);
+}
+
+#if (USE_OPENGL == USE_GL3)
+static void APIENTRY null_glBindVertexArray(GLuint array) { (void)array; CALL(); statechange(1); }
+static void APIENTRY null_glDeleteVertexArrays(GLsizei n, const GLuint *arrays) { (void)n; (void)arrays; CALL(); }
+
+static void APIENTRY null_glGenVertexArrays(GLsizei n, GLuint *arrays)
+{
+	GLsizei i;
+	CALL();
+	for (i = 0; i < n; i++) arrays[i] = nullstate.nextid++;
+}
+#endif
+
+static void APIENTRY null_glActiveTexture(GLenum texture)
+{
+	CALL();
+	statechange(nullstate.activetexture != texture);
+	nullstate.activetexture = texture;
+}
+
+static void APIENTRY null_glAttachShader(GLuint program, GLuint shader) { (void)program; (void)shader; CALL(); }
+static void APIENTRY null_glCompileShader(GLuint shader) { (void)shader; CALL(); }
+static GLuint APIENTRY null_glCreateProgram(void) { CALL(); return nullstate.nextid++; }
+static GLuint APIENTRY null_glCreateShader(GLenum type) { (void)type; CALL(); return nullstate.nextid++; }
+static void APIENTRY null_glDeleteProgram(GLuint program) { (void)program; CALL(); }
+static void APIENTRY null_glDeleteShader(GLuint shader) { (void)shader; CALL(); }
+static void APIENTRY null_glDetachShader(GLuint program, GLuint shader) { (void)program; (void)shader; CALL(); }
+
+static GLint APIENTRY null_glGetAttribLocation(GLuint program, const GLchar *name)
+{
+	(void)program;
+	CALL();
+	if (!name) return -1;
+	if (!strcmp(name, "a_vertex")) return 0;
+	return 1;
+}
+
+static void APIENTRY null_glGetProgramiv(GLuint program, GLenum pname, GLint *params)
+{
+	(void)program;
+	CALL();
+	if (params) *params = (pname == GL_LINK_STATUS) ? GL_TRUE : 0;
+}
+
+static void APIENTRY null_glGetShaderiv(GLuint shader, GLenum pname, GLint *params)
+{
+	(void)shader;
+	CALL();
+	if (params) *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+static void APIENTRY null_glGetInfoLog(GLuint object, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+	(void)object;
+	CALL();
+	if (infoLog && bufSize > 0) infoLog[0] = 0;
+	if (length) *length = 0;
+}
+
+static GLint APIENTRY null_glGetUniformLocation(GLuint program, const GLchar *name)
+{
+	int i;
+
+	(void)program;
+	CALL();
+	if (!name) return -1;
+
+	// Hand out one location per distinct name, the way a driver would.
+	for (i = 0; i < numuniformnames; i++) {
+		if (!strcmp(uniformnames[i], name)) return i;
+	}
+	if (numuniformnames == NULLMAXUNIFORMS) return -1;
+	Bstrncpy(uniformnames[numuniformnames], name, sizeof(uniformnames[0]) - 1);
+	return numuniformnames++;
+}
+
+static void APIENTRY null_glLinkProgram(GLuint program) { (void)program; CALL(); }
+
+static void APIENTRY null_glShaderSource(GLuint shader, GLsizei count, const GLchar *const*string, const GLint *length)
+{
+	(void)shader; (void)count; (void)string; (void)length;
+	CALL();
+}
+
+static void APIENTRY null_glUseProgram(GLuint program)
+{
+	CALL();
+	statechange(nullstate.program != program);
+	nullstate.program = program;
+}
+
+static void APIENTRY null_glUniform1i(GLint loc, GLint v0)
+{
+	(void)loc; (void)v0;
+	CALL(); framestats.uniformbytes += 4;
+}
+
+static void APIENTRY null_glUniform1f(GLint loc, GLfloat v0)
+{
+	(void)loc; (void)v0;
+	CALL(); framestats.uniformbytes += 4;
+}
+
+static void APIENTRY null_glUniform2f(GLint loc, GLfloat v0, GLfloat v1)
+{
+	(void)loc; (void)v0; (void)v1;
+	CALL(); framestats.uniformbytes += 8;
+}
+
+static void APIENTRY null_glUniform3f(GLint loc, GLfloat v0, GLfloat v1, GLfloat v2)
+{
+	(void)loc; (void)v0; (void)v1; (void)v2;
+	CALL(); framestats.uniformbytes += 12;
+}
+
+static void APIENTRY null_glUniform4f(GLint loc, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+	(void)loc; (void)v0; (void)v1; (void)v2; (void)v3;
+	CALL(); framestats.uniformbytes += 16;
+}
+
+static void APIENTRY null_glUniformMatrix4fv(GLint loc, GLsizei count, GLboolean transpose, const GLfloat *value)
+{
+	(void)loc; (void)transpose; (void)value;
+	CALL(); framestats.uniformbytes += 64 * count;
+}
+
+
+int glbuild_loadfunctions(void)
+{
+	glfunc.glClearColor   = null_glClearColor;
+	glfunc.glClear        = null_glClear;
+	glfunc.glColorMask    = null_glColorMask;
+	glfunc.glBlendFunc    = null_glBlendFunc;
+	glfunc.glCullFace     = null_glCullFace;
+	glfunc.glFrontFace    = null_glFrontFace;
+	glfunc.glPolygonOffset = null_glPolygonOffset;
+#if (USE_OPENGL != USE_GLES2)
+	glfunc.glPolygonMode  = null_glPolygonMode;
+#endif
+	glfunc.glEnable       = null_glEnable;
+	glfunc.glDisable      = null_glDisable;
+	glfunc.glGetFloatv    = null_glGetFloatv;
+	glfunc.glGetIntegerv  = null_glGetIntegerv;
+	glfunc.glGetString    = null_glGetString;
+#if (USE_OPENGL == USE_GL3)
+	glfunc.glGetStringi   = null_glGetStringi;
+#endif
+	glfunc.glGetError     = null_glGetError;
+	glfunc.glHint         = null_glHint;
+	glfunc.glPixelStorei  = null_glPixelStorei;
+	glfunc.glViewport     = null_glViewport;
+	glfunc.glScissor      = null_glScissor;
+#if (USE_OPENGL != USE_GLES2)
+	glfunc.glMinSampleShadingARB = null_glMinSampleShadingARB;
+#endif
+
+	glfunc.glDepthFunc    = null_glDepthFunc;
+	glfunc.glDepthMask    = null_glDepthMask;
+#if (USE_OPENGL == USE_GLES2)
+	glfunc.glDepthRangef  = null_glDepthRangef;
+#else
+	glfunc.glDepthRange   = null_glDepthRange;
+#endif
+
+	glfunc.glReadPixels   = null_glReadPixels;
+
+	glfunc.glGenTextures  = null_glGenTextures;
+	glfunc.glDeleteTextures = null_glDeleteTextures;
+	glfunc.glBindTexture  = null_glBindTexture;
+	glfunc.glTexImage2D   = null_glTexImage2D;
+	glfunc.glTexSubImage2D = null_glTexSubImage2D;
+	glfunc.glTexParameterf = null_glTexParameterf;
+	glfunc.glTexParameteri = null_glTexParameteri;
+	glfunc.glCompressedTexImage2D = null_glCompressedTexImage2D;
+
+	glfunc.glBindBuffer   = null_glBindBuffer;
+	glfunc.glBufferData   = null_glBufferData;
+	glfunc.glBufferSubData = null_glBufferSubData;
+	glfunc.glDeleteBuffers = null_glDeleteBuffers;
+	glfunc.glGenBuffers   = null_glGenBuffers;
+	glfunc.glDrawElements = null_glDrawElements;
+	glfunc.glEnableVertexAttribArray = null_glEnableVertexAttribArray;
+	glfunc.glDisableVertexAttribArray = null_glDisableVertexAttribArray;
+	glfunc.glVertexAttribPointer = null_glVertexAttribPointer;
+#if (USE_OPENGL == USE_GL3)
+	glfunc.glBindVertexArray = null_glBindVertexArray;
+	glfunc.glDeleteVertexArrays = null_glDeleteVertexArrays;
+	glfunc.glGenVertexArrays = null_glGenVertexArrays;
+#endif
+
+	glfunc.glActiveTexture = null_glActiveTexture;
+	glfunc.glAttachShader  = null_glAttachShader;
+	glfunc.glCompileShader = null_glCompileShader;
+	glfunc.glCreateProgram = null_glCreateProgram;
+	glfunc.glCreateShader  = null_glCreateShader;
+	glfunc.glDeleteProgram = null_glDeleteProgram;
+	glfunc.glDeleteShader  = null_glDeleteShader;
+	glfunc.glDetachShader  = null_glDetachShader;
+	glfunc.glGetAttribLocation = null_glGetAttribLocation;
+	glfunc.glGetProgramiv  = null_glGetProgramiv;
+	glfunc.glGetProgramInfoLog = null_glGetInfoLog;
+	glfunc.glGetShaderiv   = null_glGetShaderiv;
+	glfunc.glGetShaderInfoLog = null_glGetInfoLog;
+	glfunc.glGetUniformLocation = null_glGetUniformLocation;
+	glfunc.glLinkProgram   = null_glLinkProgram;
+	glfunc.glShaderSource  = null_glShaderSource;
+	glfunc.glUniform1i     = null_glUniform1i;
+	glfunc.glUniform1f     = null_glUniform1f;
+	glfunc.glUniform2f     = null_glUniform2f;
+	glfunc.glUniform3f     = null_glUniform3f;
+	glfunc.glUniform4f     = null_glUniform4f;
+	glfunc.glUniformMatrix4fv = null_glUniformMatrix4fv;
+	glfunc.glUseProgram    = null_glUseProgram;
+
+	return 0;
+}
+
+static void printstats(const char *label, const struct nullglstats *s, unsigned int div)
+{
+	if (!div) div = 1;
+	buildprintf("%s: %u us, %u calls, %u state changes (+%u redundant), "
+		"%u draws (%u indexes), %u tex uploads (%u KB), %u buffer uploads (%u KB), %u uniform bytes\n",
+		label, s->usecs / div, s->calls / div, s->statechanges / div, s->redundant / div,
+		s->draws / div, s->indexes / div, s->texuploads / div, s->texbytes / div / 1024,
+		s->bufuploads / div, s->bufbytes / div / 1024, s->uniformbytes / div);
+}
+
+void glbuild_null_endframe(void)
+{
+	unsigned int now = getusecticks();
+
+	framestats.usecs = lastframeusec ? now - lastframeusec : 0;
+	lastframeusec = now;
+
+	if (glnulllog) {
+		char label[32];
+		sprintf(label, "glnull frame %u", numrecorded);
+		printstats(label, &framestats, 1);
+	}
+
+#define ACCUM(f) totalstats.f += framestats.f; if (framestats.f > peakstats.f) peakstats.f = framestats.f
+	ACCUM(calls); ACCUM(statechanges); ACCUM(redundant);
+	ACCUM(draws); ACCUM(indexes);
+	ACCUM(texuploads); ACCUM(texbytes);
+	ACCUM(bufuploads); ACCUM(bufbytes);
+	ACCUM(uniformbytes); ACCUM(usecs);
+#undef ACCUM
+
+	numrecorded++;
+	memset(&framestats, 0, sizeof(framestats));
+}
+
+void glbuild_unloadfunctions(void)
+{
+	if (numrecorded > 0) {
+		buildprintf("glnull: %u frames recorded\n", numrecorded);
+		printstats(" average", &totalstats, numrecorded);
+		printstats(" peak", &peakstats, 1);
+	}
+	memset(&glfunc, 0, sizeof(glfunc));
+}
+
+int glbuild_init(void)
+{
+	if (glbuild_loadfunctions()) {
+		return -1;
+	}
+
+	memset(&nullstate, 0, sizeof(nullstate));
+	nullstate.activetexture = GL_TEXTURE0;
+	nullstate.depthfunc = GL_LESS;
+	nullstate.depthmask = GL_TRUE;
+	nullstate.colourmask[0] = nullstate.colourmask[1] =
+		nullstate.colourmask[2] = nullstate.colourmask[3] = GL_TRUE;
+	nullstate.frontface = GL_CCW;
+	nullstate.cullface = GL_BACK;
+	nullstate.blendsrc = GL_ONE;
+	nullstate.blenddst = GL_ZERO;
+	nullstate.nextid = 1;
+	numuniformnames = 0;
+
+	memset(&framestats, 0, sizeof(framestats));
+	memset(&totalstats, 0, sizeof(totalstats));
+	memset(&peakstats, 0, sizeof(peakstats));
+	numrecorded = 0;
+	lastframeusec = 0;
+
+	memset(&glinfo, 0, sizeof(glinfo));
+	glinfo.majver = 2;
+	glinfo.minver = 1;
+	glinfo.glslmajver = 1;
+	glinfo.glslminver = 10;
+	glinfo.maxtexsize = 4096;
+	glinfo.multitex = NULLMAXUNITS;
+	glinfo.maxvertexattribs = 16;
+	glinfo.maxanisotropy = 16.0f;
+	glinfo.bgra = 1;
+	glinfo.clamptoedge = 1;
+	glinfo.texnpot = 1;
+	glinfo.texcomprdxt1 = 1;
+	glinfo.texcomprdxt5 = 1;
+	glinfo.loaded = 1;
+
+	OSD_RegisterFunction("glinfo", "glinfo: shows OpenGL information about the current OpenGL mode", osdcmd_glinfo);
+	OSD_RegisterFunction("glnullstats", "glnullstats [reset]: shows recorded OpenGL traffic per frame", osdcmd_glnullstats);
+	OSD_RegisterFunction("glnulllog", "glnulllog: enable/disable printing OpenGL traffic every frame", osdcmd_vars);
+
+	return 0;
+}
+
+void glbuild_check_errors(const char *file, int line)
+{
+	(void)file; (void)line;
+}
+
+GLuint glbuild_compile_shader(GLuint type, const GLchar *source)
+{
+	(void)type; (void)source;
+	return nullstate.nextid++;
+}
+
+GLuint glbuild_link_program(int shadercount, GLuint *shaders)
+{
+	(void)shadercount; (void)shaders;
+	return nullstate.nextid++;
+}
+
+int glbuild_prepare_8bit_shader(glbuild8bit *state, int resx, int resy, int stride, int winx, int winy)
+{
+	(void)stride;
+	memset(state, 0, sizeof(*state));
+	state->resx = resx;
+	state->resy = resy;
+	state->winx = winx;
+	state->winy = winy;
+	state->tx = 1.0f;
+	state->ty = 1.0f;
+	return 0;
+}
+
+void glbuild_delete_8bit_shader(glbuild8bit *state)
+{
+	memset(state, 0, sizeof(*state));
+}
+
+void glbuild_update_8bit_palette(glbuild8bit *state, const GLvoid *pal)
+{
+	(void)state; (void)pal;
+	framestats.texuploads++;
+	framestats.texbytes += 256 * 4;
+}
+
+void glbuild_set_8bit_gamma(glbuild8bit *state, GLfloat gamma)
+{
+	(void)state; (void)gamma;
+}
+
+void glbuild_update_8bit_frame(glbuild8bit *state, const GLvoid *frame, int stride, int resy)
+{
+	(void)frame;
+	(void)state;
+	framestats.texuploads++;
+	framestats.texbytes += stride * resy;
+}
+
+void glbuild_update_window_size(glbuild8bit *state, int winx, int winy)
+{
+	state->winx = winx;
+	state->winy = winy;
+}
+
+void glbuild_draw_8bit_frame(glbuild8bit *state)
+{
+	(void)state;
+	framestats.draws++;
+	framestats.indexes += 4;
+}
+
+static int osdcmd_vars(const osdfuncparm_t *parm)
+{
+	int showval = (parm->numparms < 1);
+
+	if (!Bstrcasecmp(parm->name, "glnulllog")) {
+		if (showval) { buildprintf("glnulllog is %d\n", glnulllog); }
+		else glnulllog = (atoi(parm->parms[0]) != 0);
+		return OSDCMD_OK;
+	}
+	return OSDCMD_SHOWHELP;
+}
+
+static int osdcmd_glnullstats(const osdfuncparm_t *parm)
+{
+	if (parm->numparms > 0 && !Bstrcasecmp(parm->parms[0], "reset")) {
+		memset(&totalstats, 0, sizeof(totalstats));
+		memset(&peakstats, 0, sizeof(peakstats));
+		numrecorded = 0;
+		return OSDCMD_OK;
+	}
+
+	buildprintf("%u frames recorded\n", numrecorded);
+	if (numrecorded > 0) {
+		printstats("average", &totalstats, numrecorded);
+		printstats("peak", &peakstats, 1);
+	}
+	return OSDCMD_OK;
+}
+
+static int osdcmd_glinfo(const osdfuncparm_t *parm)
+{
+	(void)parm;
+	buildprintf(
+		"OpenGL Information (recording null renderer):\n"
+		" Version:      %s\n"
+		" Vendor:       %s\n"
+		" Renderer:     %s\n"
+		" GLSL version: %s\n"
+		" Max tex size: %d\n"
+		" Multitex:     %d\n",
+		null_gl_version, null_gl_vendor, null_gl_renderer, null_glsl_version,
+		glinfo.maxtexsize, glinfo.multitex
+	);
+	return OSDCMD_OK;
+}
+
+#endif  //USE_OPENGL
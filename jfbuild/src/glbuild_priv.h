@@ -237,6 +237,10 @@ void glbuild_update_8bit_frame(glbuild8bit *state, const GLvoid *frame, int stri
 void glbuild_update_window_size(glbuild8bit *state, int winx, int winy);
 void glbuild_draw_8bit_frame(glbuild8bit *state);
 
+#ifdef GLBUILD_NULL
+void glbuild_null_endframe(void);   // glbuild_null.c: closes the recorded frame.
+#endif
+
 #endif //USE_OPENGL
 
 #endif // __glbuild_priv_h__
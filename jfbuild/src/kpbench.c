@@ -0,0 +1,156 @@
+// Offline picture decoder benchmark for kplib
+//
+// Decodes each picture named on the command line repeatedly with kprender()
+// and reports the time per picture, throughput, and a CRC32 of the decoded
+// pixels. Building this against an older kplib.c and comparing the CRCs is
+// how decoder changes are checked for bit-exact output.
+//
+// Build alongside the library sources, eg.
+//   cc -O2 -Iinclude -o kpbench src/kpbench.c src/kplib.c src/crc32.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+#include "crc32.h"
+
+extern void kpgetdim (void *, int, int *, int *);
+extern int kprender (void *, int, void *, int, int, int, int, int);
+
+static double gettime(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+static char *loadfile(const char *fn, int *length)
+{
+	FILE *fp;
+	char *data;
+
+	fp = fopen(fn, "rb");
+	if (!fp) return NULL;
+	fseek(fp, 0, SEEK_END);
+	*length = (int)ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data = (char *)malloc(*length);
+	if (data && fread(data, *length, 1, fp) != 1) {
+		free(data);
+		data = NULL;
+	}
+	fclose(fp);
+	return data;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = 20, quiet = 0;
+	int arg, i, length, xsiz, ysiz, numpics = 0, failed = 0;
+	double t0, t, best, total, totalbest = 0.0, totalin = 0.0, totalout = 0.0;
+	unsigned int crc, crcall;
+	char *data, *pic;
+
+	for (arg = 1; arg < argc; arg++) {
+		if (argv[arg][0] != '-') continue;
+		switch (argv[arg][1]) {
+			case 'h':
+				puts("kpbench [options] file1.png [file2.jpg ...]");
+				puts("");
+				puts("-h      This text.");
+				puts("-nn     Decode each picture 'n' times (default 20)");
+				puts("-q      Only print the totals and the combined CRC");
+				return 0;
+			case 'n': iterations = atoi(argv[arg] + 2); break;
+			case 'q': quiet = 1; break;
+		}
+	}
+	if (iterations < 1) iterations = 1;
+
+	initcrc32table();
+	crc32init(&crcall);
+
+	for (arg = 1; arg < argc; arg++) {
+		if (argv[arg][0] == '-') continue;
+
+		data = loadfile(argv[arg], &length);
+		if (!data) {
+			fprintf(stderr, "Error opening %s\n", argv[arg]);
+			failed++;
+			continue;
+		}
+
+		xsiz = ysiz = 0;
+		kpgetdim(data, length, &xsiz, &ysiz);
+		if (xsiz <= 0 || ysiz <= 0) {
+			fprintf(stderr, "%s: unrecognised picture\n", argv[arg]);
+			free(data);
+			failed++;
+			continue;
+		}
+
+		pic = (char *)malloc(xsiz * ysiz * 4);
+		if (!pic) {
+			fprintf(stderr, "%s: out of memory\n", argv[arg]);
+			free(data);
+			failed++;
+			continue;
+		}
+
+		best = 1e30; total = 0.0;
+		for (i = 0; i < iterations; i++) {
+			memset(pic, 0, xsiz * ysiz * 4);
+			t0 = gettime();
+			if (kprender(data, length, pic, xsiz * 4, xsiz, ysiz, 0, 0) < 0) break;
+			t = gettime() - t0;
+			total += t;
+			if (t < best) best = t;
+		}
+		if (i < iterations) {
+			fprintf(stderr, "%s: decode failed\n", argv[arg]);
+			free(pic);
+			free(data);
+			failed++;
+			continue;
+		}
+
+		crc = crc32once((unsigned char *)pic, xsiz * ysiz * 4);
+		crc32block(&crcall, (unsigned char *)&crc, sizeof(crc));
+
+		if (!quiet) {
+			printf("%-32s %5dx%-5d %8.3f ms best %8.3f ms mean %7.2f MB/s in %7.2f Mpix/s  crc %08x\n",
+				argv[arg], xsiz, ysiz, best * 1000.0, total * 1000.0 / iterations,
+				length / best / 1048576.0, xsiz * ysiz / best / 1000000.0, crc);
+		}
+
+		numpics++;
+		totalbest += best;
+		totalin += length;
+		totalout += (double)xsiz * ysiz;
+
+		free(pic);
+		free(data);
+	}
+
+	if (numpics > 0) {
+		printf("%d pictures, %d iterations: %.3f ms total best, %.2f MB/s in, %.2f Mpix/s, crc %08x\n",
+			numpics, iterations, totalbest * 1000.0, totalin / totalbest / 1048576.0,
+			totalout / totalbest / 1000000.0, crc32finish(&crcall));
+	}
+
+	return failed ? 1 : 0;
+}
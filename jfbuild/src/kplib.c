@@ -41,6 +41,12 @@ credits.
 #include <stdlib.h>
 #include <stdint.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__MMX__)
+#include <mmintrin.h>
+#endif
+
 #if defined(__BIG_ENDIAN__)
 # define BIGENDIAN 1
 #endif
@@ -167,20 +173,21 @@ signed char coltype, filtype, bitdepth;
 
 	//.PNG specific variables:
 static int bakr = 0x80, bakg = 0x80, bakb = 0x80; //this used to be public...
-static int gslidew = 0, gslider = 0, xm, xmn[4], xr0, xr1, xplc, yplc;
+static int gslidew = 0, gslider = 0, xm, xmn[4], xbpp, xr0, xr1, xplc, yplc;
 static intptr_t nfplace;
 static int clen[320], cclen[19], bitpos, filt, xsiz, ysiz;
 static int xsizbpl, ixsiz, ixoff, iyoff, ixstp, iystp, intlac, nbpl, trnsrgb;
 static int ccind[19] = {16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
 static int hxbit[59][2], ibuf0[288], nbuf0[32], ibuf1[32], nbuf1[32];
 static const unsigned char *filptr;
-static unsigned char slidebuf[32768], opixbuf0[4], opixbuf1[4];
-static unsigned char pnginited = 0, olinbuf[65536]; //WARNING:max xres is: 65536/bpp-1
+static unsigned char slidebuf[32768], opixbuf0[4];
+static unsigned char pnginited = 0, olinbuf[65536]; //WARNING:max xres is: (65536-5)/bpp
 static int gotcmov = -2, abstab10[1024];
 
 	//Variables to speed up dynamic Huffman decoding:
-#define LOGQHUFSIZ0 9
-#define LOGQHUFSIZ1 6
+	//qhufval0 entries >= 65536 hold 2 literals (see qhufgenpairs)
+#define LOGQHUFSIZ0 10
+#define LOGQHUFSIZ1 8
 static int qhufval0[1<<LOGQHUFSIZ0], qhufval1[1<<LOGQHUFSIZ1];
 static unsigned char qhufbit0[1<<LOGQHUFSIZ0], qhufbit1[1<<LOGQHUFSIZ1];
 
@@ -445,12 +452,14 @@ static inline int peekbits (int n) { return((LSWAPIB(*(int *)&filptr[bitpos>>3])
 static inline void suckbits (int n) { bitpos += n; if (bitpos >= 0) suckbitsnextblock(); }
 static inline int getbits (int n) { int i = peekbits(n); suckbits(n); return(i); }
 
+	//Codes are at most 15 bits, so peek them all at once and suck only what was used
 static int hufgetsym (int *hitab, int *hbmax)
 {
-	int v, n;
+	int v, n, b;
 
-	v = n = 0;
-	do { v = (v<<1)+getbits(1)+hbmax[n]-hbmax[n+1]; n++; } while (v >= 0);
+	v = n = 0; b = peekbits(15);
+	do { v = (v<<1)+(b&1)+hbmax[n]-hbmax[n+1]; b >>= 1; n++; } while (v >= 0);
+	suckbits(n);
 	return(hitab[hbmax[n]+v]);
 }
 
@@ -507,6 +516,41 @@ static void qhufgencode (int *hitab, int *hbmax, int *qhval, unsigned char *qhbi
 	//return(k);
 }
 
+	//Merges 2 short literal codes into a single qhval entry: (lit0 + (lit1<<8) + 65536)
+	//Walks downwards so qhval[r>>n] still holds a single symbol when it is read
+static void qhufgenpairs (int *qhval, unsigned char *qhbit, int numbits)
+{
+	int r, n, m, s;
+
+	for(r=pow2mask[numbits];r>=0;r--)
+	{
+		n = qhbit[r]; if ((!n) || (qhval[r] >= 256)) continue;
+		s = (r>>n); m = qhbit[s];
+		if ((!m) || (m > numbits-n) || (qhval[s] >= 256)) continue;
+		qhval[r] += (qhval[s]<<8)+65536; qhbit[r] = (unsigned char)(n+m);
+	}
+}
+
+	//LZ77 match copy: slidebuf[w..w+leng-1] = slidebuf[w-dist..]. Copies a dword at a time
+	//when neither range wraps and the overlap allows it; dist 1 (runs) becomes a memset.
+static inline void slidecopy (int w, int dist, int leng)
+{
+	int r;
+
+	r = ((w-dist)&32767); w &= 32767;
+	if (max(w,r)+leng <= 32768)
+	{
+		if (dist >= 4)
+		{
+			for(;leng>=4;leng-=4,w+=4,r+=4) *(int *)&slidebuf[w] = *(int *)&slidebuf[r];
+			for(;leng;leng--) slidebuf[w++] = slidebuf[r++];
+			return;
+		}
+		if (dist == 1) { memset(&slidebuf[w],slidebuf[r],leng); return; }
+	}
+	for(;leng;leng--,w++) slidebuf[w&32767] = slidebuf[(w-dist)&32767];
+}
+
 	//inbuf[inum] : Bit length of each symbol
 	//inum        : Number of indices
 	//hitab[inum] : Indices from size-ordered list to original symbol
@@ -553,8 +597,9 @@ static int initpass (void) //Interlaced images have 7 "passes", non-interlaced h
 		case 4: xsizbpl = ((xsizbpl+1)>>1); break;
 	}
 
-	memset(olinbuf,0,(xsizbpl+1)*sizeof(olinbuf[0]));
-	*(int *)&opixbuf0[0] = *(int *)&opixbuf1[0] = 0;
+		//olinbuf[xsizbpl+1..xsizbpl+4] stay 0: the "left" pixel of the 1st pixel of each line
+	memset(olinbuf,0,(xsizbpl+5)*sizeof(olinbuf[0]));
+	*(int *)&opixbuf0[0] = 0;
 	xplc = xsizbpl; yplc = globyoffs+iyoff; xm = 0; filt = -1;
 
 	i = globxoffs+ixoff; i = (((-(i>=0))|(ixstp-1))&i);
@@ -587,13 +632,29 @@ static int initpass (void) //Interlaced images have 7 "passes", non-interlaced h
 	return(0);
 }
 
-static int Paeth (int a, int b, int c)
+	//Written so compilers can use cmov instead of 2 unpredictable branches per byte
+static inline int Paeth (int a, int b, int c)
 {
 	int pa, pb, pc;
 
 	pa = b-c; pb = a-c; pc = abs(pa+pb); pa = abs(pa); pb = abs(pb);
-	if ((pa <= pb) && (pa <= pc)) return(a);
-	if (pb <= pc) return(b); else return(c);
+	if (pb > pc) { pb = pc; b = c; }
+	return((pa <= pb) ? a : b);
+}
+
+	//Filters on 4 bytes at once in a 32-bit register. olinbuf holds each line backwards,
+	//so source dwords are byte-reversed first (revb4) to line up with it.
+static inline unsigned int revb4 (unsigned int a)
+{
+	return((a>>24)|((a>>8)&0xff00)|((a&0xff00)<<8)|(a<<24));
+}
+static inline unsigned int paddb (unsigned int a, unsigned int b) //Per-byte a+b (mod 256)
+{
+	return(((a&0x7f7f7f7f)+(b&0x7f7f7f7f))^((a^b)&0x80808080));
+}
+static inline unsigned int pavgb (unsigned int a, unsigned int b) //Per-byte (a+b)>>1
+{
+	return((a&b)+(((a^b)&0xfefefefe)>>1));
 }
 
 #if defined(__WATCOMC__) && USE_ASM
@@ -854,7 +915,7 @@ static inline void pal8hlineasm (int x, int xr1, intptr_t p, int ixstp)
 static int filter1st, filterest;
 static void putbuf (const unsigned char *buf, int leng)
 {
-	int i, x;
+	int i, j, x;
 	intptr_t p;
 
 	if (filt < 0)
@@ -875,37 +936,60 @@ static void putbuf (const unsigned char *buf, int leng)
 				while (i < x) { olinbuf[xplc] = buf[i]; xplc--; i++; }
 				break;
 			case 1:
-				while (i < x)
-				{
-					olinbuf[xplc] = (opixbuf1[xm] += buf[i]);
-					xm = xmn[xm]; xplc--; i++;
-				}
+				if (xbpp == 4)
+					for(;i+4<=x;xplc-=4,i+=4)
+						*(int *)&olinbuf[xplc-3] = paddb(*(int *)&olinbuf[xplc+1],revb4(*(int *)&buf[i]));
+				while (i < x) { olinbuf[xplc] = olinbuf[xplc+xbpp]+buf[i]; xplc--; i++; }
 				break;
 			case 2:
+				for(;i+4<=x;xplc-=4,i+=4)
+					*(int *)&olinbuf[xplc-3] = paddb(*(int *)&olinbuf[xplc-3],revb4(*(int *)&buf[i]));
 				while (i < x) { olinbuf[xplc] += buf[i]; xplc--; i++; }
 				break;
 			case 3:
+				if (xbpp == 4)
+					for(;i+4<=x;xplc-=4,i+=4)
+						*(int *)&olinbuf[xplc-3] = paddb(pavgb(*(int *)&olinbuf[xplc+1],*(int *)&olinbuf[xplc-3]),revb4(*(int *)&buf[i]));
 				while (i < x)
 				{
-					opixbuf1[xm] = olinbuf[xplc] = ((opixbuf1[xm]+olinbuf[xplc])>>1)+buf[i];
-					xm = xmn[xm]; xplc--; i++;
+					olinbuf[xplc] = ((olinbuf[xplc+xbpp]+olinbuf[xplc])>>1)+buf[i];
+					xplc--; i++;
 				}
 				break;
 			case 4:
+				while ((i < x) && (xm))
+				{
+					j = opixbuf0[xm]; opixbuf0[xm] = olinbuf[xplc];
+					olinbuf[xplc] = (unsigned char)(Paeth(olinbuf[xplc+xbpp],olinbuf[xplc],j)+buf[i]);
+					xm = xmn[xm]; xplc--; i++;
+				}
+				if ((xbpp == 4) && (i+4 <= x))
+				{     //Whole RGBA pixels: keep the upper-left pixel in registers
+					int a0, a1, a2, a3, c0, c1, c2, c3, b;
+					a0 = olinbuf[xplc+4]; a1 = olinbuf[xplc+3]; a2 = olinbuf[xplc+2]; a3 = olinbuf[xplc+1];
+					c0 = opixbuf0[0]; c1 = opixbuf0[1]; c2 = opixbuf0[2]; c3 = opixbuf0[3];
+					do
+					{
+						b = olinbuf[xplc  ]; a0 = (unsigned char)(Paeth(a0,b,c0)+buf[i  ]); olinbuf[xplc  ] = a0; c0 = b;
+						b = olinbuf[xplc-1]; a1 = (unsigned char)(Paeth(a1,b,c1)+buf[i+1]); olinbuf[xplc-1] = a1; c1 = b;
+						b = olinbuf[xplc-2]; a2 = (unsigned char)(Paeth(a2,b,c2)+buf[i+2]); olinbuf[xplc-2] = a2; c2 = b;
+						b = olinbuf[xplc-3]; a3 = (unsigned char)(Paeth(a3,b,c3)+buf[i+3]); olinbuf[xplc-3] = a3; c3 = b;
+						xplc -= 4; i += 4;
+					} while (i+4 <= x);
+					opixbuf0[0] = c0; opixbuf0[1] = c1; opixbuf0[2] = c2; opixbuf0[3] = c3;
+				}
 				while (i < x)
 				{
-					opixbuf1[xm] = (unsigned char)(Paeth(opixbuf1[xm],olinbuf[xplc],opixbuf0[xm])+buf[i]);
-					opixbuf0[xm] = olinbuf[xplc];
-					olinbuf[xplc] = opixbuf1[xm];
+					j = opixbuf0[xm]; opixbuf0[xm] = olinbuf[xplc];
+					olinbuf[xplc] = (unsigned char)(Paeth(olinbuf[xplc+xbpp],olinbuf[xplc],j)+buf[i]);
 					xm = xmn[xm]; xplc--; i++;
 				}
 				break;
 			case 5: //Special hack for Paeth686 (Doesn't have to be case 5)
 				while (i < x)
 				{
-					opixbuf1[xm] = (unsigned char)(Paeth686(opixbuf1[xm],olinbuf[xplc],opixbuf0[xm])+buf[i]);
-					opixbuf0[xm] = olinbuf[xplc];
-					olinbuf[xplc] = opixbuf1[xm];
+					j = opixbuf0[xm]; opixbuf0[xm] = olinbuf[xplc];
+					olinbuf[xplc] = (unsigned char)(Paeth686(olinbuf[xplc+xbpp],olinbuf[xplc],j)+buf[i]);
 					xm = xmn[xm]; xplc--; i++;
 				}
 				break;
@@ -969,7 +1053,7 @@ static void putbuf (const unsigned char *buf, int leng)
 			nfplace += nbpl;
 		}
 
-		*(int *)&opixbuf0[0] = *(int *)&opixbuf1[0] = 0;
+		*(int *)&opixbuf0[0] = 0;
 		xplc = xsizbpl; yplc += iystp;
 		if ((intlac) && (yplc >= globyoffs+ysiz)) { intlac--; initpass(); }
 		if (i < leng)
@@ -1127,6 +1211,8 @@ static int kpngrend (const char *kfilebuf, int kfilength,
 		case 6: xmn[0] = 1; xmn[1] = 2; xmn[2] = 3; xmn[3] = 0; break;
 		default: xmn[0] = 0; break;
 	}
+	xbpp = ((0x04021301>>(coltype<<2))&15); //Filter byte distance: bytes per pixel, or 1 if < 8 bits
+
 	switch (bitdepth)
 	{
 		case 1: for(i=2;i<256;i++) palcol[i] = palcol[i&1]; break;
@@ -1149,7 +1235,7 @@ static int kpngrend (const char *kfilebuf, int kfilength,
 	}
 		//Tests to see if xsiz > allocated space in olinbuf
 		//Note: xsizbpl gets re-written inside initpass()
-	if ((xsizbpl+1)*sizeof(olinbuf[0]) > sizeof(olinbuf)) return(-1);
+	if ((xsizbpl+5)*sizeof(olinbuf[0]) > sizeof(olinbuf)) return(-1);
 
 	initpass();
 
@@ -1211,6 +1297,7 @@ static int kpngrend (const char *kfilebuf, int kfilength,
 		hufgencode(clen,hlit,ibuf0,nbuf0);
 		//qhuf0v = //hufgetsym_skipb related code
 		qhufgencode(ibuf0,nbuf0,qhufval0,qhufbit0,LOGQHUFSIZ0);
+		qhufgenpairs(qhufval0,qhufbit0,LOGQHUFSIZ0);
 
 		hufgencode(&clen[hlit],hdist,ibuf1,nbuf1);
 		//qhuf1v = //hufgetsym_skipb related code
@@ -1229,6 +1316,12 @@ static int kpngrend (const char *kfilebuf, int kfilength,
 			//else i = hufgetsym_skipb(ibuf0,nbuf0,LOGQHUFSIZ0,qhuf0v); //hufgetsym_skipb related code
 
 			if (i < 256) { slidebuf[(slidew++)&32767] = (unsigned char)i; continue; }
+			if (i >= 65536) //2 literals from 1 lookup
+			{
+				slidebuf[(slidew  )&32767] = (unsigned char)i;
+				slidebuf[(slidew+1)&32767] = (unsigned char)(i>>8);
+				slidew += 2; continue;
+			}
 			if (i == 256) break;
 			i = getbits(hxbit[i+30-257][0]) + hxbit[i+30-257][1];
 
@@ -1237,7 +1330,7 @@ static int kpngrend (const char *kfilebuf, int kfilength,
 			//else j = hufgetsym_skipb(ibuf1,nbuf1,LOGQHUFSIZ1,qhuf1v); //hufgetsym_skipb related code
 
 			j = getbits(hxbit[j][0]) + hxbit[j][1];
-			i += slidew; do { slidebuf[slidew&32767] = slidebuf[(slidew-j)&32767]; slidew++; } while (slidew < i);
+			slidecopy(slidew,j,i); slidew += i;
 		}
 	} while (!bfinal);
 
@@ -1271,6 +1364,7 @@ static int clipxdim, clipydim;
 static int hufmaxatbit[8][20], hufvalatbit[8][20], hufcnt[8];
 static unsigned char hufnumatbit[8][20], huftable[8][256];
 static int hufquickval[8][1024], hufquickbits[8][1024], hufquickcnt[8];
+static int hufquickac[8][1024]; //AC code+extra bits in 1 lookup: (coef<<12)+(run<<8)+(extra bits<<4)+total bits; 0 if > 10 bits
 static int quantab[4][64], dct[12][64], lastdc[4], unzig[64], zigit[64]; //dct:10=MAX (says spec);+2 for hacks
 static unsigned char gnumcomponents, dcflagor[64];
 static int gcompid[4], gcomphsamp[4], gcompvsamp[4], gcompquantab[4], gcomphsampshift[4], gcompvsampshift[4];
@@ -1422,6 +1516,28 @@ static void invdct8x8 (int *dc, unsigned char dcflag)
 	#define C38S22 18159528  //(cos(PI*3/8)*sqrt(2)*2)<<24
 	int *edc, t0, t1, t2, t3, t4, t5, t6, t7;
 
+	if (dcflag == 1) //Only row 0 has coefficients: every column transform just copies it down
+	{
+		if (!(dc[1]|dc[2]|dc[3]|dc[4]|dc[5]|dc[6]|dc[7])) //DC only: flat block
+		{
+			for(t0=63;t0>0;t0--) dc[t0] = dc[0];
+			return;
+		}
+		t3 = dc[2] + dc[6];
+		t2 = (mulshr32(dc[2]-dc[6],SQRT2<<6)<<2) - t3;
+		t4 = dc[0] + dc[4]; t5 = dc[0] - dc[4];
+		t0 = t4+t3; t3 = t4-t3; t1 = t5+t2; t2 = t5-t2;
+		t4 = (mulshr32(dc[5]-dc[3]+dc[1]-dc[7],C182<<6)<<2);
+		t7 = dc[1] + dc[7] + dc[5] + dc[3];
+		t6 = (mulshr32(dc[3]-dc[5],C18S22<<5)<<3) + t4 - t7;
+		t5 = (mulshr32(dc[1]+dc[7]-dc[5]-dc[3],SQRT2<<6)<<2) - t6;
+		t4 = (mulshr32(dc[1]-dc[7],C38S22<<6)<<2) - t4 + t5;
+		dc[0] = t0+t7; dc[7] = t0-t7; dc[1] = t1+t6; dc[6] = t1-t6;
+		dc[2] = t2+t5; dc[5] = t2-t5; dc[4] = t3+t4; dc[3] = t3-t4;
+		for(t0=8;t0<64;t0+=8) memcpy(&dc[t0],dc,8*sizeof(dc[0]));
+		return;
+	}
+
 	edc = dc+64;
 	do
 	{
@@ -1459,11 +1575,85 @@ static void invdct8x8 (int *dc, unsigned char dcflag)
 	} while (dc < edc);
 }
 
+	//Chroma contributions of the MCU's Cb/Cr blocks (dct[lcomphvsamp0], +1), computed once per
+	//MCU and spread across luma columns, so subsampled chroma isn't looked up again for every
+	//luma pixel that shares it: yrbcterm[R,G,B][chroma row*(lcomphsamp[0]<<3) + luma column]
+#define YRBMAXHSAMP 4
+static int yrbcterm[3][64*YRBMAXHSAMP];
+
+	//8 pixels of a luma row plus their chroma terms. colclip[] is clamp((v>>22)+128,0,255),
+	//which the saturating packs reproduce exactly.
+static inline void yrbrow8 (int *p, const int *dc, const int *tr, const int *tg, const int *tb)
+{
+#if defined(__SSE2__)
+	__m128i c128 = _mm_set1_epi32(128), alpha = _mm_set1_epi16(255);
+	__m128i y0, y1, r, g, b, bg, ra;
+
+	y0 = _mm_loadu_si128((const __m128i *)&dc[0]); y1 = _mm_loadu_si128((const __m128i *)&dc[4]);
+	r = _mm_packs_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y0,_mm_loadu_si128((const __m128i *)&tr[0])),22),c128),
+							  _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y1,_mm_loadu_si128((const __m128i *)&tr[4])),22),c128));
+	g = _mm_packs_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y0,_mm_loadu_si128((const __m128i *)&tg[0])),22),c128),
+							  _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y1,_mm_loadu_si128((const __m128i *)&tg[4])),22),c128));
+	b = _mm_packs_epi32(_mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y0,_mm_loadu_si128((const __m128i *)&tb[0])),22),c128),
+							  _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(y1,_mm_loadu_si128((const __m128i *)&tb[4])),22),c128));
+	bg = _mm_unpacklo_epi16(b,g); ra = _mm_unpacklo_epi16(r,alpha);
+	_mm_storeu_si128((__m128i *)&p[0],_mm_packus_epi16(_mm_unpacklo_epi32(bg,ra),_mm_unpackhi_epi32(bg,ra)));
+	bg = _mm_unpackhi_epi16(b,g); ra = _mm_unpackhi_epi16(r,alpha);
+	_mm_storeu_si128((__m128i *)&p[4],_mm_packus_epi16(_mm_unpacklo_epi32(bg,ra),_mm_unpackhi_epi32(bg,ra)));
+#elif defined(__MMX__)
+	__m64 c128 = _mm_set1_pi32(128), alpha = _mm_set1_pi16(255);
+	__m64 y, r, g, b, br, ga;
+	int x;
+
+	for(x=0;x<8;x+=2)
+	{
+		y = *(const __m64 *)&dc[x];
+		r = _mm_add_pi32(_mm_srai_pi32(_mm_add_pi32(y,*(const __m64 *)&tr[x]),22),c128);
+		g = _mm_add_pi32(_mm_srai_pi32(_mm_add_pi32(y,*(const __m64 *)&tg[x]),22),c128);
+		b = _mm_add_pi32(_mm_srai_pi32(_mm_add_pi32(y,*(const __m64 *)&tb[x]),22),c128);
+		b = _mm_packs_pi32(b,g); r = _mm_packs_pi32(r,alpha); //B0 B1 G0 G1, R0 R1 A A
+		br = _mm_unpacklo_pi16(b,r); ga = _mm_unpackhi_pi16(b,r); //B0 R0 B1 R1, G0 A G1 A
+		*(__m64 *)&p[x] = _mm_packs_pu16(_mm_unpacklo_pi16(br,ga),_mm_unpackhi_pi16(br,ga));
+	}
+#else
+	int x, yv;
+
+	for(x=0;x<8;x++)
+	{
+		yv = dc[x];
+		p[x] = colclipup16[(unsigned)(yv+tr[x])>>22]+
+				  colclipup8[(unsigned)(yv+tg[x])>>22]+
+					  colclip[(unsigned)(yv+tb[x])>>22];
+	}
+#endif
+}
+
 static void yrbrend (int x, int y)
 {
 	int i, j, ox, oy, xx, yy, xxx, yyy, xxxend, yyyend, yv, cr=0, cb=0, *odc, *dc, *dc2;
+	int cw, fast;
 	intptr_t p, pp;
 
+		//Fast path: every chroma sample is expanded to the luma columns it covers. Needs the
+		//MCU's luma sampling to match its chroma subsampling shifts, which is the usual case.
+	fast = ((lnumcomponents > 1) && (lcomphsamp[0] <= YRBMAXHSAMP) &&
+			  (lcomphsamp[0] == (1<<lcomphsampshift0)) && (lcompvsamp[0] == (1<<lcompvsampshift0)));
+	cw = (lcomphsamp[0]<<3);
+	if (fast)
+	{
+		dc2 = dct[lcomphvsamp0];
+		for(yy=0;yy<8;yy++)
+			for(xx=0;xx<cw;xx+=lcomphsamp[0])
+			{
+				cr = (dc2[(yy<<3)+(xx>>lcomphsampshift0)+64]>>13)&~1;
+				cb = (dc2[(yy<<3)+(xx>>lcomphsampshift0)   ]>>13)&~1;
+				i = yy*cw+xx; j = i+lcomphsamp[0];
+				yv = crmul[cr+2048]; for(xxx=i;xxx<j;xxx++) yrbcterm[0][xxx] = yv;
+				yv = crmul[cr+2049]+cbmul[cb+2048]; for(xxx=i;xxx<j;xxx++) yrbcterm[1][xxx] = yv;
+				yv = cbmul[cb+2049]; for(xxx=i;xxx<j;xxx++) yrbcterm[2][xxx] = yv;
+			}
+	}
+
 	odc = dct[0]; dc2 = dct[10];
 	for(yy=0;yy<(lcompvsamp[0]<<3);yy+=8)
 	{
@@ -1477,47 +1667,27 @@ static void yrbrend (int x, int y)
 			if (lnumcomponents > 1) dc2 = &dct[lcomphvsamp0][((yy>>lcompvsampshift0)<<3)+(xx>>lcomphsampshift0)];
 			xxxend = min(clipxdim-ox,8);
 			yyyend = min(clipydim-oy,8);
-			if ((lcomphsamp[0] == 1) && (xxxend == 8))
-			{
+			if ((lnumcomponents == 1) && (xxxend == 8))
+			{     //Grayscale: dc2 points at the zeroed dct[10], so the chroma terms are all 0
 				for(yyy=0;yyy<yyyend;yyy++)
 				{
 					for(xxx=0;xxx<8;xxx++)
 					{
-						yv = dc[xxx];
-						cr = (dc2[xxx+64]>>13)&~1;
-						cb = (dc2[xxx   ]>>13)&~1;
-						((int *)p)[xxx] = colclipup16[(unsigned)(yv+crmul[cr+2048]               )>>22]+
-												  colclipup8[(unsigned)(yv+crmul[cr+2049]+cbmul[cb+2048])>>22]+
-													  colclip[(unsigned)(yv+cbmul[cb+2049]               )>>22];
+						i = ((unsigned)dc[xxx]>>22);
+						((int *)p)[xxx] = colclipup16[i]+colclipup8[i]+colclip[i];
 					}
 					p += bytesperline;
 					dc += 8;
-					if (!((yyy+1)&(lcompvsamp[0]-1))) dc2 += 8;
 				}
 			}
-			else if ((lcomphsamp[0] == 2) && (xxxend == 8))
+			else if ((fast) && (xxxend == 8))
 			{
 				for(yyy=0;yyy<yyyend;yyy++)
 				{
-					for(xxx=0;xxx<8;xxx+=2)
-					{
-						yv = dc[xxx];
-						cr = (dc2[(xxx>>1)+64]>>13)&~1;
-						cb = (dc2[(xxx>>1)   ]>>13)&~1;
-						i = crmul[cr+2049]+cbmul[cb+2048];
-						cr = crmul[cr+2048];
-						cb = cbmul[cb+2049];
-						((int *)p)[xxx] = colclipup16[(unsigned)(yv+cr)>>22]+
-												  colclipup8[(unsigned)(yv+ i)>>22]+
-													  colclip[(unsigned)(yv+cb)>>22];
-						yv = dc[xxx+1];
-						((int *)p)[xxx+1] = colclipup16[(unsigned)(yv+cr)>>22]+
-													 colclipup8[(unsigned)(yv+ i)>>22]+
-														 colclip[(unsigned)(yv+cb)>>22];
-					}
+					i = ((yy+yyy)>>lcompvsampshift0)*cw+xx;
+					yrbrow8((int *)p,dc,&yrbcterm[0][i],&yrbcterm[1][i],&yrbcterm[2][i]);
 					p += bytesperline;
 					dc += 8;
-					if (!((yyy+1)&(lcompvsamp[0]-1))) dc2 += 8;
 				}
 			}
 			else
@@ -1547,6 +1717,9 @@ static void yrbrend (int x, int y)
 			}
 		}
 	}
+#if defined(__MMX__) && !defined(__SSE2__)
+	_mm_empty();
+#endif
 }
 
 static int kpegrend (const char *kfilebuf, int kfilength,
@@ -1554,7 +1727,7 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 	int daglobxoffs, int daglobyoffs)
 {
 	int i, j, v, leng=0, xdim=0, ydim=0, index, prec, restartcnt, restartinterval;
-	int x, y, z, xx, yy, zz, *dc=NULL, num, curbits, c, daval, dabits, *hqval, *hqbits, hqcnt, *quanptr;
+	int x, y, z, xx, yy, zz, *dc=NULL, num, curbits, c, daval, dabits, *hqval, *hqbits, *hqac, hqcnt, *quanptr;
 	int passcnt = 0, ghsampmax=0, gvsampmax=0, glhsampmax=0, glvsampmax=0, glhstep, glvstep;
 	int eobrun, Ss, Se, Ah, Al, Alut[2], dctx[12], dcty[12], ldctx[12], /*ldcty[12],*/ lshx[4], lshy[4];
 	short *dctbuf = NULL, *dctptr[12], *ldctptr[12], *dcs=NULL;
@@ -1647,6 +1820,17 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 						v = ((v+hufnumatbit[index][i])<<1);
 					}
 
+					for(i=0;i<1024;i++)
+					{
+						hufquickac[index][i] = 0;
+						if (i >= hufquickcnt[index]) continue;
+						c = (hufquickval[index][i]&15); j = hufquickbits[index][i]+c;
+						if ((!c) || (j > 10)) continue;
+						v = ((i>>(10-j))&pow2mask[c]);
+						if (v <= pow2mask[c-1]) v -= pow2mask[c];
+						hufquickac[index][i] = v*4096 + ((hufquickval[index][i]&0xf0)<<4) + (c<<4) + j;
+					}
+
 				} while (leng > 0);
 				break;
 			case 0xdb:
@@ -1753,6 +1937,7 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 						{
 							hqval = &hufquickval[lcompac[c]+4][0];
 							hqbits = &hufquickbits[lcompac[c]+4][0];
+							hqac = &hufquickac[lcompac[c]+4][0];
 							hqcnt = hufquickcnt[lcompac[c]+4];
 							if (!dctbuf) quanptr = &quantab[lcompquantab[c]][0];
 							for(yy=0;yy<(lcompvsamp[c]<<3);yy+=8)
@@ -1789,7 +1974,7 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 												if (v <= pow2mask[daval-1]) v -= pow2mask[daval];
 												lastdc[c] += v;
 											}
-											if (!dctbuf) dc[0] = lastdc[c]; else dcs[0] = (short)(lastdc[c]<<Al);
+											if (!dctbuf) dc[0] = lastdc[c]*quanptr[0]; else dcs[0] = (short)(lastdc[c]<<Al);
 										}
 										else if (num&(pow2long[--curbits])) dcs[0] |= ((short)Alut[0]);
 									}
@@ -1807,6 +1992,14 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 												num = (num<<8)+((int)ch); curbits += 8;
 											}
 											i = ((num>>(curbits-10))&1023);
+											if ((!Ah) && (hqac[i])) //Short code+coefficient: no 2nd Getbits
+											{
+												v = hqac[i];
+												z += ((v>>8)&15); if (z > Se) { curbits -= (v&15)-((v>>4)&15); break; }
+												curbits -= (v&15); dcflag |= dcflagor[z]; v >>= 12;
+												if (!dctbuf) { i = unzig[z]; dc[i] = v*quanptr[i]; } else dcs[z] = (short)(v<<Al);
+												continue;
+											}
 											if (i < hqcnt)
 												  { daval = hqval[i]; curbits -= hqbits[i]; }
 											else { huffgetval(lcompac[c]+4,curbits,num,&daval,&dabits); curbits -= dabits; }
@@ -1864,7 +2057,7 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 												curbits -= daval; v = ((unsigned)num >> curbits) & pow2mask[daval];
 												if (v <= pow2mask[daval-1]) v -= pow2mask[daval];
 												dcflag |= dcflagor[z];
-												if (!dctbuf) dc[unzig[z]] = v; else dcs[z] = (short)(v<<Al);
+												if (!dctbuf) { i = unzig[z]; dc[i] = v*quanptr[i]; } else dcs[z] = (short)(v<<Al);
 											}
 										}
 									} else if (!Ah) eobrun--;
@@ -1883,11 +2076,7 @@ static int kpegrend (const char *kfilebuf, int kfilength,
 										}
 									}
 
-									if (!dctbuf)
-									{
-										for(z=64-1;z>=0;z--) dc[z] *= quanptr[z];
-										invdct8x8(dc,dcflag); dc += 64;
-									}
+									if (!dctbuf) { invdct8x8(dc,dcflag); dc += 64; } //Already dequantized
 								}
 							}
 
@@ -3213,6 +3402,7 @@ kzreadplc1:;         i = kzfs.i; bfinal = kzfs.bfinal;
 
 			hufgencode(clen,hlit,ibuf0,nbuf0);
 			qhufgencode(ibuf0,nbuf0,qhufval0,qhufbit0,LOGQHUFSIZ0);
+			qhufgenpairs(qhufval0,qhufbit0,LOGQHUFSIZ0);
 
 			hufgencode(&clen[hlit],hdist,ibuf1,nbuf1);
 			qhufgencode(ibuf1,nbuf1,qhufval1,qhufbit1,LOGQHUFSIZ1);
@@ -3234,6 +3424,12 @@ kzreadplc2:;      bfinal = kzfs.bfinal;
 				else i = hufgetsym(ibuf0,nbuf0);
 
 				if (i < 256) { slidebuf[(gslidew++)&32767] = (char)i; continue; }
+				if (i >= 65536) //2 literals from 1 lookup
+				{
+					slidebuf[(gslidew  )&32767] = (char)i;
+					slidebuf[(gslidew+1)&32767] = (char)(i>>8);
+					gslidew += 2; continue;
+				}
 				if (i == 256) break;
 				i = getbits(hxbit[i+30-257][0]) + hxbit[i+30-257][1];
 
@@ -3242,7 +3438,7 @@ kzreadplc2:;      bfinal = kzfs.bfinal;
 				else j = hufgetsym(ibuf1,nbuf1);
 
 				j = getbits(hxbit[j][0]) + hxbit[j][1];
-				for(;i;i--,gslidew++) slidebuf[gslidew&32767] = slidebuf[(gslidew-j)&32767];
+				slidecopy(gslidew,j,i); gslidew += i;
 			}
 		} while (!bfinal);
 
@@ -44,6 +44,7 @@ static struct polymostvboitem *elementvbo = NULL;	 // 3 per triangle.
 
 mdmodel *mdload (const char *);
 void mdfree (mdmodel *);
+static void voxcache_close (void);
 
 void freeallmodels (void)
 {
@@ -71,6 +72,7 @@ void freeallmodels (void)
 		allocelementvbo = maxelementvbo = 0;
 	}
 
+	voxcache_close();
 }
 
 void clearskins (void)
@@ -1566,11 +1568,10 @@ skindidntfit:;
 				shp[z].x = x0; shp[z].y = y0; //Overwrite size with top-left location
 			}
 
-			gvox->quad = (voxrect_t *)malloc(gvox->qcnt*sizeof(voxrect_t));
+				//mytex follows quad in the same block, as the voxel cache stores them
+			gvox->quad = (voxrect_t *)malloc(gvox->qcnt*sizeof(voxrect_t) + gvox->mytexx*gvox->mytexy*sizeof(int));
 			if (!gvox->quad) { free(zbit); free(shp); free(bx0); free(gvox); return(0); }
-
-			gvox->mytex = (int *)malloc(gvox->mytexx*gvox->mytexy*sizeof(int));
-			if (!gvox->mytex) { free(gvox->quad); free(zbit); free(shp); free(bx0); free(gvox); return(0); }
+			gvox->mytex = (int *)&gvox->quad[gvox->qcnt];
 		}
 	}
 	free(shp); free(zbit); free(bx0);
@@ -1796,35 +1797,219 @@ static int loadvxl (const char *filnam)
 }
 #endif
 
+//------------------------------------------ VOX MESH CACHE ---------------------------------------
+
+	//vox2poly's quads and skin are kept in voxel.cache, keyed by the crc32 and length of the voxel
+	//file, so a model converted once is loaded with a single read from then on. The records are
+	//written in the machine's byte order, and a cache written by another kind of machine is replaced.
+	//New records are appended to the end, and a record cut short is overwritten by the next one.
+
+static const char *VOXCACHEFILE = "voxel.cache";
+static const char voxcachesig[16] = { 'V','o','x','e','l','M','e','s','h','C','a','c','h','e',1,VOXBORDWIDTH };
+#define VOXCACHEBOM 0x01020304
+
+typedef struct
+{
+	int crc, leng; //of the voxel file
+	int qcnt, qfacind[7];
+	int mytexx, mytexy;
+	int xsiz, ysiz, zsiz;
+	float xpiv, ypiv, zpiv;
+	int is8bit;
+} voxcachehead_t;
+typedef struct { voxcachehead_t head; int offs; } voxcacheent_t;
+
+static FILE *voxcachefh = 0;
+static voxcacheent_t *voxcacheent = 0;
+static int voxcachenum = 0, voxcachemax = 0, voxcacheend = 0;
+static int voxcachestate = 0; //0=not yet opened, 1=open, -1=disabled
+
+	//Returns the length of the quads and skin following a record header, or -1 if it is nonsense
+static int voxcache_datalen (const voxcachehead_t *h)
+{
+	if ((h->qcnt < 0) || (h->qcnt > (1<<20))) return(-1);
+	if ((h->mytexx < 32) || (h->mytexx > 4096) || (h->mytexy < 32) || (h->mytexy > 4096)) return(-1);
+	return(h->qcnt*sizeof(voxrect_t) + h->mytexx*h->mytexy*sizeof(int));
+}
+
+static void voxcache_addent (const voxcachehead_t *h, int offs)
+{
+	voxcacheent_t *e;
+
+	if (voxcachenum >= voxcachemax)
+	{
+		e = (voxcacheent_t *)realloc(voxcacheent,max(voxcachemax<<1,256)*sizeof(voxcacheent_t));
+		if (!e) return;
+		voxcacheent = e; voxcachemax = max(voxcachemax<<1,256);
+	}
+	voxcacheent[voxcachenum].head = *h;
+	voxcacheent[voxcachenum].offs = offs;
+	voxcachenum++;
+}
+
+static void voxcache_open (void)
+{
+	voxcachehead_t h;
+	char sig[16];
+	int i, bom, leng;
+
+	voxcachestate = -1;
+	if (!glusetexcache) return;
+
+	voxcachefh = fopen(VOXCACHEFILE,"r+b");
+	if (voxcachefh)
+	{
+		if ((fread(sig,16,1,voxcachefh) != 1) || memcmp(sig,voxcachesig,16) ||
+			 (fread(&bom,4,1,voxcachefh) != 1) || (bom != VOXCACHEBOM))
+			{ fclose(voxcachefh); voxcachefh = 0; }
+	}
+	if (!voxcachefh)
+	{
+		voxcachefh = fopen(VOXCACHEFILE,"w+b");
+		bom = VOXCACHEBOM;
+		if ((!voxcachefh) || (fwrite(voxcachesig,16,1,voxcachefh) != 1) || (fwrite(&bom,4,1,voxcachefh) != 1))
+		{
+			if (voxcachefh) { fclose(voxcachefh); voxcachefh = 0; }
+			buildprintf("VoxelCache: error opening %s, voxel cache disabled\n",VOXCACHEFILE);
+			return;
+		}
+		voxcacheend = 20;
+		voxcachestate = 1;
+		return;
+	}
+
+	fseek(voxcachefh,0,SEEK_END); leng = (int)ftell(voxcachefh);
+	for(voxcacheend=20;voxcacheend+(int)sizeof(voxcachehead_t)<=leng;voxcacheend+=sizeof(voxcachehead_t)+i)
+	{
+		fseek(voxcachefh,voxcacheend,SEEK_SET);
+		if (fread(&h,sizeof(voxcachehead_t),1,voxcachefh) != 1) break;
+		i = voxcache_datalen(&h);
+		if ((i < 0) || (voxcacheend+(int)sizeof(voxcachehead_t)+i > leng)) break;
+		voxcache_addent(&h,voxcacheend+sizeof(voxcachehead_t));
+	}
+	voxcachestate = 1;
+}
+
+static void voxcache_close (void)
+{
+	if (voxcachefh) { fclose(voxcachefh); voxcachefh = 0; }
+	if (voxcacheent) { free(voxcacheent); voxcacheent = 0; }
+	voxcachenum = voxcachemax = voxcacheend = 0;
+	voxcachestate = 0;
+}
+
+	//Computes the key of a voxel file
+static int voxcache_hashfile (const char *filnam, int *crc, int *leng)
+{
+	unsigned char buf[4096];
+	unsigned int c;
+	int i, fil;
+
+	fil = kopen4load((char *)filnam,0); if (fil < 0) return(-1);
+	*leng = kfilelength(fil);
+	crc32init(&c);
+	while ((i = kread(fil,buf,sizeof(buf))) > 0) crc32block(&c,buf,i);
+	kclose(fil);
+	*crc = (int)crc32finish(&c);
+	return(0);
+}
+
+static voxmodel *voxcache_load (int crc, int leng)
+{
+	voxcacheent_t *e;
+	voxmodel *vm;
+	int i;
+
+	for(i=voxcachenum-1;i>=0;i--)
+		if ((voxcacheent[i].head.crc == crc) && (voxcacheent[i].head.leng == leng)) break;
+	if (i < 0) return(0);
+	e = &voxcacheent[i];
+
+	vm = (voxmodel *)malloc(sizeof(voxmodel)); if (!vm) return(0);
+	memset(vm,0,sizeof(voxmodel));
+	vm->quad = (voxrect_t *)malloc(voxcache_datalen(&e->head));
+	if (!vm->quad) { free(vm); return(0); }
+
+	fseek(voxcachefh,e->offs,SEEK_SET);
+	if (fread(vm->quad,voxcache_datalen(&e->head),1,voxcachefh) != 1)
+		{ free(vm->quad); free(vm); return(0); }
+
+	vm->qcnt = e->head.qcnt; memcpy(vm->qfacind,e->head.qfacind,sizeof(vm->qfacind));
+	vm->mytexx = e->head.mytexx; vm->mytexy = e->head.mytexy;
+	vm->mytex = (int *)&vm->quad[vm->qcnt];
+	vm->xsiz = e->head.xsiz; vm->ysiz = e->head.ysiz; vm->zsiz = e->head.zsiz;
+	vm->xpiv = e->head.xpiv; vm->ypiv = e->head.ypiv; vm->zpiv = e->head.zpiv;
+	vm->is8bit = e->head.is8bit;
+	return(vm);
+}
+
+static void voxcache_write (int crc, int leng, const voxmodel *vm)
+{
+	voxcachehead_t h;
+
+	memset(&h,0,sizeof(h));
+	h.crc = crc; h.leng = leng;
+	h.qcnt = vm->qcnt; memcpy(h.qfacind,vm->qfacind,sizeof(h.qfacind));
+	h.mytexx = vm->mytexx; h.mytexy = vm->mytexy;
+	h.xsiz = vm->xsiz; h.ysiz = vm->ysiz; h.zsiz = vm->zsiz;
+	h.xpiv = vm->xpiv; h.ypiv = vm->ypiv; h.zpiv = vm->zpiv;
+	h.is8bit = vm->is8bit;
+	if (voxcache_datalen(&h) < 0) return;
+
+	fseek(voxcachefh,voxcacheend,SEEK_SET);
+	if ((fwrite(&h,sizeof(h),1,voxcachefh) != 1) ||
+		 (fwrite(vm->quad,voxcache_datalen(&h),1,voxcachefh) != 1) ||
+		 fflush(voxcachefh))
+	{
+		buildprintf("VoxelCache: error writing %s, voxel cache disabled\n",VOXCACHEFILE);
+		voxcache_close();
+		voxcachestate = -1;
+		return;
+	}
+	voxcache_addent(&h,voxcacheend+sizeof(h));
+	voxcacheend += sizeof(h)+voxcache_datalen(&h);
+}
+
 void voxfree (voxmodel *m)
 {
 	if (!m) return;
-	if (m->mytex) free(m->mytex);
-	if (m->quad) free(m->quad);
+	if (m->quad) free(m->quad); //mytex is in the same block
 	if (m->texid) free(m->texid);
 	free(m);
 }
 
 voxmodel *voxload (const char *filnam)
 {
-	int is8bit, ret;
-	voxmodel *vm;
+	int is8bit, ret, crc, leng, cached = 0;
+	voxmodel *vm = 0;
 	char *dot;
 
 	dot = strrchr(filnam, '.'); if (!dot) return(0);
-	     if (!strcasecmp(dot,".vox")) { ret = loadvox(filnam); is8bit = 1; }
-	else if (!strcasecmp(dot,".kvx")) { ret = loadkvx(filnam); is8bit = 1; }
-	else if (!strcasecmp(dot,".kv6")) { ret = loadkv6(filnam); is8bit = 0; }
-	//else if (!strcasecmp(dot,".vxl")) { ret = loadvxl(filnam); is8bit = 0; }
-	else return(0);
-	if (ret >= 0) vm = vox2poly(); else vm = 0;
+	if (strcasecmp(dot,".vox") && strcasecmp(dot,".kvx") && strcasecmp(dot,".kv6")) return(0);
+
+	if (!voxcachestate) voxcache_open();
+	if ((voxcachestate > 0) && (voxcache_hashfile(filnam,&crc,&leng) >= 0))
+		{ cached = 1; vm = voxcache_load(crc,leng); }
+
+	if (!vm)
+	{
+		     if (!strcasecmp(dot,".vox")) { ret = loadvox(filnam); is8bit = 1; }
+		else if (!strcasecmp(dot,".kvx")) { ret = loadkvx(filnam); is8bit = 1; }
+		else if (!strcasecmp(dot,".kv6")) { ret = loadkv6(filnam); is8bit = 0; }
+		//else if (!strcasecmp(dot,".vxl")) { ret = loadvxl(filnam); is8bit = 0; }
+		if (ret >= 0) vm = vox2poly();
+		if (vm)
+		{
+			vm->xsiz = xsiz; vm->ysiz = ysiz; vm->zsiz = zsiz;
+			vm->xpiv = xpiv; vm->ypiv = ypiv; vm->zpiv = zpiv;
+			vm->is8bit = is8bit;
+			if (cached && (voxcachestate > 0)) voxcache_write(crc,leng,vm);
+		}
+	}
 	if (vm)
 	{
 		vm->mdnum = 1; //VOXel model id
 		vm->scale = vm->bscale = 1.0;
-		vm->xsiz = xsiz; vm->ysiz = ysiz; vm->zsiz = zsiz;
-		vm->xpiv = xpiv; vm->ypiv = ypiv; vm->zpiv = zpiv;
-		vm->is8bit = is8bit;
 
 		vm->texid = (unsigned int *)calloc(MAXPALOOKUPS,sizeof(unsigned int));
 		if (!vm->texid) { voxfree(vm); vm = 0; }
@@ -12,12 +12,18 @@ extern int qsetmode;	// engine.c
 typedef struct _symbol {
 	const char *name;
 	struct _symbol *next;
+	struct _symbol *hashnext;
 
 	const char *help;
 	int (*func)(const osdfuncparm_t *);
 } symbol_t;
 
-static symbol_t *symbols = NULL;
+#define SYMBHASHSIZE 256	// power of two
+
+static symbol_t *symbols = NULL;			// sorted by name
+static symbol_t *symbhash[SYMBHASHSIZE];	// chained by hashnext, for exact lookups
+static symbol_t **symbindex = NULL;			// 'symbols' as an array, for prefix lookups
+static int numsymbols = 0, symbindexsize = 0;
 static symbol_t *addnewsymbol(const char *name);
 static symbol_t *findsymbol(const char *name, symbol_t *startingat);
 static symbol_t *findexactsymbol(const char *name);
@@ -282,6 +288,10 @@ void OSD_Cleanup(void)
 		s=symbols->next;
 		Bfree(symbols);
 	}
+	Bmemset(symbhash, 0, sizeof(symbhash));
+	if (symbindex) Bfree(symbindex);
+	symbindex = NULL;
+	numsymbols = symbindexsize = 0;
 
 	osdinited=0;
 }
@@ -1052,17 +1062,24 @@ int OSD_Dispatch(const char *cmd)
 {
 	char *workbuf, *wp, *wtp, *state;
 	char *parms[MAXPARMS];
-	int  numparms, restart = 0;
+	char stackbuf[EDITLENGTH+1];
+	int  numparms, restart = 0, len;
 	osdfuncparm_t ofp;
 	symbol_t *symb;
 	//int i;
 
-	workbuf = state = Bstrdup(cmd);
-	if (!workbuf) return -1;
+	len = Bstrlen(cmd);
+	if (len < (int)sizeof(stackbuf)) {
+		workbuf = stackbuf;
+		Bmemcpy(workbuf, cmd, len+1);
+	} else {
+		workbuf = Bstrdup(cmd);
+		if (!workbuf) return -1;
+	}
+	state = workbuf;
 
 	do {
 		numparms = 0;
-		Bmemset(parms, 0, sizeof(parms));
 		wp = strtoken(state, &wtp, &restart);
 		if (!wp) {
 			state = wtp;
@@ -1072,7 +1089,7 @@ int OSD_Dispatch(const char *cmd)
 		symb = findexactsymbol(wp);
 		if (!symb) {
 			OSD_Printf("Error: \"%s\" is not defined\n", wp);
-			free(workbuf);
+			if (workbuf != stackbuf) free(workbuf);
 			return -1;
 		}
 
@@ -1092,12 +1109,155 @@ int OSD_Dispatch(const char *cmd)
 		state = wtp;
 	} while (wtp && restart);
 
-	free(workbuf);
+	if (workbuf != stackbuf) free(workbuf);
 
 	return 0;
 }
 
 
+//
+// OSD_CompileScript() -- Splits a script into commands and looks up their
+//   symbols once so OSD_RunScript() can execute it repeatedly without
+//   parsing it again. Lines and semicolons both separate commands.
+//
+typedef struct {
+	symbol_t *symb;
+	const char *name;
+	int numparms, firstparm;
+} scriptcmd_t;
+
+struct osdscript {
+	char *text;		// the script, tokenised in place
+	char *raw;		// the script as given
+	scriptcmd_t *cmds;
+	const char **parms;
+	int numcmds, numparms;
+};
+
+osdscript_t *OSD_CompileScript(const char *text)
+{
+	osdscript_t *script;
+	char *p, *wp, *wtp, *state;
+	int i, len, quoted, restart = 0, cmdsize, parmsize, failed = 0;
+	void *grown;
+
+	script = (osdscript_t *)Bcalloc(1, sizeof(osdscript_t));
+	if (!script) return NULL;
+
+	len = Bstrlen(text);
+	script->text = (char *)Bmalloc(len+1);
+	script->raw  = (char *)Bmalloc(len+1);
+	cmdsize = 16; parmsize = 64;
+	script->cmds  = (scriptcmd_t *)Bmalloc(cmdsize * sizeof(scriptcmd_t));
+	script->parms = (const char **)Bmalloc(parmsize * sizeof(const char *));
+	if (!script->text || !script->raw || !script->cmds || !script->parms) {
+		OSD_FreeScript(script);
+		return NULL;
+	}
+	Bmemcpy(script->raw, text, len+1);
+	Bmemcpy(script->text, text, len+1);
+
+	// line ends outside of quotes end a command the way a semicolon does
+	for (quoted = 0, p = script->text; *p; p++) {
+		if (*p == '\"') quoted = !quoted;
+		else if (*p == '\\' && quoted && p[1]) p++;
+		else if (*p == '\n' || *p == '\r') {
+			if (quoted) continue;
+			*p = ';';
+		}
+		else if (*p == '\t' && !quoted) *p = ' ';
+	}
+
+	state = script->text;
+	do {
+		wp = strtoken(state, &wtp, &restart);
+		if (!wp) {
+			state = wtp;
+			continue;
+		}
+
+		if (script->numcmds == cmdsize) {
+			grown = Brealloc(script->cmds, cmdsize * 2 * sizeof(scriptcmd_t));
+			if (!grown) { failed = 1; break; }
+			script->cmds = (scriptcmd_t *)grown;
+			cmdsize *= 2;
+		}
+		i = script->numcmds++;
+		script->cmds[i].symb = findexactsymbol(wp);
+		script->cmds[i].name = wp;
+		script->cmds[i].numparms = 0;
+		script->cmds[i].firstparm = script->numparms;
+		if (!script->cmds[i].symb) {
+			OSD_Printf("Error: \"%s\" is not defined\n", wp);
+			failed = 1;
+		}
+
+		while (wtp && !restart) {
+			wp = strtoken(NULL, &wtp, &restart);
+			if (!wp || script->cmds[i].numparms >= MAXPARMS) continue;
+			if (script->numparms == parmsize) {
+				grown = Brealloc((void *)script->parms, parmsize * 2 * sizeof(const char *));
+				if (!grown) { failed = 1; break; }
+				script->parms = (const char **)grown;
+				parmsize *= 2;
+			}
+			script->parms[script->numparms++] = wp;
+			script->cmds[i].numparms++;
+		}
+		if (failed) break;
+
+		state = wtp;
+	} while (wtp && restart);
+
+	if (failed) {
+		OSD_FreeScript(script);
+		return NULL;
+	}
+
+	return script;
+}
+
+
+//
+// OSD_RunScript() -- Executes every command of a compiled script
+//
+int OSD_RunScript(const osdscript_t *script)
+{
+	osdfuncparm_t ofp;
+	const scriptcmd_t *cmd;
+	int i;
+
+	if (!script) return -1;
+
+	ofp.raw = script->raw;
+	for (i = 0, cmd = script->cmds; i < script->numcmds; i++, cmd++) {
+		ofp.name     = cmd->name;
+		ofp.numparms = cmd->numparms;
+		ofp.parms    = &script->parms[cmd->firstparm];
+		switch (cmd->symb->func(&ofp)) {
+			case OSDCMD_OK: break;
+			case OSDCMD_SHOWHELP: OSD_Printf("%s\n", cmd->symb->help); break;
+		}
+	}
+
+	return 0;
+}
+
+
+//
+// OSD_FreeScript() -- Releases a compiled script
+//
+void OSD_FreeScript(osdscript_t *script)
+{
+	if (!script) return;
+	if (script->text) Bfree(script->text);
+	if (script->raw) Bfree(script->raw);
+	if (script->cmds) Bfree(script->cmds);
+	if (script->parms) Bfree((void *)script->parms);
+	Bfree(script);
+}
+
+
 //
 // OSD_RegisterFunction() -- Registers a new function
 //
@@ -1164,17 +1324,41 @@ int OSD_RegisterFunction(const char *name, const char *help, int (*func)(const o
 }
 
 
+//
+// symbhashof() -- Case-insensitive hash of a symbol name
+//
+static unsigned int symbhashof(const char *name)
+{
+	unsigned int h = 0;
+
+	for (; *name; name++)
+		h = h * 31 + (unsigned char)Btolower(*name);
+
+	return h & (SYMBHASHSIZE-1);
+}
+
+
 //
 // addnewsymbol() -- Allocates space for a new symbol and attaches it
-//   appropriately to the lists, sorted.
+//   appropriately to the lists, sorted, the hash table and the index.
 //
 static symbol_t *addnewsymbol(const char *name)
 {
-	symbol_t *newsymb, *s, *t;
+	symbol_t *newsymb, *s, *t, **grown;
+	unsigned int h;
+	int i;
+
+	if (numsymbols == symbindexsize) {
+		grown = (symbol_t **)Brealloc(symbindex, (symbindexsize + 64) * sizeof(symbol_t *));
+		if (!grown) { return NULL; }
+		symbindex = grown;
+		symbindexsize += 64;
+	}
 
 	newsymb = (symbol_t *)Bmalloc(sizeof(symbol_t));
 	if (!newsymb) { return NULL; }
 	Bmemset(newsymb, 0, sizeof(symbol_t));
+	newsymb->name = name;
 
 	// link it to the main chain
 	if (!symbols) {
@@ -1196,20 +1380,43 @@ static symbol_t *addnewsymbol(const char *name)
 		}
 	}
 
+	// and to the hash chain and sorted index
+	h = symbhashof(name);
+	newsymb->hashnext = symbhash[h];
+	symbhash[h] = newsymb;
+
+	for (i = numsymbols; i > 0 && Bstrcasecmp(symbindex[i-1]->name, name) > 0; i--)
+		symbindex[i] = symbindex[i-1];
+	symbindex[i] = newsymb;
+	numsymbols++;
+
 	return newsymb;
 }
 
 
 //
-// findsymbol() -- Finds a symbol, possibly partially named
+// findsymbol() -- Finds a symbol, possibly partially named. Symbols sharing a
+//   prefix sit together in the sorted chain, so the first is found by
+//   bisecting the index and the rest follow it.
 //
 static symbol_t *findsymbol(const char *name, symbol_t *startingat)
 {
-	if (!startingat) startingat = symbols;
-	if (!startingat) return NULL;
+	int len, lo, hi, mid;
+
+	len = Bstrlen(name);
+
+	if (startingat) {
+		if (!Bstrncasecmp(name, startingat->name, len)) return startingat;
+		return NULL;
+	}
 
-	for (; startingat; startingat=startingat->next)
-		if (!Bstrncasecmp(name, startingat->name, Bstrlen(name))) return startingat;
+	lo = 0; hi = numsymbols;
+	while (lo < hi) {
+		mid = (lo + hi) >> 1;
+		if (Bstrncasecmp(symbindex[mid]->name, name, len) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	if (lo < numsymbols && !Bstrncasecmp(name, symbindex[lo]->name, len)) return symbindex[lo];
 
 	return NULL;
 }
@@ -1220,13 +1427,10 @@ static symbol_t *findsymbol(const char *name, symbol_t *startingat)
 //
 static symbol_t *findexactsymbol(const char *name)
 {
-	symbol_t *startingat;
-	if (!symbols) return NULL;
-
-	startingat = symbols;
+	symbol_t *s;
 
-	for (; startingat; startingat=startingat->next)
-		if (!Bstrcasecmp(name, startingat->name)) return startingat;
+	for (s = symbhash[symbhashof(name)]; s; s = s->hashnext)
+		if (!Bstrcasecmp(name, s->name)) return s;
 
 	return NULL;
 }
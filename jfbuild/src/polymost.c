@@ -150,6 +150,8 @@ static struct {
 	GLuint vao;					// Vertex array object.
 	GLuint program;             // GLSL program object.
 	GLuint elementbuffer;
+	GLuint batchbuffer;         // Streaming vertices for batched polygons.
+	GLuint batchindexbuffer;    // Streaming indexes for batched polygons.
 	GLint attrib_vertex;		// Vertex (vec3)
 	GLint attrib_texcoord;		// Texture coordinate (vec2)
 	GLint uniform_modelview;	// Modelview matrix (mat4)
@@ -184,6 +186,18 @@ static struct {
 static GLuint elementindexbuffer = 0;
 static GLuint elementindexbuffersize = 0;
 
+// Polygon batching state. See polymost_flushbatch().
+#define MAXBATCHVERTS 65536     // Limit of GLushort indexes.
+static int glpolybatch = 1;     // 0 = draw each polygon immediately.
+static int batchactive = 0;
+static int batchordered = 0;    // !0 = draw in submission order, see polymost_flushrotatesprites().
+static struct polymostbatchpoly *batchpoly = NULL;
+static int numbatchpolys = 0, allocbatchpolys = 0;
+static struct polymostvboitem *batchvbo = NULL;
+static int numbatchverts = 0, allocbatchverts = 0;
+static GLushort *batchindexes = NULL;
+static int allocbatchindexes = 0;
+
 const GLfloat gidentitymat[4][4] = {
 	{1.f, 0.f, 0.f, 0.f},
 	{0.f, 1.f, 0.f, 0.f},
@@ -368,6 +382,9 @@ void gltexapplyprops (void)
 			if (pth->pic[i] == 0 || pth->pic[i]->glpic == 0) {
 				continue;
 			}
+			if (pth->pic[i]->flags & PTH_ATLAS) {
+				continue;	// see PTAtlasApplyParameters below
+			}
 			glfunc.glBindTexture(GL_TEXTURE_2D,pth->pic[i]->glpic);
 			glfunc.glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,glfiltermodes[gltexfiltermode].mag);
 			glfunc.glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,glfiltermodes[gltexfiltermode].min);
@@ -379,6 +396,7 @@ void gltexapplyprops (void)
 		}
 	}
 	PTIterFree(iter);
+	PTAtlasApplyParameters();
 
 	{
 		int j;
@@ -444,6 +462,10 @@ void polymost_glreset (void)
 	lastglpolygonmode = -1;
 	lastglredbluemode = -1;
 
+	numbatchpolys = numbatchverts = 0;
+	batchactive = 0;
+	batchordered = 0;
+
 	if (glfunc.glUseProgram) {
 		glfunc.glUseProgram(0);
 #if (USE_OPENGL == USE_GL3)
@@ -469,6 +491,14 @@ void polymost_glreset (void)
 		glfunc.glDeleteBuffers(1, &polymostglsl.elementbuffer);
 		polymostglsl.elementbuffer = 0;
 	}
+	if (polymostglsl.batchbuffer) {
+		glfunc.glDeleteBuffers(1, &polymostglsl.batchbuffer);
+		polymostglsl.batchbuffer = 0;
+	}
+	if (polymostglsl.batchindexbuffer) {
+		glfunc.glDeleteBuffers(1, &polymostglsl.batchindexbuffer);
+		polymostglsl.batchindexbuffer = 0;
+	}
 	if (polymostglsl.program) {
 		glfunc.glDeleteProgram(polymostglsl.program);
 		polymostglsl.program = 0;
@@ -627,6 +657,10 @@ static void polymost_loadshaders(void)
 
 		// Generate a buffer object for vertex/colour elements.
 		glfunc.glGenBuffers(1, &polymostglsl.elementbuffer);
+
+		// Generate buffer objects for the polygon batcher to stream into.
+		glfunc.glGenBuffers(1, &polymostglsl.batchbuffer);
+		glfunc.glGenBuffers(1, &polymostglsl.batchindexbuffer);
 	}
 
 	// A fully transparent texture for the case when a glow texture is not needed.
@@ -761,6 +795,8 @@ void polymost_aftershowframe(void)
 
 void polymost_setview(void)
 {
+	polymost_flushrotatesprites();
+
 	memset(gdrawroomsprojmat,0,sizeof(gdrawroomsprojmat));
 	gdrawroomsprojmat[0][0] = (float)ydimen; gdrawroomsprojmat[0][2] = 1.0;
 	gdrawroomsprojmat[1][1] = (float)xdimen; gdrawroomsprojmat[1][2] = 1.0;
@@ -788,6 +824,8 @@ void polymost_drawpoly_glcall(GLenum mode, struct polymostdrawpolycall *draw)
 	polymostcallcounts.drawpoly_glcall++;
 #endif
 
+	polymost_flushrotatesprites();
+
 	glfunc.glUseProgram(polymostglsl.program);
 
 #if (USE_OPENGL == USE_GL3)
@@ -853,12 +891,275 @@ void polymost_drawpoly_glcall(GLenum mode, struct polymostdrawpolycall *draw)
 #endif
 }
 
+// Polygon batching.
+//
+// drawpoly() would otherwise pay for a program bind, attribute setup, two
+// texture binds, seven uniform uploads and a buffer upload per polygon. While
+// drawrooms() lays down the opaque world with depth testing set to GL_ALWAYS,
+// polymost's own span clipping guarantees no two polygons overlap, so their
+// order is free. Polygons are gathered into one streaming vertex buffer,
+// sorted by render state, converted to indexed triangles, and each run of
+// identical state becomes a single draw.
+//
+// rotatesprite() batches too, so that a HUD built from tiles packed into the
+// same atlas draws in a few calls. Those polygons overlap and must keep their
+// order, so the batch is drawn unsorted, each run of identical state in
+// sequence, and anything else that draws flushes it first.
+
+struct polymostbatchpoly {
+	GLuint texture0;
+	GLuint texture1;
+	GLfloat alphacut;
+	coltypef colour;
+	coltypef fogcolour;
+	GLfloat fogdensity;
+	const GLfloat *modelview;
+	const GLfloat *projection;
+	int blend;
+
+	int firstvert, numverts;    // Range in batchvbo.
+	int firstindex;             // Set when the index list is built.
+	int seq;                    // Submission order, to keep the sort stable.
+};
+
+static int polymost_batchkeycmp(const struct polymostbatchpoly *a, const struct polymostbatchpoly *b)
+{
+	int c;
+
+	if (a->blend != b->blend) return a->blend - b->blend;
+	if (a->texture0 != b->texture0) return a->texture0 < b->texture0 ? -1 : 1;
+	if (a->texture1 != b->texture1) return a->texture1 < b->texture1 ? -1 : 1;
+	if (a->alphacut != b->alphacut) return a->alphacut < b->alphacut ? -1 : 1;
+	if (a->fogdensity != b->fogdensity) return a->fogdensity < b->fogdensity ? -1 : 1;
+	if (a->projection != b->projection) return a->projection < b->projection ? -1 : 1;
+	if (a->modelview != b->modelview) return a->modelview < b->modelview ? -1 : 1;
+	if ((c = memcmp(&a->fogcolour, &b->fogcolour, sizeof(coltypef)))) return c;
+	return memcmp(&a->colour, &b->colour, sizeof(coltypef));
+}
+
+static int polymost_batchsortcmp(const void *va, const void *vb)
+{
+	const struct polymostbatchpoly *a = (const struct polymostbatchpoly *)va;
+	const struct polymostbatchpoly *b = (const struct polymostbatchpoly *)vb;
+	int c = polymost_batchkeycmp(a, b);
+
+	if (c) return c;
+	return a->seq - b->seq;
+}
+
+static void polymost_flushbatch(void)
+{
+	struct polymostbatchpoly *p, *last;
+	int i, j, k, numindexes;
+
+	if (numbatchpolys == 0) return;
+
+#ifdef DEBUGGINGAIDS
+	polymostcallcounts.batchpolys += numbatchpolys;
+	for (i = 1, k = 1; i < numbatchpolys; i++) {
+		if (batchpoly[i].texture0 != batchpoly[i-1].texture0) k++;
+	}
+	polymostcallcounts.batchtexchanges_in += k;
+#endif
+
+	if (!batchordered) {
+		qsort(batchpoly, numbatchpolys, sizeof(struct polymostbatchpoly), polymost_batchsortcmp);
+	}
+
+	// Fan each polygon out into triangles in sorted order.
+	numindexes = 0;
+	for (i = 0; i < numbatchpolys; i++) {
+		numindexes += (batchpoly[i].numverts - 2) * 3;
+	}
+	if (numindexes > allocbatchindexes) {
+		GLushort *idx = (GLushort *)realloc(batchindexes, numindexes * sizeof(GLushort));
+		if (!idx) {
+			numbatchpolys = numbatchverts = 0;
+			return;
+		}
+		batchindexes = idx;
+		allocbatchindexes = numindexes;
+	}
+	for (i = 0, k = 0; i < numbatchpolys; i++) {
+		p = &batchpoly[i];
+		p->firstindex = k;
+		for (j = 2; j < p->numverts; j++) {
+			batchindexes[k++] = (GLushort)(p->firstvert);
+			batchindexes[k++] = (GLushort)(p->firstvert + j - 1);
+			batchindexes[k++] = (GLushort)(p->firstvert + j);
+		}
+	}
+
+	glfunc.glUseProgram(polymostglsl.program);
+
+#if (USE_OPENGL == USE_GL3)
+	glfunc.glBindVertexArray(polymostglsl.vao);
+#else
+	glfunc.glEnableVertexAttribArray(polymostglsl.attrib_vertex);
+	glfunc.glEnableVertexAttribArray(polymostglsl.attrib_texcoord);
+#endif
+
+	glfunc.glBindBuffer(GL_ARRAY_BUFFER, polymostglsl.batchbuffer);
+	glfunc.glBufferData(GL_ARRAY_BUFFER, numbatchverts * sizeof(struct polymostvboitem), batchvbo, GL_STREAM_DRAW);
+	glfunc.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, polymostglsl.batchindexbuffer);
+	glfunc.glBufferData(GL_ELEMENT_ARRAY_BUFFER, numindexes * sizeof(GLushort), batchindexes, GL_STREAM_DRAW);
+
+	glfunc.glVertexAttribPointer(polymostglsl.attrib_vertex, 3, GL_FLOAT, GL_FALSE,
+		sizeof(struct polymostvboitem), (const GLvoid *)offsetof(struct polymostvboitem, v));
+	glfunc.glVertexAttribPointer(polymostglsl.attrib_texcoord, 2, GL_FLOAT, GL_FALSE,
+		sizeof(struct polymostvboitem), (const GLvoid *)offsetof(struct polymostvboitem, t));
+
+	glfunc.glUniform1f(polymostglsl.uniform_gamma, usegammabrightness == 1 ? curgamma : 1.0);
+	glfunc.glDepthMask(GL_TRUE);
+
+	// Issue one draw per run of identical state, touching only what changed.
+	last = NULL;
+	for (i = 0; i < numbatchpolys; i = j) {
+		p = &batchpoly[i];
+		for (j = i + 1; j < numbatchpolys && !polymost_batchkeycmp(p, &batchpoly[j]); j++) ;
+		k = batchpoly[j-1].firstindex + (batchpoly[j-1].numverts - 2) * 3 - p->firstindex;
+
+		if (!last || last->blend != p->blend) {
+			if (p->blend) glfunc.glEnable(GL_BLEND);
+			else glfunc.glDisable(GL_BLEND);
+		}
+		if (!last || last->texture0 != p->texture0) {
+			glfunc.glActiveTexture(GL_TEXTURE0);
+			glfunc.glBindTexture(GL_TEXTURE_2D, p->texture0);
+#ifdef DEBUGGINGAIDS
+			polymostcallcounts.batchtexchanges++;
+#endif
+		}
+		if (!last || last->texture1 != p->texture1) {
+			glfunc.glActiveTexture(GL_TEXTURE1);
+			glfunc.glBindTexture(GL_TEXTURE_2D, p->texture1 ? p->texture1 : nulltexture);
+		}
+		if (!last || last->alphacut != p->alphacut) {
+			glfunc.glUniform1f(polymostglsl.uniform_alphacut, p->alphacut);
+		}
+		if (!last || memcmp(&last->colour, &p->colour, sizeof(coltypef))) {
+			glfunc.glUniform4f(polymostglsl.uniform_colour,
+				p->colour.r, p->colour.g, p->colour.b, p->colour.a);
+		}
+		if (!last || memcmp(&last->fogcolour, &p->fogcolour, sizeof(coltypef))) {
+			glfunc.glUniform4f(polymostglsl.uniform_fogcolour,
+				p->fogcolour.r, p->fogcolour.g, p->fogcolour.b, p->fogcolour.a);
+		}
+		if (!last || last->fogdensity != p->fogdensity) {
+			glfunc.glUniform1f(polymostglsl.uniform_fogdensity, p->fogdensity);
+		}
+		if (!last || last->modelview != p->modelview) {
+			glfunc.glUniformMatrix4fv(polymostglsl.uniform_modelview, 1, GL_FALSE, p->modelview);
+		}
+		if (!last || last->projection != p->projection) {
+			glfunc.glUniformMatrix4fv(polymostglsl.uniform_projection, 1, GL_FALSE, p->projection);
+		}
+
+		glfunc.glDrawElements(GL_TRIANGLES, k, GL_UNSIGNED_SHORT,
+			(const GLvoid *)(intptr_t)(p->firstindex * sizeof(GLushort)));
+#ifdef DEBUGGINGAIDS
+		polymostcallcounts.batchdraws++;
+#endif
+		last = p;
+	}
+
+#if (USE_OPENGL == USE_GL3)
+	glfunc.glBindVertexArray(0);
+#else
+	glfunc.glDisableVertexAttribArray(polymostglsl.attrib_vertex);
+	glfunc.glDisableVertexAttribArray(polymostglsl.attrib_texcoord);
+#endif
+
+	numbatchpolys = 0;
+	numbatchverts = 0;
+}
+
+static void polymost_beginbatch(int ordered)
+{
+	polymost_flushrotatesprites();
+
+	numbatchpolys = 0;
+	numbatchverts = 0;
+	batchactive = (glpolybatch && polymostglsl.batchbuffer);
+	batchordered = ordered;
+}
+
+static void polymost_endbatch(void)
+{
+	polymost_flushbatch();
+	batchactive = 0;
+	batchordered = 0;
+}
+
+	// Draws the rotatesprite() polygons gathered so far. Called before
+	// anything else draws or changes the GL state they were queued under.
+void polymost_flushrotatesprites(void)
+{
+	if (batchactive && batchordered) {
+		polymost_endbatch();
+	}
+}
+
+	// Draws a polygon fan built by drawpoly(), or queues it if a batch is open.
+static void polymost_drawpoly_fan(struct polymostdrawpolycall *draw, int blend)
+{
+	struct polymostbatchpoly *p;
+
+	if (batchactive) {
+		if (numbatchverts + (int)draw->elementcount > MAXBATCHVERTS) {
+			polymost_flushbatch();
+		}
+		if (numbatchpolys >= allocbatchpolys) {
+			int n = allocbatchpolys ? allocbatchpolys * 2 : 1024;
+			p = (struct polymostbatchpoly *)realloc(batchpoly, n * sizeof(struct polymostbatchpoly));
+			if (!p) goto drawnow;
+			batchpoly = p;
+			allocbatchpolys = n;
+		}
+		if (numbatchverts + (int)draw->elementcount > allocbatchverts) {
+			int n = allocbatchverts ? allocbatchverts * 2 : 4096;
+			struct polymostvboitem *v;
+			while (n < numbatchverts + (int)draw->elementcount) n *= 2;
+			v = (struct polymostvboitem *)realloc(batchvbo, n * sizeof(struct polymostvboitem));
+			if (!v) goto drawnow;
+			batchvbo = v;
+			allocbatchverts = n;
+		}
+
+		p = &batchpoly[numbatchpolys];
+		p->texture0 = draw->texture0;
+		p->texture1 = draw->texture1;
+		p->alphacut = draw->alphacut;
+		p->colour = draw->colour;
+		p->fogcolour = draw->fogcolour;
+		p->fogdensity = draw->fogdensity;
+		p->modelview = draw->modelview;
+		p->projection = draw->projection;
+		p->blend = blend;
+		p->firstvert = numbatchverts;
+		p->numverts = draw->elementcount;
+		p->seq = numbatchpolys++;
+
+		memcpy(&batchvbo[numbatchverts], draw->elementvbo, draw->elementcount * sizeof(struct polymostvboitem));
+		numbatchverts += draw->elementcount;
+		return;
+	}
+
+drawnow:
+	if (blend) glfunc.glEnable(GL_BLEND);
+	else glfunc.glDisable(GL_BLEND);
+	glfunc.glDepthMask(GL_TRUE);
+	polymost_drawpoly_glcall(GL_TRIANGLE_FAN, draw);
+}
+
 static void polymost_drawaux_glcall(GLenum mode, struct polymostdrawauxcall *draw)
 {
 #ifdef DEBUGGINGAIDS
 	polymostcallcounts.drawaux_glcall++;
 #endif
 
+	polymost_flushrotatesprites();
+
 	glfunc.glUseProgram(polymostauxglsl.program);
 
 #if (USE_OPENGL == USE_GL3)
@@ -958,7 +1259,9 @@ static void polymost_palfade(void)
 void polymost_nextpage(void)
 {
 #if USE_OPENGL
+	polymost_flushrotatesprites();
 	polymost_palfade();
+	PTServiceLoader();
 #endif
 
 #ifdef DEBUGGINGAIDS
@@ -966,14 +1269,19 @@ void polymost_nextpage(void)
 		char buf[1024];
 		sprintf(buf,
 			"drawpoly_gl(%d) drawaux_gl(%d) drawpoly(%d) "
-			"domost(%d) drawalls(%d) drawmaskwall(%d) drawsprite(%d)",
+			"domost(%d) drawalls(%d) drawmaskwall(%d) drawsprite(%d) "
+			"batch: polys(%d) draws(%d) texbinds(%d->%d)",
 	    		polymostcallcounts.drawpoly_glcall,
 	    		polymostcallcounts.drawaux_glcall,
 	    		polymostcallcounts.drawpoly,
 	    		polymostcallcounts.domost,
 	    		polymostcallcounts.drawalls,
 	    		polymostcallcounts.drawmaskwall,
-	    		polymostcallcounts.drawsprite
+	    		polymostcallcounts.drawsprite,
+	    		polymostcallcounts.batchpolys,
+	    		polymostcallcounts.batchdraws,
+	    		polymostcallcounts.batchtexchanges_in,
+	    		polymostcallcounts.batchtexchanges
 		);
 		printext256(0, 8, 31, -1, buf, 0);
 	}
@@ -1077,13 +1385,13 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 
 #if USE_OPENGL
 	int nn;
-	double uoffs, du0 = 0.0, du1 = 0.0, dui, duj;
+	double uoffs, du0 = 0.0, du1 = 0.0, dui, duj, atlasu = 0.0, atlasv = 0.0;
 
 	if (rendmode == 3)
 	{
 		float hackscx, hackscy;
 		unsigned short ptflags = 0;
-		int picidx = PTHPIC_BASE;
+		int picidx = PTHPIC_BASE, blend;
 		PTHead * pth = 0;
 		struct polymostdrawpolycall draw;
 		struct polymostvboitem vboitem[MINVBOINDEXES];
@@ -1091,6 +1399,7 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 		if (usehightile) ptflags |= PTH_HIGHTILE;
 		if (method & METH_CLAMPED) ptflags |= PTH_CLAMPED;
 		if (drawingskybox) ptflags |= PTH_SKYBOX;
+		if (method & METH_ROTATESPRITE) ptflags |= PTH_ATLAS;
 
 		pth = PT_GetHead(globalpicnum, globalpal, ptflags, 0);
 
@@ -1114,7 +1423,7 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 		}
 
 		if (!(method & (METH_MASKED | METH_TRANS))) {
-			glfunc.glDisable(GL_BLEND);
+			blend = 0;
 			draw.alphacut = 0.f;
 		} else {
 			float alphac = 0.32;
@@ -1124,7 +1433,7 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 			if (usegoodalpha) alphac = 0.0;
 			if (!waloff[globalpicnum]) alphac = 0.0;	// invalid textures ignore the alpha cutoff settings
 
-			glfunc.glEnable(GL_BLEND);
+			blend = 1;
 			draw.alphacut = alphac;
 		}
 
@@ -1305,12 +1614,15 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 				draw.indexcount = nn;
 				draw.elementcount = nn;
 
-				glfunc.glDepthMask(GL_TRUE);
-				polymost_drawpoly_glcall(GL_TRIANGLE_FAN, &draw);
+				polymost_drawpoly_fan(&draw, blend);
 			}
 		}
 		else if (n > 0)
 		{
+			if (pth->pic[picidx]->flags & PTH_ATLAS) {
+				atlasu = (double)pth->pic[picidx]->atlasx*ox2;
+				atlasv = (double)pth->pic[picidx]->atlasy*oy2;
+			}
 			ox2 *= hackscx; oy2 *= hackscy;
 
 			for(i=0;i<n;i++)
@@ -1320,14 +1632,13 @@ void drawpoly (double *dpx, double *dpy, int n, int method)
 				vboitem[i].v.x = (px[i]-ghalfx)*r*grhalfxdown10x;
 				vboitem[i].v.y = (ghoriz-py[i])*r*grhalfxdown10;
 				vboitem[i].v.z = r*(1.0/1024.0);
-				vboitem[i].t.s = uu[i]*r*ox2;
-				vboitem[i].t.t = vv[i]*r*oy2;
+				vboitem[i].t.s = uu[i]*r*ox2 + atlasu;
+				vboitem[i].t.t = vv[i]*r*oy2 + atlasv;
 			}
 			draw.indexcount = n;
 			draw.elementcount = n;
 
-			glfunc.glDepthMask(GL_TRUE);
-			polymost_drawpoly_glcall(GL_TRIANGLE_FAN, &draw);
+			polymost_drawpoly_fan(&draw, blend);
 		}
 
 		return;
@@ -2990,6 +3301,7 @@ void polymost_drawrooms (void)
 #if USE_OPENGL
 	if (rendmode == 3)
 	{
+		polymost_flushrotatesprites();
 		resizeglcheck();
 
 		glfunc.glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
@@ -3096,6 +3408,11 @@ void polymost_drawrooms (void)
 	}
 	initmosts(sx,sy,n2);
 
+#if USE_OPENGL
+		//Opened here, past the early return, so the endbatch below always closes it
+	if (rendmode == 3) polymost_beginbatch(0);
+#endif
+
 	if (searchit == 2)
 	{
 		short hitsect, hitwall, hitsprite;
@@ -3210,6 +3527,8 @@ void polymost_drawrooms (void)
 #if USE_OPENGL
 	if (rendmode == 3)
 	{
+		polymost_endbatch();
+
 		glfunc.glDepthFunc(GL_LEQUAL); //NEVER,LESS,(,L)EQUAL,GREATER,(NOT,G)EQUAL,ALWAYS
 
 		//glfunc.glPolygonOffset(0,0);
@@ -3235,6 +3554,10 @@ void polymost_drawmaskwall (int damaskwallcnt)
 	polymostcallcounts.drawmaskwall++;
 #endif
 
+#if USE_OPENGL
+	polymost_flushrotatesprites();
+#endif
+
 	z = maskwall[damaskwallcnt];
 	wal = &wall[thewall[z]]; wal2 = &wall[wal->point2];
 	sectnum = thesector[z]; sec = &sector[sectnum];
@@ -3397,6 +3720,10 @@ void polymost_drawsprite (int snum)
 	polymostcallcounts.drawsprite++;
 #endif
 
+#if USE_OPENGL
+	polymost_flushrotatesprites();
+#endif
+
 	tspr = tspriteptr[snum];
 	if (tspr->owner < 0 || tspr->picnum < 0) return;
 
@@ -3799,6 +4126,7 @@ void polymost_dorotatesprite (int sx, int sy, int z, short a, short picnum,
 			tspr.owner = uniqid+MAXSPRITES;
 			globalorientation = (dastat&1)+((dastat&32)<<4)+((dastat&4)<<1);
 
+			polymost_flushrotatesprites();
 			if ((dastat&10) == 2) glfunc.glViewport(windowx1,yres-(windowy2+1),windowx2-windowx1+1,windowy2-windowy1+1);
 			else { glfunc.glViewport(0,0,xdim,ydim); glox1 = -1; } //Force fullscreen (glox1=-1 forces it to restore)
 
@@ -3850,6 +4178,11 @@ void polymost_dorotatesprite (int sx, int sy, int z, short a, short picnum,
 	{
 		glfunc.glViewport(0,0,xdim,ydim); glox1 = -1; //Force fullscreen (glox1=-1 forces it to restore)
 		glfunc.glDisable(GL_DEPTH_TEST);
+		if (!batchactive) {
+			// gather this and the rotatesprites that follow it,
+			// see polymost_flushrotatesprites()
+			polymost_beginbatch(1);
+		}
 	}
 #endif
 
@@ -4170,6 +4503,8 @@ void polymost_fillpolygon (int npoints)
 	unsigned short ptflags = 0;
 	struct polymostdrawpolycall draw;
 
+	polymost_flushrotatesprites();
+
 	globalx1 = mulscale16(globalx1,xyaspect);
 	globaly2 = mulscale16(globaly2,xyaspect);
 	gux = ((double)asm1)*(1.0/4294967296.0);
@@ -4234,6 +4569,8 @@ int polymost_drawtilescreen (int tilex, int tiley, int wallnum, int dimen)
 
 	if ((rendmode != 3) || (qsetmode != 200)) return(-1);
 
+	polymost_flushrotatesprites();
+
 	xdime = (float)tilesizx[wallnum];
 	ydime = (float)tilesizy[wallnum];
 
@@ -4326,6 +4663,7 @@ int polymost_printext256(int xpos, int ypos, short col, short backcol, const  ch
 
 	if ((rendmode != 3) || (qsetmode != 200)) return(-1);
 
+	polymost_flushrotatesprites();
 	polymost_preparetext();
 	setpolymost2dview();	// disables blending, texturing, and depth testing
 	glfunc.glDepthMask(GL_FALSE);	// disable writing to the z-buffer
@@ -4437,6 +4775,8 @@ int polymost_drawline256(int x1, int y1, int x2, int y2, unsigned char col)
 
 	if ((rendmode != 3) || (qsetmode != 200)) return(-1);
 
+	polymost_flushrotatesprites();
+
 	polymost_preparetext();
 	setpolymost2dview();	// disables blending, texturing, and depth testing
 	glfunc.glDepthMask(GL_FALSE);	// disable writing to the z-buffer
@@ -4483,6 +4823,8 @@ int polymost_plotpixel(int x, int y, unsigned char col)
 
 	if ((rendmode != 3) || (qsetmode != 200)) return(-1);
 
+	polymost_flushrotatesprites();
+
 	setpolymost2dview();	// disables blending, texturing, and depth testing
 	glfunc.glDepthMask(GL_FALSE);	// disable writing to the z-buffer
 	glfunc.glEnable(GL_BLEND);
@@ -4810,6 +5152,21 @@ static int osdcmd_polymostvars(const osdfuncparm_t *parm)
 		else glpolygonmode = val;
 		return OSDCMD_OK;
 	}
+	else if (!Bstrcasecmp(parm->name, "glpolybatch")) {
+		if (showval) { buildprintf("glpolybatch is %d\n", glpolybatch); }
+		else glpolybatch = (val != 0);
+		return OSDCMD_OK;
+	}
+	else if (!Bstrcasecmp(parm->name, "gltexasyncload")) {
+		if (showval) { buildprintf("gltexasyncload is %d\n", gltexasyncload); }
+		else gltexasyncload = (val != 0);
+		return OSDCMD_OK;
+	}
+	else if (!Bstrcasecmp(parm->name, "gltexuploadbudget")) {
+		if (showval) { buildprintf("gltexuploadbudget is %d\n", gltexuploadbudget); }
+		else gltexuploadbudget = max(0, val);
+		return OSDCMD_OK;
+	}
 	else if (!Bstrcasecmp(parm->name, "glusetexcache")) {
 		if (showval) { buildprintf("glusetexcache is %d\n", glusetexcache); }
 		else glusetexcache = (val != 0);
@@ -4866,7 +5223,10 @@ void polymost_initosdfuncs(void)
 	OSD_RegisterFunction("gltexturemiplevel","gltexturemiplevel: changes the highest OpenGL mipmap level used",osdcmd_polymostvars);
 	OSD_RegisterFunction("usegoodalpha","usegoodalpha: enable/disable better looking OpenGL alpha hack",osdcmd_polymostvars);
 	OSD_RegisterFunction("glpolygonmode","glpolygonmode: debugging feature. 0 = normal, 1 = edges, 2 = points, 3 = clear each frame",osdcmd_polymostvars);
-	OSD_RegisterFunction("glusetexcache","glusetexcache: enable/disable OpenGL compressed texture cache",osdcmd_polymostvars);
+	OSD_RegisterFunction("glpolybatch","glpolybatch: enable/disable batching of OpenGL world polygons and rotatesprites",osdcmd_polymostvars);
+	OSD_RegisterFunction("glusetexcache","glusetexcache: enable/disable the OpenGL compressed texture and voxel mesh caches",osdcmd_polymostvars);
+	OSD_RegisterFunction("gltexasyncload","gltexasyncload: enable/disable preparing hightile textures in the background",osdcmd_polymostvars);
+	OSD_RegisterFunction("gltexuploadbudget","gltexuploadbudget: kilobytes of background-loaded textures sent to OpenGL each frame",osdcmd_polymostvars);
 	OSD_RegisterFunction("glmultisample","glmultisample: enable/disable OpenGL (edge) multisampling. 0 = off, 1 = 2x, 2 = 4x",osdcmd_polymostvars);
 	OSD_RegisterFunction("glnvmultisamplehint","glnvmultisamplehint: enable/disable Nvidia multisampling (Quincunx)",osdcmd_polymostvars);
 	OSD_RegisterFunction("glsampleshading","glsampleshading: enable/disable OpenGL sample multisampling",osdcmd_polymostvars);
@@ -17,6 +17,10 @@ struct polymostcallcounts {
     int drawalls;
     int drawmaskwall;
     int drawsprite;
+    int batchpolys;             // Polygons queued by the batcher.
+    int batchdraws;             // Draws issued for them.
+    int batchtexchanges_in;     // Texture changes in submission order.
+    int batchtexchanges;        // Texture changes after sorting.
 };
 extern struct polymostcallcounts polymostcallcounts;
 #endif
@@ -118,6 +122,7 @@ int polymost_drawline256(int x1, int y1, int x2, int y2, unsigned char col);
 int polymost_plotpixel(int x, int y, unsigned char col);
 void polymost_fillpolygon (int npoints);
 void polymost_setview(void);
+void polymost_flushrotatesprites(void);
 
 #endif //USE_OPENGL
 
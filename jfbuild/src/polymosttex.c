@@ -23,6 +23,8 @@ struct PTHash_typ {
 				// parameters, it creates a header and defers it to another
 				// entry that stands in its place
 	int primecnt;	// a count of how many times the texture is touched when priming
+	int loading;	// !0 while the loader is preparing the hightile in the background
+	int loadseq;	// bumped for each job queued and on unload, so only the newest job counts
 };
 typedef struct PTHash_typ PTHash;
 
@@ -58,11 +60,57 @@ struct PTTexture_typ {
 };
 typedef struct PTTexture_typ PTTexture;
 
+#define PTMAXMIPS 16
+
+/** a texture's mipmap levels, prepared and waiting to be sent to GL */
+struct PTMipChain_typ {
+	GLenum intexfmt;
+	GLenum rawfmt;
+	int compress;		// PTCOMPRESS_* format of the data
+	int hasalpha;
+	int nummips;
+	int bytes;		// total length of the mipmap data
+	int ownsdata;		// !0 if the data is freed with the chain rather than by a cache tile
+	struct {
+		GLsizei sizx, sizy;
+		int length;
+		unsigned char * data;
+	} mip[PTMAXMIPS];
+};
+typedef struct PTMipChain_typ PTMipChain;
+
+/** a hightile replacement being prepared by the loader */
+struct PTLoadJob_typ {
+	struct PTLoadJob_typ *next;
+	PTHash *pth;
+	int generation;		// ptlgeneration at the time the job was queued
+	int loadseq;		// pth->loadseq at the time the job was queued
+	int primed;		// !0 if queued by PTDoPrime
+	unsigned short flags;
+	int effects;
+	int writetocache;
+	char *filename;
+	char *picdata;		// file contents, read by the render thread
+	int picdatalen;
+
+	// the results
+	int err;
+	int sizx, sizy;		// padded size
+	int tsizx, tsizy;	// true size
+	PTCacheTile *tdef;
+	PTMipChain chain;
+};
+typedef struct PTLoadJob_typ PTLoadJob;
+
 static int primecnt   = 0;	// expected number of textures to load during priming
 static int primedone  = 0;	// running total of how many textures have been primed
 static int primepos   = 0;	// the position in pthashhead where we are up to in priming
+static PTHash * primepth = 0;	// the next entry in pthashhead[primepos] to prime
+static int primeunloaded = 0;	// !0 once the unmarked textures have been unloaded
 
 int polymosttexverbosity = 1;	// 0 = none, 1 = errors, 2 = all
+int gltexasyncload = 1;		// !0 = prepare hightile replacements in the background
+int gltexuploadbudget = 1024;	// kilobytes of loaded textures sent to GL per frame
 int polymosttexfullbright = 256;	// first index of the fullbright palette entries
 
 #define PTHASHHEADSIZ 4096
@@ -81,6 +129,9 @@ static const char *compressfourcc[] = {
 static void ptm_fixtransparency(PTTexture * tex, int clamped);
 static void ptm_applyeffects(PTTexture * tex, int effects);
 static void ptm_mipscale(PTTexture * tex);
+static int ptm_preparetexture(PTMipChain * chain, unsigned short flags, PTTexture * tex, PTCacheTile * tdef);
+static void ptm_sendtexture(PTMHead * ptm, PTMipChain * chain);
+static void ptm_freemipchain(PTMipChain * chain);
 static void ptm_uploadtexture(PTMHead * ptm, unsigned short flags, PTTexture * tex, PTCacheTile * tdef);
 
 
@@ -145,7 +196,7 @@ void PTM_InitIdent(PTMIdent *id, PTHead *pth)
 		}
 	} else {
 		id->type = PTMIDENT_ART;
-		id->flags = pth->flags & (PTH_CLAMPED);
+		id->flags = pth->flags & PTH_CLAMPED;
 		id->palnum = pth->palnum;
 		id->picnum = pth->picnum;
 	}
@@ -284,116 +335,184 @@ incompatible:
 
 
 /**
- * Loads a texture file into OpenGL
+ * Reads a texture file into memory
  * @param filename the texture filename
- * @param ptmh the PTMHead structure to receive the texture details
- * @param flags PTH_* flags to tune the load process
- * @param effects HICEFFECT_* effects to apply
- * @return 0 on success, <0 on error
+ * @param picdata receives the malloc'd file contents
+ * @param picdatalen receives the file length
+ * @return 0 on success, <0 on error (see PTM_GetLoadTextureFileErrorString)
  */
-int PTM_LoadTextureFile(const char* filename, PTMHead* ptmh, int flags, int effects)
+static int ptm_readtexturefile(const char* filename, char ** picdata, int * picdatalen)
 {
-	PTTexture tex;
-	int filh, picdatalen;
-	int y;
-	char * picdata = 0;
-	PTCacheTile * tdef = 0;
-	int writetocache = 0, iscached = 0;
-
-	if (!(flags & PTH_NOCOMPRESS) && glusetexcache && glusetexcompr) {
-		iscached = PTCacheHasTile(filename, effects, (flags & PTH_CLAMPED));
-
-		// if the texture exists in the cache but the original file is newer,
-		// ignore what's in the cache and overwrite it
-		/*if (iscached && filemtime(filename) > filemtime(cacheitem)) {
-			iscached = 0;
-		}*/
-
-		if (!iscached) {
-			writetocache = 1;
-		}
-	}
-
-	if (iscached) {
-		if (ptm_loadcachedtexturefile(filename, ptmh, flags, effects) == 0) {
-			return 0;
-		}
-	}
+	int filh;
 
 	filh = kopen4load((char *) filename, 0);
 	if (filh < 0) {
 		return -1;
 	}
-	picdatalen = kfilelength(filh);
+	*picdatalen = kfilelength(filh);
 
-	picdata = (char *) malloc(picdatalen);
-	if (!picdata) {
+	*picdata = (char *) malloc(*picdatalen);
+	if (!*picdata) {
 		kclose(filh);
 		return -2;
 	}
 
-	if (kread(filh, picdata, picdatalen) != picdatalen) {
+	if (kread(filh, *picdata, *picdatalen) != *picdatalen) {
 		kclose(filh);
+		free(*picdata);
+		*picdata = 0;
 		return -3;
 	}
 
 	kclose(filh);
 
-	kpgetdim(picdata, picdatalen, (int *) &tex.tsizx, (int *) &tex.tsizy);
-	if (tex.tsizx == 0 || tex.tsizy == 0) {
-		free(picdata);
+	return 0;
+}
+
+/**
+ * Decodes a texture file image and applies effects to it
+ * @param picdata the file contents
+ * @param picdatalen the file length
+ * @param tex the texture to receive the image
+ * @param flags PTH_* flags to tune the load process
+ * @param effects HICEFFECT_* effects to apply
+ * @param pow2 !0 to pad the image to power-of-two dimensions
+ * @return 0 on success, <0 on error (see PTM_GetLoadTextureFileErrorString)
+ *
+ * This touches no GL state, so it is safe to call from the loader worker.
+ */
+static int ptm_decodetexture(char * picdata, int picdatalen, PTTexture * tex, int flags, int effects, int pow2)
+{
+	int y, err;
+
+	kpliblock();
+	kpgetdim(picdata, picdatalen, (int *) &tex->tsizx, (int *) &tex->tsizy);
+	kplibunlock();
+	if (tex->tsizx == 0 || tex->tsizy == 0) {
 		return -4;
 	}
 
-	if (!glinfo.texnpot || writetocache) {
-		for (tex.sizx = 1; tex.sizx < tex.tsizx; tex.sizx += tex.sizx) ;
-		for (tex.sizy = 1; tex.sizy < tex.tsizy; tex.sizy += tex.sizy) ;
+	if (pow2) {
+		for (tex->sizx = 1; tex->sizx < tex->tsizx; tex->sizx += tex->sizx) ;
+		for (tex->sizy = 1; tex->sizy < tex->tsizy; tex->sizy += tex->sizy) ;
 	} else {
-		tex.sizx = tex.tsizx;
-		tex.sizy = tex.tsizy;
+		tex->sizx = tex->tsizx;
+		tex->sizy = tex->tsizy;
 	}
 
-	tex.pic = (coltype *) malloc(tex.sizx * tex.sizy * sizeof(coltype));
-	if (!tex.pic) {
+	tex->pic = (coltype *) malloc(tex->sizx * tex->sizy * sizeof(coltype));
+	if (!tex->pic) {
 		return -2;
 	}
-	memset(tex.pic, 0, tex.sizx * tex.sizy * sizeof(coltype));
+	memset(tex->pic, 0, tex->sizx * tex->sizy * sizeof(coltype));
 
-	if (kprender(picdata, picdatalen, tex.pic, tex.sizx * sizeof(coltype), tex.sizx, tex.sizy, 0, 0)) {
-		free(picdata);
-		free(tex.pic);
+	kpliblock();
+	err = kprender(picdata, picdatalen, tex->pic, tex->sizx * sizeof(coltype), tex->sizx, tex->sizy, 0, 0);
+	kplibunlock();
+	if (err) {
+		free(tex->pic);
+		tex->pic = 0;
 		return -5;
 	}
 
-	free(picdata);
-	picdata = 0;
-
-	ptm_applyeffects(&tex, effects);	// updates tex.hasalpha
-
-	ptmh->flags = 0;
-	if (tex.hasalpha) {
-		ptmh->flags |= PTH_HASALPHA;
-	}
+	ptm_applyeffects(tex, effects);	// updates tex->hasalpha
 
 	if (! (flags & PTH_CLAMPED) || (flags & PTH_SKYBOX)) { //Duplicate texture pixels (wrapping tricks for non power of 2 texture sizes)
-		if (tex.sizx > tex.tsizx) {	//Copy left to right
-			coltype * lptr = tex.pic;
-			for (y = 0; y < tex.tsizy; y++, lptr += tex.sizx) {
-				memcpy(&lptr[tex.tsizx], lptr, (tex.sizx - tex.tsizx) << 2);
+		if (tex->sizx > tex->tsizx) {	//Copy left to right
+			coltype * lptr = tex->pic;
+			for (y = 0; y < tex->tsizy; y++, lptr += tex->sizx) {
+				memcpy(&lptr[tex->tsizx], lptr, (tex->sizx - tex->tsizx) << 2);
 			}
 		}
-		if (tex.sizy > tex.tsizy) {	//Copy top to bottom
-			memcpy(&tex.pic[tex.sizx * tex.tsizy], tex.pic, (tex.sizy - tex.tsizy) * tex.sizx << 2);
+		if (tex->sizy > tex->tsizy) {	//Copy top to bottom
+			memcpy(&tex->pic[tex->sizx * tex->tsizy], tex->pic, (tex->sizy - tex->tsizy) * tex->sizx << 2);
 		}
 	}
 
-	tex.rawfmt = GL_BGRA;
+	tex->rawfmt = GL_BGRA;
 	if (!glinfo.bgra) {
 		int j;
-		for (j = tex.sizx * tex.sizy - 1; j >= 0; j--) {
-			swapchar(&tex.pic[j].r, &tex.pic[j].b);
+		for (j = tex->sizx * tex->sizy - 1; j >= 0; j--) {
+			swapchar(&tex->pic[j].r, &tex->pic[j].b);
+		}
+		tex->rawfmt = GL_RGBA;
+	}
+
+	return 0;
+}
+
+/**
+ * Allocates a polymosttexcache definition to receive a texture's compressed mipmaps
+ * @param filename the texture filename
+ * @param tex the decoded texture
+ * @param flags PTH_* flags the texture was loaded with
+ * @param effects HICEFFECT_* effects applied
+ * @return the new definition
+ */
+static PTCacheTile * ptm_newcachetile(const char * filename, PTTexture * tex, int flags, int effects)
+{
+	PTCacheTile * tdef;
+	int nmips = 0;
+
+	while (max(1, (tex->sizx >> nmips)) > 1 ||
+		   max(1, (tex->sizy >> nmips)) > 1) {
+		nmips++;
+	}
+	nmips++;
+
+	tdef = PTCacheAllocNewTile(nmips);
+	tdef->filename = strdup(filename);
+	tdef->effects = effects;
+	tdef->flags = (flags | (tex->hasalpha ? PTH_HASALPHA : 0)) & (PTH_CLAMPED | PTH_HASALPHA);
+
+	return tdef;
+}
+
+/**
+ * Loads a texture file into OpenGL
+ * @param filename the texture filename
+ * @param ptmh the PTMHead structure to receive the texture details
+ * @param flags PTH_* flags to tune the load process
+ * @param effects HICEFFECT_* effects to apply
+ * @return 0 on success, <0 on error
+ */
+int PTM_LoadTextureFile(const char* filename, PTMHead* ptmh, int flags, int effects)
+{
+	PTTexture tex;
+	int picdatalen, err;
+	char * picdata = 0;
+	PTCacheTile * tdef = 0;
+	int writetocache = 0, iscached = 0;
+
+	if (!(flags & PTH_NOCOMPRESS) && glusetexcache && glusetexcompr) {
+		iscached = PTCacheHasTile(filename, effects, (flags & PTH_CLAMPED));
+
+		// if the texture exists in the cache but the original file is newer,
+		// ignore what's in the cache and overwrite it
+		/*if (iscached && filemtime(filename) > filemtime(cacheitem)) {
+			iscached = 0;
+		}*/
+
+		if (!iscached) {
+			writetocache = 1;
+		}
+	}
+
+	if (iscached) {
+		if (ptm_loadcachedtexturefile(filename, ptmh, flags, effects) == 0) {
+			return 0;
 		}
-		tex.rawfmt = GL_RGBA;
+	}
+
+	if ((err = ptm_readtexturefile(filename, &picdata, &picdatalen))) {
+		return err;
+	}
+
+	err = ptm_decodetexture(picdata, picdatalen, &tex, flags, effects,
+			!glinfo.texnpot || writetocache);
+	free(picdata);
+	if (err) {
+		return err;
 	}
 
 	ptmh->tsizx = tex.tsizx;
@@ -402,17 +521,7 @@ int PTM_LoadTextureFile(const char* filename, PTMHead* ptmh, int flags, int effe
 	ptmh->sizy  = tex.sizy;
 
 	if (writetocache) {
-		int nmips = 0;
-		while (max(1, (tex.sizx >> nmips)) > 1 ||
-			   max(1, (tex.sizy >> nmips)) > 1) {
-			nmips++;
-		}
-		nmips++;
-
-		tdef = PTCacheAllocNewTile(nmips);
-		tdef->filename = strdup(filename);
-		tdef->effects = effects;
-		tdef->flags = (flags | ptmh->flags) & (PTH_CLAMPED | PTH_HASALPHA);
+		tdef = ptm_newcachetile(filename, &tex, flags, effects);
 	}
 
 	ptm_uploadtexture(ptmh, flags, &tex, tdef);
@@ -427,11 +536,7 @@ int PTM_LoadTextureFile(const char* filename, PTMHead* ptmh, int flags, int effe
 		tdef = 0;
 	}
 
-
-	if (tex.pic) {
-		free(tex.pic);
-		tex.pic = 0;
-	}
+	free(tex.pic);
 
 	return 0;
 }
@@ -466,7 +571,8 @@ const char * PTM_GetLoadTextureFileErrorString(int err)
  * Finds the pthash entry for a tile, possibly creating it if one doesn't exist
  * @param picnum tile number
  * @param palnum palette number
- * @param flags PTH_HIGHTILE = try for hightile, PTH_CLAMPED
+ * @param flags PTH_HIGHTILE = try for hightile, PTH_CLAMPED, PTH_ATLAS = drawn
+ *              by rotatesprite (a hint, not part of the tile's identity)
  * @param create !0 = create if none found
  * @return the PTHash item, or null if none was found
  */
@@ -487,6 +593,9 @@ static PTHash * pt_findhash(int picnum, int palnum, unsigned short flags, int cr
 			while (pth->deferto) {
 				pth = pth->deferto;	// find the end of the chain
 			}
+			// once drawn by rotatesprite, the tile goes into an atlas
+			// the next time it loads
+			pth->head.flags |= (flags & PTH_ATLAS);
 			return pth;
 		}
 
@@ -512,7 +621,7 @@ static PTHash * pt_findhash(int picnum, int palnum, unsigned short flags, int cr
 		pth->next = pthashhead[i];
 		pth->head.picnum  = picnum;
 		pth->head.palnum  = palnum;
-		pth->head.flags   = flagmask;
+		pth->head.flags   = flagmask | (flags & PTH_ATLAS);
 		pth->head.repldef = replc;
 
 		pthashhead[i] = pth;
@@ -555,9 +664,16 @@ static PTHash * pt_findhash(int picnum, int palnum, unsigned short flags, int cr
 static void pt_unload(PTHash * pth)
 {
 	int i;
+
+	pth->loading = 0;	// orphans any job the loader holds for it
+	pth->loadseq++;
 	for (i = PTHPIC_SIZE - 1; i>=0; i--) {
 		if (pth->head.pic[i] && pth->head.pic[i]->glpic) {
-			glfunc.glDeleteTextures(1, &pth->head.pic[i]->glpic);
+			if (!(pth->head.pic[i]->flags & PTH_ATLAS)) {
+				glfunc.glDeleteTextures(1, &pth->head.pic[i]->glpic);
+			}
+			// an atlas tile keeps its slot for when it reloads; the
+			// atlases themselves are released by pt_atlas_reset
 			pth->head.pic[i]->glpic = 0;
 		}
 	}
@@ -566,6 +682,7 @@ static void pt_unload(PTHash * pth)
 static int pt_load_art(PTHead * pth);
 static int pt_load_hightile(PTHead * pth);
 static void pt_load_applyparameters(PTHead * pth);
+static int ptl_queue(PTHash * pth);
 
 /**
  * Loads a texture into memory from disk
@@ -579,8 +696,16 @@ static int pt_load(PTHash * pth)
 		(pth->head.pic[PTHPIC_BASE]->flags & PTH_DIRTY) == 0) {
 		return 1;	// loaded
 	}
+	if (pth->loading) {
+		return 1;	// PT_GetHead stands in the ART tile in the meantime
+	}
 
 	if ((pth->head.flags & PTH_HIGHTILE)) {
+		// try and have the loader prepare the replacement
+		if (ptl_queue(pth)) {
+			return 1;
+		}
+
 		// try and load from a replacement
 		if (pt_load_hightile(&pth->head)) {
 			return 1;
@@ -607,6 +732,262 @@ static int pt_load(PTHash * pth)
 }
 
 
+/**
+ * The ART tile atlases
+ *
+ * Small tiles drawn by rotatesprite (HUD digits, fonts, the status bar and
+ * small sprites) are packed onto the shelves of a few large textures, one
+ * set for each palette, so that drawing the HUD binds a handful of textures
+ * rather than one per tile. Each tile is surrounded by a one pixel gutter
+ * of its own edge pixels so bilinear filtering never samples a neighbour.
+ * Atlas tiles have no mipmaps. Once the atlases are full, tiles fall back
+ * to textures of their own.
+ */
+
+#define PTATLASSIZE 512		// width and height of each atlas; 1MB apiece
+#define PTATLASMAXTILE 128	// largest tile dimension packed into an atlas
+#define PTATLASMAX 8		// most atlases held at once
+#define PTATLASMAXSHELVES 64
+
+struct PTAtlas_typ {
+	GLuint glpic;
+	int palnum;
+	int numshelves;
+	int freey;		// top of the space below the last shelf
+	struct {
+		short y, sizy;
+		short freex;	// left of the space at the end of the shelf
+	} shelf[PTATLASMAXSHELVES];
+};
+typedef struct PTAtlas_typ PTAtlas;
+
+static PTAtlas ptatlas[PTATLASMAX];
+static int ptnumatlases = 0;
+
+/**
+ * Applies the filter parameters to an atlas texture, which has no mipmaps
+ * @param atlas the atlas
+ */
+static void pt_atlas_applyparameters(PTAtlas * atlas)
+{
+	GLint c = glinfo.clamptoedge ? GL_CLAMP_TO_EDGE : GL_CLAMP;
+
+	if (gltexfiltermode < 0) {
+		gltexfiltermode = 0;
+	} else if (gltexfiltermode >= (int)numglfiltermodes) {
+		gltexfiltermode = numglfiltermodes-1;
+	}
+
+	glfunc.glBindTexture(GL_TEXTURE_2D, atlas->glpic);
+	glfunc.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, glfiltermodes[gltexfiltermode].mag);
+	glfunc.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, glfiltermodes[gltexfiltermode].mag);
+	glfunc.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, c);
+	glfunc.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, c);
+}
+
+/**
+ * Finds space in an atlas for a rectangle
+ * @param palnum the palette of the tile
+ * @param sizx width of the rectangle, gutter included
+ * @param sizy height of the rectangle, gutter included
+ * @param x receives the left of the space
+ * @param y receives the top of the space
+ * @return the atlas, or null if they are all full
+ */
+static PTAtlas * pt_atlas_alloc(int palnum, int sizx, int sizy, int * x, int * y)
+{
+	PTAtlas * atlas;
+	int i, j, best, shelfy;
+
+	// shelves are opened a little taller than the tile that opens them
+	// so the next few tiles of a similar height can share
+	shelfy = (sizy + 3) & ~3;
+
+	for (i = 0; i < ptnumatlases; i++) {
+		atlas = &ptatlas[i];
+		if (atlas->palnum != palnum) {
+			continue;
+		}
+
+		// the shortest shelf the rectangle fits on
+		best = -1;
+		for (j = 0; j < atlas->numshelves; j++) {
+			if (atlas->shelf[j].sizy < sizy ||
+			    atlas->shelf[j].freex + sizx > PTATLASSIZE) {
+				continue;
+			}
+			if (best < 0 || atlas->shelf[j].sizy < atlas->shelf[best].sizy) {
+				best = j;
+			}
+		}
+		if (best >= 0 && atlas->shelf[best].sizy <= sizy + sizy / 2) {
+			*x = atlas->shelf[best].freex;
+			*y = atlas->shelf[best].y;
+			atlas->shelf[best].freex += sizx;
+			return atlas;
+		}
+
+		// or a new shelf, failing that a shelf much taller than needed
+		if (atlas->numshelves < PTATLASMAXSHELVES &&
+		    atlas->freey + shelfy <= PTATLASSIZE) {
+			j = atlas->numshelves++;
+			atlas->shelf[j].y = atlas->freey;
+			atlas->shelf[j].sizy = shelfy;
+			atlas->shelf[j].freex = sizx;
+			atlas->freey += shelfy;
+			*x = 0;
+			*y = atlas->shelf[j].y;
+			return atlas;
+		}
+		if (best >= 0) {
+			*x = atlas->shelf[best].freex;
+			*y = atlas->shelf[best].y;
+			atlas->shelf[best].freex += sizx;
+			return atlas;
+		}
+	}
+
+	if (ptnumatlases >= PTATLASMAX) {
+		return 0;
+	}
+
+	atlas = &ptatlas[ptnumatlases];
+	memset(atlas, 0, sizeof(PTAtlas));
+	glfunc.glGenTextures(1, &atlas->glpic);
+	if (!atlas->glpic) {
+		return 0;
+	}
+	ptnumatlases++;
+
+	atlas->palnum = palnum;
+	pt_atlas_applyparameters(atlas);
+	glfunc.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, PTATLASSIZE, PTATLASSIZE, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, (const GLvoid *) 0);
+
+	atlas->numshelves = 1;
+	atlas->shelf[0].y = 0;
+	atlas->shelf[0].sizy = shelfy;
+	atlas->shelf[0].freex = sizx;
+	atlas->freey = shelfy;
+	*x = 0;
+	*y = 0;
+	return atlas;
+}
+
+/**
+ * Places a loaded ART tile into an atlas, or rewrites it in the place
+ * it already holds
+ * @param ptm the texture management header for the tile
+ * @param palnum the palette of the tile
+ * @param tex the tile's pixels
+ * @return !0 on success, 0 if the tile should have its own texture
+ */
+static int pt_atlas_place(PTMHead * ptm, int palnum, PTTexture * tex)
+{
+	PTAtlas * atlas = 0;
+	PTTexture gutter;
+	coltype * src, * dst;
+	int x, y, i;
+
+	if (tex->tsizx < 1 || tex->tsizy < 1 ||
+	    tex->tsizx > PTATLASMAXTILE || tex->tsizy > PTATLASMAXTILE) {
+		return 0;
+	}
+
+	if ((ptm->flags & PTH_ATLAS) && ptm->atlas > 0 && ptm->atlas <= ptnumatlases &&
+	    ptatlas[ptm->atlas - 1].palnum == palnum &&
+	    ptm->tsizx == tex->tsizx && ptm->tsizy == tex->tsizy) {
+		// a reload of a tile that already has a slot in an atlas
+		atlas = &ptatlas[ptm->atlas - 1];
+		x = ptm->atlasx - 1;
+		y = ptm->atlasy - 1;
+	}
+	if (!atlas) {
+		atlas = pt_atlas_alloc(palnum, tex->tsizx + 2, tex->tsizy + 2, &x, &y);
+		if (!atlas) {
+			return 0;
+		}
+	}
+
+	gutter.sizx = gutter.tsizx = tex->tsizx + 2;
+	gutter.sizy = gutter.tsizy = tex->tsizy + 2;
+	gutter.rawfmt = tex->rawfmt;
+	gutter.hasalpha = tex->hasalpha;
+	gutter.pic = (coltype *) malloc(gutter.sizx * gutter.sizy * sizeof(coltype));
+	if (!gutter.pic) {
+		return 0;
+	}
+
+	for (i = 0; i < gutter.sizy; i++) {
+		src = &tex->pic[min(max(i - 1, 0), tex->tsizy - 1) * tex->sizx];
+		dst = &gutter.pic[i * gutter.sizx];
+		dst[0] = src[0];
+		memcpy(&dst[1], src, tex->tsizx * sizeof(coltype));
+		dst[gutter.sizx - 1] = src[tex->tsizx - 1];
+	}
+	if (gutter.hasalpha) {
+		ptm_fixtransparency(&gutter, 1);
+	}
+
+	glfunc.glBindTexture(GL_TEXTURE_2D, atlas->glpic);
+	glfunc.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, gutter.sizx, gutter.sizy,
+		gutter.rawfmt, GL_UNSIGNED_BYTE, (const GLvoid *) gutter.pic);
+	free(gutter.pic);
+
+	ptm->glpic  = atlas->glpic;
+	ptm->flags  = PTH_ATLAS | (tex->hasalpha ? PTH_HASALPHA : 0);
+	ptm->sizx   = PTATLASSIZE;
+	ptm->sizy   = PTATLASSIZE;
+	ptm->tsizx  = tex->tsizx;
+	ptm->tsizy  = tex->tsizy;
+	ptm->atlas  = (int)(atlas - ptatlas) + 1;
+	ptm->atlasx = x + 1;
+	ptm->atlasy = y + 1;
+
+	return 1;
+}
+
+/**
+ * Releases the atlases. The tiles in them must already have been unloaded.
+ */
+static void pt_atlas_reset(void)
+{
+	PTMHash * ptmh;
+	int i;
+
+	// the tiles' slots go with the atlases
+	for (i = 0; i < PTMHASHHEADSIZ; i++) {
+		for (ptmh = ptmhashhead[i]; ptmh; ptmh = ptmh->next) {
+			if (ptmh->head.flags & PTH_ATLAS) {
+				ptmh->head.flags &= ~PTH_ATLAS;
+				ptmh->head.atlas = 0;
+				ptmh->head.atlasx = ptmh->head.atlasy = 0;
+			}
+		}
+	}
+
+	for (i = 0; i < ptnumatlases; i++) {
+		if (ptatlas[i].glpic) {
+			glfunc.glDeleteTextures(1, &ptatlas[i].glpic);
+		}
+	}
+	memset(ptatlas, 0, sizeof(ptatlas));
+	ptnumatlases = 0;
+}
+
+/**
+ * Applies the global texture filter parameters to the atlases
+ */
+void PTAtlasApplyParameters(void)
+{
+	int i;
+
+	for (i = 0; i < ptnumatlases; i++) {
+		pt_atlas_applyparameters(&ptatlas[i]);
+	}
+}
+
+
 /**
  * Load an ART tile into an OpenGL texture
  * @param pth the header to populate
@@ -718,6 +1099,20 @@ static int pt_load_art(PTHead * pth)
     PTM_InitIdent(&id, pth);
     id.layer = PTHPIC_BASE;
 	pth->pic[PTHPIC_BASE] = PTM_GetHead(&id);
+
+	if ((pth->flags & PTH_ATLAS) && (pth->flags & PTH_CLAMPED) &&
+	    waloff[pth->picnum] && !hasfullbright &&
+	    pt_atlas_place(pth->pic[PTHPIC_BASE], pth->palnum, &tex)) {
+		pth->pic[PTHPIC_GLOW] = 0;
+		free(tex.pic);
+		free(fbtex.pic);
+		return 1;
+	}
+	if (pth->pic[PTHPIC_BASE]->flags & PTH_ATLAS) {
+		// the tile has outgrown its place in the atlas, so
+		// it must not write over the atlas texture
+		pth->pic[PTHPIC_BASE]->glpic = 0;
+	}
 	pth->pic[PTHPIC_BASE]->tsizx = tex.tsizx;
 	pth->pic[PTHPIC_BASE]->tsizy = tex.tsizy;
 	pth->pic[PTHPIC_BASE]->sizx  = tex.sizx;
@@ -1105,22 +1500,25 @@ static void ptm_mipscale(PTTexture * tex)
 
 
 /**
- * Sends texture data to GL
- * @param ptm the texture management header
- * @param flags extra flags to modify how the texture is uploaded
- * @param tex the texture to upload
+ * Builds the mipmap chain for a texture, compressing it if appropriate
+ * @param chain the chain to receive the mipmaps
+ * @param flags extra flags to modify how the texture is prepared
+ * @param tex the texture to process. Its image is scaled down in place
  * @param tdef the polymosttexcache definition to receive compressed mipmaps, or null
+ * @return 0 on success, -2 if out of memory
+ *
+ * This touches no GL state, so it is safe to call from the loader worker.
  */
-static void ptm_uploadtexture(PTMHead * ptm, unsigned short flags, PTTexture * tex, PTCacheTile * tdef)
+static int ptm_preparetexture(PTMipChain * chain, unsigned short flags, PTTexture * tex, PTCacheTile * tdef)
 {
 	GLint mipmap;
 	GLint intexfmt;
 	int compress = PTCOMPRESS_NONE;
-	unsigned char * comprdata = 0;
-	int tdefmip = 0, comprsize = 0;
+	unsigned char * data;
+	int tdefmip = 0, length, last, send;
 	int starttime;
 
-	detect_texture_size();
+	memset(chain, 0, sizeof(PTMipChain));
 
 #if USE_OPENGL == USE_GLES2
 	// GLES permits BGRA as an internal format.
@@ -1149,16 +1547,19 @@ static void ptm_uploadtexture(PTMHead * ptm, unsigned short flags, PTTexture * t
 #endif
 	}
 
-	if (compress && tdef) {
+	if (!compress) {
+		tdef = 0;
+	} else if (tdef) {
 		tdef->format = intexfmt;
 		tdef->tsizx  = tex->tsizx;
 		tdef->tsizy  = tex->tsizy;
 	}
 
-	if (ptm->glpic == 0) {
-		glfunc.glGenTextures(1, &ptm->glpic);
-	}
-	glfunc.glBindTexture(GL_TEXTURE_2D, ptm->glpic);
+	chain->intexfmt = intexfmt;
+	chain->rawfmt   = tex->rawfmt;
+	chain->compress = compress;
+	chain->hasalpha = tex->hasalpha;
+	chain->ownsdata = (tdef == 0);	// otherwise the tdef holds the mipmap data
 
 	ptm_fixtransparency(tex, (flags & PTH_CLAMPED));
 
@@ -1175,117 +1576,544 @@ static void ptm_uploadtexture(PTMHead * ptm, unsigned short flags, PTTexture * t
 		mipmap++;
 	}
 
-	for ( ;
-	     mipmap > 0 && (tex->sizx > 1 || tex->sizy > 1);
-	     mipmap--) {
-		if (compress && tdef) {
-			comprsize = ptcompress_getstorage(tex->sizx, tex->sizy, compress);
-			comprdata = (unsigned char *) malloc(comprsize);
+	for (;;) {
+		last = (tex->sizx <= 1 && tex->sizy <= 1);
+		send = (mipmap == 0 || last) && chain->nummips < PTMAXMIPS;
 
-			starttime = getticks();
-			ptcompress_compress(tex->pic, tex->sizx, tex->sizy, comprdata, compress);
-			if (polymosttexverbosity >= 2) {
-				buildprintf("PolymostTex: ptcompress_compress (%dx%d, %s) took %f sec\n",
-					   tex->sizx, tex->sizy, compressfourcc[compress],
-					   (float)(getticks() - starttime) / 1000.f);
+		if (send) {
+			// a level that GL will receive
+			if (compress) {
+				length = ptcompress_getstorage(tex->sizx, tex->sizy, compress);
+			} else {
+				length = tex->sizx * tex->sizy * sizeof(coltype);
 			}
+		} else if (tdef) {
+			// a discarded level that the cache still wants
+			length = ptcompress_getstorage(tex->sizx, tex->sizy, compress);
+		} else {
+			length = -1;
+		}
 
-			tdef->mipmap[tdefmip].sizx = tex->sizx;
-			tdef->mipmap[tdefmip].sizy = tex->sizy;
-			tdef->mipmap[tdefmip].length = comprsize;
-			tdef->mipmap[tdefmip].data = comprdata;
-			tdefmip++;
+		if (length >= 0) {
+			data = (unsigned char *) malloc(max(1, length));
+			if (!data) {
+				ptm_freemipchain(chain);
+				return -2;
+			}
 
-			comprdata = 0;
+			if (compress) {
+				starttime = getticks();
+				ptcompress_compress(tex->pic, tex->sizx, tex->sizy, data, compress, tex->rawfmt == GL_RGBA);
+				if (polymosttexverbosity >= 2) {
+					buildprintf("PolymostTex: ptcompress_compress (%dx%d, %s) took %f sec\n",
+						   tex->sizx, tex->sizy, compressfourcc[compress],
+						   (float)(getticks() - starttime) / 1000.f);
+				}
+			} else {
+				memcpy(data, tex->pic, length);
+			}
+
+			if (tdef) {
+				tdef->mipmap[tdefmip].sizx = tex->sizx;
+				tdef->mipmap[tdefmip].sizy = tex->sizy;
+				tdef->mipmap[tdefmip].length = length;
+				tdef->mipmap[tdefmip].data = data;
+				tdefmip++;
+			}
+			if (send) {
+				chain->mip[chain->nummips].sizx = tex->sizx;
+				chain->mip[chain->nummips].sizy = tex->sizy;
+				chain->mip[chain->nummips].length = length;
+				chain->mip[chain->nummips].data = data;
+				chain->nummips++;
+				chain->bytes += length;
+			}
+		}
+
+		if (last) {
+			break;
 		}
 
 		ptm_mipscale(tex);
 		ptm_fixtransparency(tex, (flags & PTH_CLAMPED));
+		if (mipmap > 0) {
+			mipmap--;
+		}
 	}
 
-	if (compress) {
-		comprsize = ptcompress_getstorage(tex->sizx, tex->sizy, compress);
-		comprdata = (unsigned char *) malloc(comprsize);
+	return 0;
+}
 
-		starttime = getticks();
-		ptcompress_compress(tex->pic, tex->sizx, tex->sizy, comprdata, compress);
-		if (polymosttexverbosity >= 2) {
-			buildprintf("PolymostTex: ptcompress_compress (%dx%d, %s) took %f sec\n",
-				   tex->sizx, tex->sizy, compressfourcc[compress],
-				   (float)(getticks() - starttime) / 1000.f);
+/**
+ * Sends a prepared mipmap chain to GL
+ * @param ptm the texture management header
+ * @param chain the mipmap chain
+ */
+static void ptm_sendtexture(PTMHead * ptm, PTMipChain * chain)
+{
+	int i;
+
+	if (ptm->glpic == 0) {
+		glfunc.glGenTextures(1, &ptm->glpic);
+	}
+	glfunc.glBindTexture(GL_TEXTURE_2D, ptm->glpic);
+
+	for (i = 0; i < chain->nummips; i++) {
+		if (chain->compress) {
+			glfunc.glCompressedTexImage2D(GL_TEXTURE_2D, i,
+				chain->intexfmt, chain->mip[i].sizx, chain->mip[i].sizy, 0,
+				chain->mip[i].length, (const GLvoid *) chain->mip[i].data);
+		} else {
+			glfunc.glTexImage2D(GL_TEXTURE_2D, i,
+				chain->intexfmt, chain->mip[i].sizx, chain->mip[i].sizy, 0,
+				chain->rawfmt, GL_UNSIGNED_BYTE, (const GLvoid *) chain->mip[i].data);
 		}
+	}
+
+	ptm->flags = 0;
+	ptm->flags |= (chain->hasalpha ? PTH_HASALPHA : 0);
+}
+
+/**
+ * Releases the mipmap data held by a chain
+ * @param chain the mipmap chain
+ */
+static void ptm_freemipchain(PTMipChain * chain)
+{
+	int i;
 
-		if (tdef) {
-			tdef->mipmap[tdefmip].sizx = tex->sizx;
-			tdef->mipmap[tdefmip].sizy = tex->sizy;
-			tdef->mipmap[tdefmip].length = comprsize;
-			tdef->mipmap[tdefmip].data = comprdata;
-			tdefmip++;
+	if (chain->ownsdata) {
+		for (i = 0; i < chain->nummips; i++) {
+			free(chain->mip[i].data);
 		}
+	}
+	chain->nummips = 0;
+}
+
+/**
+ * Sends texture data to GL
+ * @param ptm the texture management header
+ * @param flags extra flags to modify how the texture is uploaded
+ * @param tex the texture to upload
+ * @param tdef the polymosttexcache definition to receive compressed mipmaps, or null
+ */
+static void ptm_uploadtexture(PTMHead * ptm, unsigned short flags, PTTexture * tex, PTCacheTile * tdef)
+{
+	PTMipChain chain;
+
+	detect_texture_size();
+
+	if (ptm_preparetexture(&chain, flags, tex, tdef) == 0) {
+		ptm_sendtexture(ptm, &chain);
+		ptm_freemipchain(&chain);
+	}
+}
+
+
+/**
+ * The hightile loader
+ *
+ * Hightile replacements that aren't in the texture cache are read by the
+ * render thread, then handed to a low priority worker which decodes them,
+ * applies effects and builds their mipmaps. The render thread sends the
+ * finished textures to GL from PTServiceLoader() under a per-frame budget,
+ * and PT_GetHead() returns the ART tile in place of a replacement still in
+ * preparation. In play there is one worker. While priming there is one for
+ * each spare processor, and the render thread takes jobs from the queue too
+ * between uploads. Decoding is serialised by the kplib lock, but effects and
+ * mipmapping run in parallel.
+ */
+
+#define PTLOADMAXJOBS 16	// most replacements held by the loader at once
+#define PTLOADMAXWORKERS 8
+
+static void *ptlmutex = 0;
+static struct {
+	void *thread;
+	volatile int done;
+} ptlworkers[PTLOADMAXWORKERS];
+static volatile int ptlworkercancel = 0;
+static PTLoadJob *ptlqueue = 0, *ptlqueuetail = 0;	// waiting for the worker
+static PTLoadJob *ptldone = 0, *ptldonetail = 0;	// waiting for upload
+static int ptlnumjobs = 0;	// jobs in either list or in the worker's hands
+static int ptlgeneration = 0;	// bumped by PTReset to orphan jobs in flight
+static int ptlpriming = 0;	// !0 while PTDoPrime is feeding the loader
+
+static void ptl_freejob(PTLoadJob * job)
+{
+	ptm_freemipchain(&job->chain);
+	if (job->tdef) {
+		PTCacheFreeTile(job->tdef);
+	}
+	free(job->picdata);
+	free(job->filename);
+	free(job);
+}
+
+/**
+ * Decodes a queued replacement and builds its mipmaps
+ * @param job the job
+ */
+static void ptl_preparejob(PTLoadJob * job)
+{
+	PTTexture tex;
 
-		glfunc.glCompressedTexImage2D(GL_TEXTURE_2D, 0,
-			intexfmt, tex->sizx, tex->sizy, 0,
-			comprsize, (const GLvoid *) comprdata);
+	job->err = ptm_decodetexture(job->picdata, job->picdatalen, &tex,
+			job->flags, job->effects, !glinfo.texnpot || job->writetocache);
+	free(job->picdata);
+	job->picdata = 0;
+	if (job->err) {
+		return;
+	}
+
+	job->tsizx = tex.tsizx;
+	job->tsizy = tex.tsizy;
+	job->sizx  = tex.sizx;
+	job->sizy  = tex.sizy;
+
+	if (job->writetocache) {
+		job->tdef = ptm_newcachetile(job->filename, &tex, job->flags, job->effects);
+	}
+	job->err = ptm_preparetexture(&job->chain, job->flags, &tex, job->tdef);
 
-		if (tdef) {
-			// we need to retain each mipmap for the tdef struct, so
-			// force each mipmap to be allocated afresh in the loop below
-			comprdata = 0;
+	free(tex.pic);
+}
+
+/**
+ * Takes the job at the head of the queue. Call with ptlmutex held.
+ * @return the job, or null if the queue is empty
+ */
+static PTLoadJob * ptl_takejob(void)
+{
+	PTLoadJob * job = ptlqueue;
+
+	if (job) {
+		ptlqueue = job->next;
+		if (!ptlqueue) {
+			ptlqueuetail = 0;
 		}
+	}
+	return job;
+}
+
+/**
+ * Prepares a job taken from the queue and passes it on for upload
+ * @param job the job
+ */
+static void ptl_runjob(PTLoadJob * job)
+{
+	ptl_preparejob(job);
+
+	bmutex_lock(ptlmutex);
+	job->next = 0;
+	if (ptldonetail) {
+		ptldonetail->next = job;
 	} else {
-		glfunc.glTexImage2D(GL_TEXTURE_2D, 0,
-			intexfmt, tex->sizx, tex->sizy, 0, tex->rawfmt,
-			GL_UNSIGNED_BYTE, (const GLvoid *) tex->pic);
+		ptldone = job;
 	}
+	ptldonetail = job;
+	bmutex_unlock(ptlmutex);
+}
 
-	for (mipmap = 1; tex->sizx > 1 || tex->sizy > 1; mipmap++) {
-		ptm_mipscale(tex);
-		ptm_fixtransparency(tex, (flags & PTH_CLAMPED));
+static int ptl_workerthread(void *arg)
+{
+	volatile int * done = (volatile int *) arg;
+	PTLoadJob * job;
 
-		if (compress) {
-			comprsize = ptcompress_getstorage(tex->sizx, tex->sizy, compress);
-			if (tdef) {
-				comprdata = (unsigned char *) malloc(comprsize);
-			}
+	while (1) {
+		bmutex_lock(ptlmutex);
+		job = ptlworkercancel ? 0 : ptl_takejob();
+		if (!job) {
+			*done = 1;
+			bmutex_unlock(ptlmutex);
+			return 0;
+		}
+		bmutex_unlock(ptlmutex);
 
-			starttime = getticks();
-			ptcompress_compress(tex->pic, tex->sizx, tex->sizy, comprdata, compress);
-			if (polymosttexverbosity >= 2) {
-				buildprintf("PolymostTex: ptcompress_compress (%dx%d, %s) took %f sec\n",
-					   tex->sizx, tex->sizy, compressfourcc[compress],
-					   (float)(getticks() - starttime) / 1000.f);
-			}
+		ptl_runjob(job);
+	}
+}
 
-			if (tdef) {
-				tdef->mipmap[tdefmip].sizx = tex->sizx;
-				tdef->mipmap[tdefmip].sizy = tex->sizy;
-				tdef->mipmap[tdefmip].length = comprsize;
-				tdef->mipmap[tdefmip].data = comprdata;
-				tdefmip++;
-			}
+/**
+ * Prepares one job from the queue on the calling thread
+ * @return 0 if the queue was empty
+ */
+static int ptl_helpout(void)
+{
+	PTLoadJob * job;
 
-			glfunc.glCompressedTexImage2D(GL_TEXTURE_2D, mipmap,
-						intexfmt, tex->sizx, tex->sizy, 0,
-						comprsize, (const GLvoid *) comprdata);
+	if (!ptlmutex) {
+		return 0;
+	}
 
-			if (tdef) {
-				// we need to retain each mipmap for the tdef struct, so
-				// force each mipmap to be allocated afresh in this loop
-				comprdata = 0;
-			}
-		} else {
-			glfunc.glTexImage2D(GL_TEXTURE_2D, mipmap,
-				intexfmt, tex->sizx, tex->sizy, 0, tex->rawfmt,
-				GL_UNSIGNED_BYTE, (const GLvoid *) tex->pic);
+	bmutex_lock(ptlmutex);
+	job = ptl_takejob();
+	bmutex_unlock(ptlmutex);
+
+	if (!job) {
+		return 0;
+	}
+	ptl_runjob(job);
+	return 1;
+}
+
+/**
+ * Makes sure the wanted number of workers is running
+ * @param want the number of workers
+ */
+static void ptl_startworkers(int want)
+{
+	int i, running;
+
+	want = min(want, PTLOADMAXWORKERS);
+	for (i = 0; i < want; i++) {
+		bmutex_lock(ptlmutex);
+		running = (ptlworkers[i].thread && !ptlworkers[i].done);
+		bmutex_unlock(ptlmutex);
+		if (running) {
+			continue;
+		}
+
+		if (ptlworkers[i].thread) {
+			bthread_wait(ptlworkers[i].thread);
+		}
+		ptlworkers[i].done = 0;
+		ptlworkers[i].thread = bthread_create(ptl_workerthread, (void *) &ptlworkers[i].done, 1);
+		if (!ptlworkers[i].thread) {
+			ptlworkers[i].done = 1;
+			break;
 		}
 	}
 
-	ptm->flags = 0;
-	ptm->flags |= (tex->hasalpha ? PTH_HASALPHA : 0);
+	if (i == 0 && want > 0) {
+		// no threads, so do the work here
+		while (ptl_helpout()) ;
+	}
+}
 
-	if (comprdata) {
-		free(comprdata);
+/**
+ * Hands a hightile replacement to the loader
+ * @param pth the hash entry of the replacement
+ * @return !0 if the loader has taken charge of the replacement, or 0 if
+ *   it should be loaded immediately
+ */
+static int ptl_queue(PTHash * pth)
+{
+	PTLoadJob * job;
+	PTHead * head = &pth->head;
+	unsigned short flags;
+	int effects, writetocache = 0;
+
+	if (!(gltexasyncload || ptlpriming) || (head->flags & PTH_SKYBOX)) {
+		return 0;
+	}
+	if (!head->repldef || head->repldef->ignore || !head->repldef->filename) {
+		return 0;
+	}
+
+	effects = (head->palnum != head->repldef->palnum) ? hictinting[head->palnum].f : 0;
+	flags = head->flags & ~(PTH_NOCOMPRESS | PTH_HASALPHA);
+	if (head->repldef->flags & HIC_NOCOMPRESS) {
+		flags |= PTH_NOCOMPRESS;
+	}
+
+	if (!(flags & PTH_NOCOMPRESS) && glusetexcache && glusetexcompr) {
+		if (PTCacheHasTile(head->repldef->filename, effects, (flags & PTH_CLAMPED))) {
+			// already compressed, so quick enough to load directly
+			return 0;
+		}
+		writetocache = 1;
+	}
+
+	if (!ptlmutex) {
+		if (!kplibinitlock()) {
+			return 0;
+		}
+		ptlmutex = bmutex_create();
+		if (!ptlmutex) {
+			return 0;
+		}
+	}
+	if (ptlnumjobs >= PTLOADMAXJOBS) {
+		// try again once the loader has caught up
+		return 1;
+	}
+
+	job = (PTLoadJob *) malloc(sizeof(PTLoadJob));
+	if (!job) {
+		return 0;
+	}
+	memset(job, 0, sizeof(PTLoadJob));
+	job->pth = pth;
+	job->generation = ptlgeneration;
+	job->primed = ptlpriming;
+	job->flags = flags;
+	job->effects = effects;
+	job->writetocache = writetocache;
+	job->filename = strdup(head->repldef->filename);
+	if (!job->filename ||
+	    ptm_readtexturefile(job->filename, &job->picdata, &job->picdatalen)) {
+		// let the immediate load report the trouble
+		ptl_freejob(job);
+		return 0;
+	}
+
+	detect_texture_size();
+	head->flags = flags;
+	pth->loading = 1;
+	job->loadseq = ++pth->loadseq;
+	ptlnumjobs++;
+
+	bmutex_lock(ptlmutex);
+	if (ptlqueuetail) {
+		ptlqueuetail->next = job;
+	} else {
+		ptlqueue = job;
 	}
+	ptlqueuetail = job;
+	bmutex_unlock(ptlmutex);
+
+	// the render thread lends a hand while priming, so the others go on spare processors
+	ptl_startworkers(ptlpriming ? max(1, bthread_cpucount() - 1) : 1);
+
+	return 1;
+}
+
+/**
+ * Sends a prepared replacement to GL, or discards it if it's been orphaned
+ * @param job the job, which is freed
+ */
+static void ptl_finishjob(PTLoadJob * job)
+{
+	PTHash * pth = job->pth;
+	PTMIdent id;
+
+	ptlnumjobs--;
+	if (job->primed && ptlpriming) {
+		primedone++;
+	}
+
+	// pth may be gone once the generation has moved on, so check that first
+	if (job->generation != ptlgeneration || !pth->loading || job->loadseq != pth->loadseq) {
+		ptl_freejob(job);
+		return;
+	}
+	pth->loading = 0;
+
+	if (job->err) {
+		if (polymosttexverbosity >= 1) {
+			buildprintf("PolymostTex: %s (pic %d pal %d) %s\n",
+					   job->filename, pth->head.picnum, pth->head.palnum,
+					   PTM_GetLoadTextureFileErrorString(job->err));
+		}
+
+		// defer to the ART version as pt_load would have
+		pth->deferto = pt_findhash(
+				pth->head.picnum, pth->head.palnum,
+				(pth->head.flags & ~PTH_HIGHTILE),
+				1);
+		ptl_freejob(job);
+		return;
+	}
+
+	PTM_InitIdent(&id, &pth->head);
+	id.layer = PTHPIC_BASE;
+	pth->head.pic[PTHPIC_BASE] = PTM_GetHead(&id);
+	pth->head.pic[PTHPIC_BASE]->tsizx = job->tsizx;
+	pth->head.pic[PTHPIC_BASE]->tsizy = job->tsizy;
+	pth->head.pic[PTHPIC_BASE]->sizx  = job->sizx;
+	pth->head.pic[PTHPIC_BASE]->sizy  = job->sizy;
+	ptm_sendtexture(pth->head.pic[PTHPIC_BASE], &job->chain);
+
+	pth->head.scalex = (float)job->tsizx / (float)tilesizx[pth->head.picnum];
+	pth->head.scaley = (float)job->tsizy / (float)tilesizy[pth->head.picnum];
+	pt_load_applyparameters(&pth->head);
+
+	if (job->tdef) {
+		if (polymosttexverbosity >= 2) {
+			buildprintf("PolymostTex: writing %s (effects %d, flags %d) to cache\n",
+					   job->tdef->filename, job->tdef->effects, job->tdef->flags);
+		}
+		PTCacheWriteTile(job->tdef);
+	}
+
+	ptl_freejob(job);
+}
+
+/**
+ * Stops the loader worker and throws away every job
+ */
+static void ptl_shutdown(void)
+{
+	PTLoadJob * job;
+	int i;
+
+	ptlworkercancel = 1;
+	for (i = 0; i < PTLOADMAXWORKERS; i++) {
+		if (ptlworkers[i].thread) {
+			bthread_wait(ptlworkers[i].thread);
+			ptlworkers[i].thread = 0;
+		}
+	}
+	ptlworkercancel = 0;
+
+	while (ptlqueue) {
+		job = ptlqueue;
+		ptlqueue = job->next;
+		ptl_freejob(job);
+	}
+	while (ptldone) {
+		job = ptldone;
+		ptldone = job->next;
+		ptl_freejob(job);
+	}
+	ptlqueuetail = ptldonetail = 0;
+	ptlnumjobs = 0;
+}
+
+/**
+ * Sends replacements the loader has finished preparing to GL
+ * @param budget the number of bytes to send, or <0 for no limit. At least
+ *   one replacement is sent regardless.
+ */
+static void ptl_service(int budget)
+{
+	PTLoadJob * job;
+	int sent = 0;
+
+	if (!ptlmutex) {
+		return;
+	}
+
+	while (1) {
+		bmutex_lock(ptlmutex);
+		job = ptldone;
+		if (job && budget >= 0 && sent > 0 && sent + job->chain.bytes > budget) {
+			// at least one goes each frame, however large
+			job = 0;
+		}
+		if (job) {
+			ptldone = job->next;
+			if (!ptldone) {
+				ptldonetail = 0;
+			}
+		}
+		bmutex_unlock(ptlmutex);
+
+		if (!job) {
+			break;
+		}
+		sent += max(1, job->chain.bytes);
+		ptl_finishjob(job);
+	}
+}
+
+/**
+ * Sends replacements the loader has finished preparing to GL. Call once per frame.
+ */
+void PTServiceLoader(void)
+{
+	ptl_service(max(0, gltexuploadbudget) * 1024);
 }
 
 
@@ -1308,6 +2136,8 @@ void PTBeginPriming(void)
 	primecnt = 0;
 	primedone = 0;
 	primepos = 0;
+	primepth = 0;
+	primeunloaded = 0;
 }
 
 /**
@@ -1331,19 +2161,17 @@ void PTMarkPrime(int picnum, int palnum, unsigned short flags)
  * @param done receives the number of textures primed so far
  * @param total receives the total number of textures to be primed
  * @return 0 when priming is complete
+ *
+ * Hightile replacements are handed to the loader as fast as it will take
+ * them, and everything else is loaded there and then. Replacements a
+ * worker is still busy with at the end are finished off during play.
  */
 int PTDoPrime(int* done, int* total)
 {
 	PTHash * pth;
+	int i, pending;
 
-	if (primepos >= PTHASHHEADSIZ) {
-		// done
-		return 0;
-	}
-
-	if (primepos == 0) {
-		int i;
-
+	if (!primeunloaded) {
 		// first, unload all the textures that are not marked
 		for (i=PTHASHHEADSIZ-1; i>=0; i--) {
 			pth = pthashhead[i];
@@ -1354,22 +2182,52 @@ int PTDoPrime(int* done, int* total)
 				pth = pth->next;
 			}
 		}
+		primeunloaded = 1;
+		primepth = pthashhead[0];
 	}
 
-	pth = pthashhead[primepos];
-	while (pth) {
-		if (pth->primecnt > 0) {
-			primedone++;
+	ptlpriming = 1;
+
+	// feed the loader until it's full or something has been loaded directly
+	while (primepos < PTHASHHEADSIZ && ptlnumjobs < PTLOADMAXJOBS) {
+		if (!primepth) {
+			if (++primepos < PTHASHHEADSIZ) {
+				primepth = pthashhead[primepos];
+			}
+			continue;
+		}
+
+		pth = primepth;
+		primepth = pth->next;
+		if (pth->primecnt > 0 && !pth->loading) {
 			pt_load(pth);
+			if (!pth->loading) {
+				primedone++;
+				break;
+			}
 		}
-		pth = pth->next;
 	}
 
+	// take a job from the queue, then upload whatever is ready
+	ptl_helpout();
+	ptl_service(-1);
+
+	ptlpriming = 0;
+
 	*done = primedone;
 	*total = primecnt;
-	primepos++;
 
-	return (primepos < PTHASHHEADSIZ);
+	if (primepos < PTHASHHEADSIZ) {
+		return 1;
+	}
+
+	pending = 0;
+	if (ptlmutex) {
+		bmutex_lock(ptlmutex);
+		pending = (ptlqueue || ptldone);
+		bmutex_unlock(ptlmutex);
+	}
+	return pending;
 }
 
 /**
@@ -1380,6 +2238,8 @@ void PTReset(void)
 	PTHash * pth;
 	int i;
 
+	ptlgeneration++;
+
 	for (i=PTHASHHEADSIZ-1; i>=0; i--) {
 		pth = pthashhead[i];
 		while (pth) {
@@ -1387,6 +2247,7 @@ void PTReset(void)
 			pth = pth->next;
 		}
 	}
+	pt_atlas_reset();
 }
 
 /**
@@ -1398,6 +2259,8 @@ void PTClear(void)
 	PTMHash * ptmh, * mnext;
 	int i;
 
+	ptl_shutdown();
+
 	for (i=PTHASHHEADSIZ-1; i>=0; i--) {
 		pth = pthashhead[i];
 		while (pth) {
@@ -1408,6 +2271,7 @@ void PTClear(void)
 		}
 		pthashhead[i] = 0;
 	}
+	pt_atlas_reset();
 
 	for (i=PTMHASHHEADSIZ-1; i>=0; i--) {
 		ptmh = ptmhashhead[i];
@@ -1448,6 +2312,19 @@ PTHead * PT_GetHead(int picnum, int palnum, unsigned short flags, int peek)
 		pth = pth->deferto;
 	}
 
+	if ((pth->head.flags & PTH_HIGHTILE) &&
+	    !(pth->head.pic[PTHPIC_BASE] && pth->head.pic[PTHPIC_BASE]->glpic)) {
+		// the replacement is still with the loader, so the ART tile
+		// stands in for it until it is ready
+		pth = pt_findhash(picnum, palnum, (flags & ~PTH_HIGHTILE), 1);
+		if (pth == 0 || !pt_load(pth)) {
+			return 0;
+		}
+		while (pth->deferto) {
+			pth = pth->deferto;
+		}
+	}
+
 	return &pth->head;
 }
 
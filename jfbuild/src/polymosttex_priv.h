@@ -15,6 +15,8 @@ enum {
 	PTH_HASALPHA = 8,		// NOTE: only seen in PTMHead.flags, not in PTHead.flags
 	PTH_NOCOMPRESS = 16,	// prevents texture compression from being used
 	PTH_NOMIPLEVEL = 32,	// prevents gltexmiplevel from being applied
+	PTH_ATLAS = 64,		// PTHead: has been drawn by rotatesprite, so may be packed into an atlas
+				// PTMHead: glpic is a shared atlas texture
 	PTH_DIRTY = 128,		// NOTE: only seen in PTMHead.flags, not in PTHead.flags
 };
 
@@ -34,6 +36,8 @@ struct PTMHead_typ {
 	int flags;
 	int sizx, sizy;		// padded texture dimensions
 	int tsizx, tsizy;		// true texture dimensions
+	int atlas;			// 1 + index of the atlas holding the tile when (flags & PTH_ATLAS)
+	int atlasx, atlasy;		// position of the tile when (flags & PTH_ATLAS)
 };
 
 typedef struct PTMHead_typ PTMHead;
@@ -82,6 +86,8 @@ struct PTIter_typ;	// an opaque iterator type for walking the internal hash
 typedef struct PTIter_typ * PTIter;
 
 extern int polymosttexverbosity;	// 0 = none, 1 = errors (default), 2 = all
+extern int gltexasyncload;	// !0 = prepare hightile replacements in the background
+extern int gltexuploadbudget;	// kilobytes of loaded textures sent to GL per frame
 
 /**
  * Prepare for priming by sweeping through the textures and marking them as all unused
@@ -101,6 +107,12 @@ void PTMarkPrime(int picnum, int palnum, unsigned short flags);
  */
 int PTDoPrime(int* done, int* total);
 
+/**
+ * Sends hightile replacements the background loader has finished preparing
+ * to GL, within the gltexuploadbudget. Call once per frame.
+ */
+void PTServiceLoader(void);
+
 /**
  * Resets the texture hash but leaves the headers in memory
  */
@@ -111,6 +123,11 @@ void PTReset(void);
  */
 void PTClear(void);
 
+/**
+ * Applies the global texture filter parameters to the ART tile atlases
+ */
+void PTAtlasApplyParameters(void);
+
 /**
  * Creates a new iterator for walking the header hash looking for particular
  * parameters that match.
@@ -8,6 +8,18 @@
 #include "hightile_priv.h"
 #include "polymosttex_priv.h"
 
+#if defined(_XBOX)
+	// No file mapping on the Xbox. The storage file is kept open and
+	// each tile is read in a single fread() instead.
+#elif defined(_WIN32)
+# define PTCACHE_MAPWIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#else
+# define PTCACHE_MAPPOSIX
+# include <sys/mman.h>
+#endif
+
 /*
  PolymostTex Cache file formats
 
@@ -19,6 +31,7 @@
      effects   int32
      flags     int32		PTH_CLAMPED
      offset    uint32		Offset from the start of the STORAGE file
+     length    uint32		Length of the entry in the STORAGE file
      mtime     int32		When kplib can return mtimes from ZIPs, this will be used to spot stale entries
 
  STORAGE (texture.cache):
@@ -37,6 +50,10 @@
        data    char[length]
 
  All multibyte values are little-endian.
+
+ The storage file is memory mapped once and tiles are served straight out
+ of the mapping. New entries are appended through a handle that stays open
+ for the session, and the mapping is extended when a load reaches past it.
  */
 
 struct PTCacheIndex_typ {
@@ -44,19 +61,41 @@ struct PTCacheIndex_typ {
 	int effects;
 	int flags;
 	unsigned offset;
+	unsigned length;
 	struct PTCacheIndex_typ * next;
 };
 typedef struct PTCacheIndex_typ PTCacheIndex;
-#define PTCACHEHASHSIZ 512
-static PTCacheIndex * cachehead[PTCACHEHASHSIZ];	// will be initialized 0 by .bss segment
+#define PTCACHEHASHSIZ 512	// minimum; the table grows to keep pace with the entry count
+static PTCacheIndex ** cachehead = 0;
+static unsigned int cachehashsiz = 0;
+static unsigned int cacheentries = 0;
 #define PTCACHEINDEXFILENAMELEN 260
+#define PTCACHEINDEXENTRYLEN (PTCACHEINDEXFILENAMELEN + 5*4)
 
 static const char * CACHEINDEXFILE = "texture.cacheindex";
 static const char * CACHESTORAGEFILE = "texture.cache";
-static const int CACHEVER = 0;
+static const int CACHEVER = 1;
 
 static int cachedisabled = 0, cachereplace = 0;
 
+// A mapped view of the storage file. Tiles loaded from it point into it, so
+// a view replaced by a larger one lives on until the last of those is freed.
+typedef struct {
+	const unsigned char * base;
+	size_t size;			// bytes of the storage file covered by the view
+#ifdef PTCACHE_MAPWIN32
+	HANDLE mapping;
+#endif
+	int refs;			// tiles using the view, plus one while it is current
+} PTCacheView;
+
+static struct {
+	FILE * readfh;			// storage, for reading
+	FILE * storefh;			// storage, for appending
+	FILE * indexfh;			// index, for appending
+	PTCacheView * view;		// current view of the storage file
+} store;
+
 static unsigned int gethashhead(const char * filename)
 {
 	// implements the djb2 hash, constrained to the hash table size
@@ -68,7 +107,36 @@ static unsigned int gethashhead(const char * filename)
 		hash = ((hash << 5) + hash) ^ c; /* hash * 33 ^ c */
 	}
 
-    return hash & (PTCACHEHASHSIZ-1);
+    return hash & (cachehashsiz-1);
+}
+
+/**
+ * Resizes the cachehead hash, rehashing any entries present.
+ * @param size the new number of buckets, a power of two
+ */
+static void ptcache_resizehash(unsigned int size)
+{
+	PTCacheIndex ** oldhead = cachehead, * pci, * next;
+	unsigned int oldsiz = cachehashsiz, i, hash;
+
+	cachehead = (PTCacheIndex **) calloc(size, sizeof(PTCacheIndex *));
+	if (!cachehead) {
+		cachehead = oldhead;
+		return;
+	}
+	cachehashsiz = size;
+
+	for (i = 0; i < oldsiz; i++) {
+		for (pci = oldhead[i]; pci; pci = next) {
+			next = pci->next;
+			hash = gethashhead(pci->filename);
+			pci->next = cachehead[hash];
+			cachehead[hash] = pci;
+		}
+	}
+	if (oldhead) {
+		free(oldhead);
+	}
 }
 
 /**
@@ -77,22 +145,37 @@ static unsigned int gethashhead(const char * filename)
  * @param effects
  * @param flags
  * @param offset
+ * @param length
  */
-static void ptcache_addhash(const char * filename, int effects, int flags, unsigned offset)
+static void ptcache_addhash(const char * filename, int effects, int flags, unsigned offset, unsigned length)
 {
-	unsigned int hash = gethashhead(filename);
+	unsigned int hash;
+	PTCacheIndex * pci;
+
+	if (cacheentries >= cachehashsiz) {
+		ptcache_resizehash(cachehashsiz ? cachehashsiz * 2 : PTCACHEHASHSIZ);
+		if (!cachehashsiz) {
+			return;
+		}
+	}
+	hash = gethashhead(filename);
 
 	// to reduce memory fragmentation we tack the filename onto the end of the block
-	PTCacheIndex * pci = (PTCacheIndex *) malloc(sizeof(PTCacheIndex) + strlen(filename) + 1);
+	pci = (PTCacheIndex *) malloc(sizeof(PTCacheIndex) + strlen(filename) + 1);
+	if (!pci) {
+		return;
+	}
 
 	pci->filename = (char *) pci + sizeof(PTCacheIndex);
 	strcpy(pci->filename, filename);
 	pci->effects = effects;
 	pci->flags   = flags & (PTH_CLAMPED);
 	pci->offset  = offset;
+	pci->length  = length;
 	pci->next = cachehead[hash];
 
 	cachehead[hash] = pci;
+	cacheentries++;
 }
 
 /**
@@ -106,6 +189,10 @@ static PTCacheIndex * ptcache_findhash(const char * filename, int effects, int f
 {
 	PTCacheIndex * pci;
 
+	if (!cachehashsiz) {
+		return 0;
+	}
+
 	pci = cachehead[ gethashhead(filename) ];
 	if (!pci) {
 		return 0;
@@ -125,6 +212,110 @@ static PTCacheIndex * ptcache_findhash(const char * filename, int effects, int f
 	return 0;
 }
 
+/**
+ * Drops a reference to a view, unmapping it once nothing uses it.
+ */
+static void ptcache_releaseview(PTCacheView * view)
+{
+	if (--view->refs > 0) {
+		return;
+	}
+#if defined(PTCACHE_MAPWIN32)
+	UnmapViewOfFile((LPCVOID) view->base);
+	CloseHandle(view->mapping);
+#elif defined(PTCACHE_MAPPOSIX)
+	munmap((void *) view->base, view->size);
+#endif
+	free(view);
+}
+
+/**
+ * Lets go of the current view of the storage file. Tiles still loaded from
+ * it keep it mapped until they are freed.
+ */
+static void ptcache_unmapstore(void)
+{
+	if (store.view) {
+		ptcache_releaseview(store.view);
+		store.view = 0;
+	}
+}
+
+/**
+ * Closes every handle on the cache files.
+ */
+static void ptcache_closestore(void)
+{
+	ptcache_unmapstore();
+	if (store.readfh) {
+		fclose(store.readfh);
+		store.readfh = 0;
+	}
+	if (store.storefh) {
+		fclose(store.storefh);
+		store.storefh = 0;
+	}
+	if (store.indexfh) {
+		fclose(store.indexfh);
+		store.indexfh = 0;
+	}
+}
+
+/**
+ * Makes sure the first 'needed' bytes of the storage file are mapped.
+ * @param needed the number of bytes required
+ * @return !0 if they are
+ */
+static int ptcache_mapstore(size_t needed)
+{
+#if defined(PTCACHE_MAPWIN32) || defined(PTCACHE_MAPPOSIX)
+	struct stat st;
+	PTCacheView * view;
+
+	if (store.view && store.view->size >= needed) {
+		return 1;
+	}
+	ptcache_unmapstore();
+
+	if (fstat(fileno(store.readfh), &st) || (size_t) st.st_size < needed || st.st_size == 0) {
+		return 0;
+	}
+
+	view = (PTCacheView *) malloc(sizeof(PTCacheView));
+	if (!view) {
+		return 0;
+	}
+#if defined(PTCACHE_MAPWIN32)
+	view->mapping = CreateFileMapping((HANDLE) _get_osfhandle(fileno(store.readfh)),
+		NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!view->mapping) {
+		free(view);
+		return 0;
+	}
+	view->base = (const unsigned char *) MapViewOfFile(view->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view->base) {
+		CloseHandle(view->mapping);
+		free(view);
+		return 0;
+	}
+#else
+	view->base = (const unsigned char *) mmap(NULL, st.st_size, PROT_READ, MAP_SHARED,
+		fileno(store.readfh), 0);
+	if (view->base == (const unsigned char *) MAP_FAILED) {
+		free(view);
+		return 0;
+	}
+#endif
+	view->size = st.st_size;
+	view->refs = 1;
+	store.view = view;
+	return 1;
+#else
+	(void)needed;
+	return 0;
+#endif
+}
+
 /**
  * Loads the cache index file into memory
  */
@@ -139,14 +330,15 @@ void PTCacheLoadIndex(void)
 	int32_t effects;
 	int32_t flags;
 	uint32_t offset;
-	int32_t mtime;
+	uint32_t length;
 	PTCacheIndex * pci;
+	unsigned char * indexbuf = 0, * ent;
+	long indexlen;
+	unsigned int numentries, hashsiz, i;
 
 	int total = 0, dups = 0;
 	int haveindex = 0, havestore = 0;
 
-	memset(filename, 0, sizeof(filename));
-
 	// first, check the cache storage file's signature.
 	// we open for reading and writing to test permission
 	fh = fopen(CACHESTORAGEFILE, "r+b");
@@ -193,48 +385,73 @@ void PTCacheLoadIndex(void)
 		cachereplace = 1;
 	}
 
+	// the entries follow the signature in fixed-size records, so the whole
+	// index comes in with one read and its size tells us how big a hash to make
+	if (!cachereplace) {
+		fseek(fh, 0, SEEK_END);
+		indexlen = ftell(fh) - 16;
+		if (indexlen < 0 || (indexlen % PTCACHEINDEXENTRYLEN) != 0) {
+			buildprintf("PolymostTexCache: corrupt texture cache index detected, cache will be replaced\n");
+			cachereplace = 1;
+		} else if (indexlen > 0) {
+			indexbuf = (unsigned char *) malloc(indexlen);
+			fseek(fh, 16, SEEK_SET);
+			if (!indexbuf || fread(indexbuf, indexlen, 1, fh) != 1) {
+				buildprintf("PolymostTexCache: error reading %s, cache will be replaced\n", CACHEINDEXFILE);
+				cachereplace = 1;
+			}
+		}
+	}
+
 	if (cachereplace) {
 		buildprintf("PolymostTexCache: texture cache will be replaced\n");
+		if (indexbuf) {
+			free(indexbuf);
+		}
 		if (fh) {
 			fclose(fh);
 		}
 		return;
 	}
 
-	// now that the index is sitting at the first entry, load everything
-	while (!feof(fh)) {
-		if (fread(filename, PTCACHEINDEXFILENAMELEN, 1, fh) != 1 && feof(fh)) {
-			break;
-		}
-		if (fread(&effects, 4,         1, fh) != 1 ||
-		    fread(&flags,   4,         1, fh) != 1 ||
-		    fread(&offset,  4,         1, fh) != 1 ||
-		    fread(&mtime,   4,         1, fh) != 1) {
-			// truncated entry, so throw the whole cache away
-			buildprintf("PolymostTexCache: corrupt texture cache index detected, cache will be replaced\n");
-			cachereplace = 1;
-			PTCacheUnloadIndex();
-			break;
-		}
+	fclose(fh);
+
+	numentries = (unsigned int)(indexlen / PTCACHEINDEXENTRYLEN);
+	for (hashsiz = PTCACHEHASHSIZ; hashsiz < numentries; hashsiz <<= 1) ;
+	ptcache_resizehash(hashsiz);
+
+	for (i = 0, ent = indexbuf; i < numentries; i++, ent += PTCACHEINDEXENTRYLEN) {
+		memcpy(filename, ent, PTCACHEINDEXFILENAMELEN);
+		memcpy(&effects, ent + PTCACHEINDEXFILENAMELEN,      4);
+		memcpy(&flags,   ent + PTCACHEINDEXFILENAMELEN + 4,  4);
+		memcpy(&offset,  ent + PTCACHEINDEXFILENAMELEN + 8,  4);
+		memcpy(&length,  ent + PTCACHEINDEXFILENAMELEN + 12, 4);
 
 		effects = B_LITTLE32(effects);
 		flags   = B_LITTLE32(flags);
 		offset  = B_LITTLE32(offset);
-		mtime   = B_LITTLE32(mtime);
+		length  = B_LITTLE32(length);
 
 		filename[sizeof(filename)-1] = 0;
 		pci = ptcache_findhash(filename, (int) effects, (int) flags);
 		if (pci) {
 			// superseding an old hash entry
 			pci->offset = offset;
+			pci->length = length;
 			dups++;
 		} else {
-			ptcache_addhash(filename, (int) effects, (int) flags, offset);
+			ptcache_addhash(filename, (int) effects, (int) flags, offset, length);
 		}
 		total++;
 	}
 
-	fclose(fh);
+	if (indexbuf) {
+		free(indexbuf);
+	}
+
+	if (havestore) {
+		store.readfh = fopen(CACHESTORAGEFILE, "rb");
+	}
 
 	buildprintf("PolymostTexCache: cache index loaded (%d entries, %d old entries skipped)\n", total, dups);
 }
@@ -245,9 +462,9 @@ void PTCacheLoadIndex(void)
 void PTCacheUnloadIndex(void)
 {
 	PTCacheIndex * pci, * next;
-	int i;
+	unsigned int i;
 
-	for (i = 0; i < PTCACHEHASHSIZ; i++) {
+	for (i = 0; i < cachehashsiz; i++) {
 		pci = cachehead[i];
 		while (pci) {
 			next = pci->next;
@@ -255,98 +472,123 @@ void PTCacheUnloadIndex(void)
 			free(pci);
 			pci = next;
 		}
-		cachehead[i] = 0;
 	}
+	if (cachehead) {
+		free(cachehead);
+	}
+	cachehead = 0;
+	cachehashsiz = 0;
+	cacheentries = 0;
+
+	ptcache_closestore();
 
 	buildprintf("PolymostTexCache: cache index unloaded\n");
 }
 
+static inline int32_t ptcache_getint(const unsigned char * p)
+{
+	int32_t v;
+	memcpy(&v, p, 4);
+	return B_LITTLE32(v);
+}
+
 /**
  * Does the task of loading a tile from the cache
  * @param offset the starting offset
+ * @param length the length of the entry
  * @return a PTCacheTile entry fully completed
  */
-static PTCacheTile * ptcache_load(off_t offset)
+static PTCacheTile * ptcache_load(unsigned offset, unsigned length)
 {
-	int32_t tsizx, tsizy;
-	int32_t sizx, sizy;
-	int32_t flags;
-	int32_t format;
 	int32_t nmipmaps, i;
-	int32_t length;
+	int32_t mlength;
+	unsigned pos;
 
+	const unsigned char * data;
+	unsigned char * block = 0;
 	PTCacheTile * tdef = 0;
-	FILE * fh;
 
 	if (cachereplace) {
 		// cache is in a broken state, so don't try loading
 		return 0;
 	}
 
-	fh = fopen(CACHESTORAGEFILE, "rb");
-	if (!fh) {
-		cachedisabled = 1;
-		buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHESTORAGEFILE);
-		return 0;
+	if (!store.readfh) {
+		store.readfh = fopen(CACHESTORAGEFILE, "rb");
+		if (!store.readfh) {
+			cachedisabled = 1;
+			buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHESTORAGEFILE);
+			return 0;
+		}
 	}
 
-	fseek(fh, offset, SEEK_SET);
-
-	if (fread(&tsizx, 4, 1, fh) != 1 ||
-	    fread(&tsizy, 4, 1, fh) != 1 ||
-	    fread(&flags, 4, 1, fh) != 1 ||
-	    fread(&format, 4, 1, fh) != 1 ||
-	    fread(&nmipmaps, 4, 1, fh) != 1) {
-		// truncated entry, so throw the whole cache away
+	if (length < 5*4) {
 		goto fail;
 	}
 
-	tsizx = B_LITTLE32(tsizx);
-	tsizy = B_LITTLE32(tsizy);
-	flags = B_LITTLE32(flags);
-	format = B_LITTLE32(format);
-	nmipmaps = B_LITTLE32(nmipmaps);
+	if (ptcache_mapstore((size_t) offset + length)) {
+		data = store.view->base + offset;
+	} else {
+		// no mapping to be had, so bring the whole entry in with one read
+		block = (unsigned char *) malloc(length);
+		if (!block) {
+			return 0;
+		}
+		if (fseek(store.readfh, offset, SEEK_SET) ||
+		    fread(block, length, 1, store.readfh) != 1) {
+			goto fail;
+		}
+		data = block;
+	}
+
+	nmipmaps = ptcache_getint(data + 16);
+	if (nmipmaps < 1 || nmipmaps > 32) {
+		goto fail;
+	}
 
 	tdef = PTCacheAllocNewTile(nmipmaps);
-	tdef->tsizx = tsizx;
-	tdef->tsizy = tsizy;
-	tdef->flags = flags;
-	tdef->format = format;
-
-	for (i = 0; i < nmipmaps; i++) {
-		if (fread(&sizx, 4, 1, fh) != 1 ||
-		    fread(&sizy, 4, 1, fh) != 1 ||
-		    fread(&length, 4, 1, fh) != 1) {
+	tdef->tsizx = ptcache_getint(data);
+	tdef->tsizy = ptcache_getint(data + 4);
+	tdef->flags = ptcache_getint(data + 8);
+	tdef->format = ptcache_getint(data + 12);
+	tdef->datablock = block;
+	tdef->datashared = 1;
+	if (!block) {
+		// hold the view so a remap for a later, larger entry can't pull it away
+		tdef->dataview = store.view;
+		store.view->refs++;
+	}
+
+	for (i = 0, pos = 5*4; i < nmipmaps; i++) {
+		if (length - pos < 3*4) {
 			// truncated entry, so throw the whole cache away
 			goto fail;
 		}
 
-		sizx = B_LITTLE32(sizx);
-		sizy = B_LITTLE32(sizy);
-		length = B_LITTLE32(length);
-
-		tdef->mipmap[i].sizx = sizx;
-		tdef->mipmap[i].sizy = sizy;
-		tdef->mipmap[i].length = length;
-		tdef->mipmap[i].data = (unsigned char *) malloc(length);
-
-		if (fread(tdef->mipmap[i].data, length, 1, fh) != 1) {
+		mlength = ptcache_getint(data + pos + 8);
+		if (mlength < 0 || (unsigned)mlength > length - pos - 3*4) {
 			// truncated data
 			goto fail;
 		}
-	}
 
-	fclose(fh);
+		tdef->mipmap[i].sizx = ptcache_getint(data + pos);
+		tdef->mipmap[i].sizy = ptcache_getint(data + pos + 4);
+		tdef->mipmap[i].length = mlength;
+		tdef->mipmap[i].data = (unsigned char *) data + pos + 3*4;
+
+		pos += 3*4 + mlength;
+	}
 
 	return tdef;
 fail:
 	cachereplace = 1;
 	buildprintf("PolymostTexCache: corrupt texture cache detected, cache will be replaced\n");
-	PTCacheUnloadIndex();
-	fclose(fh);
 	if (tdef) {
 		PTCacheFreeTile(tdef);
+	} else if (block) {
+		free(block);
 	}
+	PTCacheUnloadIndex();
 	return 0;
 }
 
@@ -371,7 +613,7 @@ PTCacheTile * PTCacheLoadTile(const char * filename, int effects, int flags)
 		return 0;
 	}
 
-	tdef = ptcache_load(pci->offset);
+	tdef = ptcache_load(pci->offset, pci->length);
 	if (tdef) {
 		tdef->filename = strdup(filename);
 		tdef->effects  = effects;
@@ -406,9 +648,19 @@ void PTCacheFreeTile(PTCacheTile * tdef)
 	if (tdef->filename) {
 		free(tdef->filename);
 	}
-	for (i = 0; i < tdef->nummipmaps; i++) {
-		if (tdef->mipmap[i].data) {
-			free(tdef->mipmap[i].data);
+	if (tdef->datashared) {
+		// the mipmaps point into a cache view or a single block
+		if (tdef->datablock) {
+			free(tdef->datablock);
+		}
+		if (tdef->dataview) {
+			ptcache_releaseview((PTCacheView *) tdef->dataview);
+		}
+	} else {
+		for (i = 0; i < tdef->nummipmaps; i++) {
+			if (tdef->mipmap[i].data) {
+				free(tdef->mipmap[i].data);
+			}
 		}
 	}
 	free(tdef);
@@ -443,8 +695,9 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 	long i;
 	PTCacheIndex * pci;
 
-	FILE * fh;
+	FILE * fh = 0;
 	off_t offset;
+	uint32_t length;
 	char createmode[] = "ab";
 
 	if (cachedisabled) {
@@ -452,17 +705,22 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 	}
 
 	if (cachereplace) {
+		// let go of the old files before truncating them
+		ptcache_closestore();
 		createmode[0] = 'w';
 		cachereplace = 0;
 	}
 
 	// 1. write the tile data to the storage file
-	fh = fopen(CACHESTORAGEFILE, createmode);
-	if (!fh) {
-		cachedisabled = 1;
-		buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHESTORAGEFILE);
-		return 0;
+	if (!store.storefh) {
+		store.storefh = fopen(CACHESTORAGEFILE, createmode);
+		if (!store.storefh) {
+			cachedisabled = 1;
+			buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHESTORAGEFILE);
+			return 0;
+		}
 	}
+	fh = store.storefh;
 
 	// apparently opening in append doesn't actually put the
 	// file pointer at the end of the file like you would
@@ -501,18 +759,19 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 			goto fail;
 		}
 	}
+	length = 5*4;
 
 	for (i = 0; i < tdef->nummipmaps; i++) {
 		int32_t sizx, sizy;
-		int32_t length;
+		int32_t mlength;
 
 		sizx = B_LITTLE32(tdef->mipmap[i].sizx);
 		sizy = B_LITTLE32(tdef->mipmap[i].sizy);
-		length = B_LITTLE32(tdef->mipmap[i].length);
+		mlength = B_LITTLE32(tdef->mipmap[i].length);
 
 		if (fwrite(&sizx, 4, 1, fh) != 1 ||
 		    fwrite(&sizy, 4, 1, fh) != 1 ||
-		    fwrite(&length, 4, 1, fh) != 1) {
+		    fwrite(&mlength, 4, 1, fh) != 1) {
 			goto fail;
 		}
 
@@ -520,17 +779,24 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 			// truncated data
 			goto fail;
 		}
+		length += 3*4 + tdef->mipmap[i].length;
 	}
 
-	fclose(fh);
+	// readers go through a different handle, so push the data out to them
+	if (fflush(fh)) {
+		goto fail;
+	}
 
 	// 2. append to the index
-	fh = fopen(CACHEINDEXFILE, createmode);
-	if (!fh) {
-		cachedisabled = 1;
-		buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHEINDEXFILE);
-		return 0;
+	if (!store.indexfh) {
+		store.indexfh = fopen(CACHEINDEXFILE, createmode);
+		if (!store.indexfh) {
+			cachedisabled = 1;
+			buildprintf("PolymostTexCache: error opening %s, texture cache disabled\n", CACHEINDEXFILE);
+			return 0;
+		}
 	}
+	fh = store.indexfh;
 
 	fseek(fh, 0, SEEK_END);
 	if (ftell(fh) == 0) {
@@ -544,7 +810,7 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 	{
 		char filename[PTCACHEINDEXFILENAMELEN];
 		int32_t effects, flags, mtime;
-		uint32_t offs;
+		uint32_t offs, len;
 
 		strncpy(filename, tdef->filename, sizeof(filename));
 		filename[sizeof(filename)-1] = 0;
@@ -552,33 +818,38 @@ int PTCacheWriteTile(PTCacheTile * tdef)
 		flags   = tdef->flags & (PTH_CLAMPED);	// we don't want the informational flags in the index
 		flags   = B_LITTLE32(flags);
 		offs    = B_LITTLE32((uint32_t)offset);
+		len     = B_LITTLE32(length);
 		mtime = 0;
 
 		if (fwrite(filename, sizeof(filename), 1, fh) != 1 ||
 		    fwrite(&effects, 4, 1, fh) != 1 ||
 		    fwrite(&flags, 4, 1, fh) != 1 ||
 		    fwrite(&offs, 4, 1, fh) != 1 ||
+		    fwrite(&len, 4, 1, fh) != 1 ||
 		    fwrite(&mtime, 4, 1, fh) != 1) {
 			goto fail;
 		}
 	}
 
-	fclose(fh);
+	if (fflush(fh)) {
+		goto fail;
+	}
 
 	// stow the data into the index in memory
 	pci = ptcache_findhash(tdef->filename, tdef->effects, tdef->flags);
 	if (pci) {
 		// superseding an old hash entry
 		pci->offset = (unsigned)offset;
+		pci->length = length;
 	} else {
-		ptcache_addhash(tdef->filename, tdef->effects, tdef->flags, (unsigned)offset);
+		ptcache_addhash(tdef->filename, tdef->effects, tdef->flags, (unsigned)offset, length);
 	}
 
 	return 1;
 fail:
 	cachedisabled = 1;
 	buildprintf("PolymostTexCache: error writing to cache, texture cache disabled\n");
-	if (fh) fclose(fh);
+	ptcache_closestore();
 	return 0;
 }
 
@@ -26,6 +26,9 @@ struct PTCacheTile_typ {
 	int format;	// OpenGL format code
 	int tsizx, tsizy;
 	int nummipmaps;
+	int datashared;	// !0 if the mipmap data is not individually malloc()ed
+	unsigned char * datablock;	// when datashared, a block to free() with the tile, or NULL
+	void * dataview;	// when datashared, the storage view the data is in, or NULL
 	PTCacheTileMip mipmap[1];
 };
 typedef struct PTCacheTile_typ PTCacheTile;
@@ -42,6 +45,8 @@ void PTCacheUnloadIndex(void);
 
 /**
  * Loads a tile from the cache.
+ * The mipmap data may point into a mapped view of the cache file, which
+ * stays valid until the tile is freed with PTCacheFreeTile.
  * @param filename the filename
  * @param effects the effects bits
  * @param flags the flags bits
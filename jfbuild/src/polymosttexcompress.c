@@ -0,0 +1,679 @@
+#include "build.h"
+
+#if USE_POLYMOST && USE_OPENGL
+
+#include "glbuild.h"
+#include "engine_priv.h"
+#include "polymost_priv.h"
+#include "polymosttexcompress.h"
+
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__MMX__)
+#include <mmintrin.h>
+#endif
+
+/*
+ Block compressors for the texture cache: DXT1, DXT5 and ETC1.
+
+ Every format works on 4x4 pixel blocks, which are gathered into BGRA
+ order first, repeating the edge pixels of mipmaps smaller than a block.
+ gltexcomprquality trades speed for quality:
+   0  DXT colour endpoints from the block's bounding box,
+      ETC1 base colours from the subblock averages
+   1  DXT endpoints from the principal axis, refined once by least squares;
+      DXT5 alpha and ETC1 base encodings are chosen by error
+   2  as 1, refining until the error stops falling, and ETC1 also trying
+      brighter and darker base colours
+
+ The functions are reentrant, so the background texture loader's workers
+ compress textures concurrently.
+ */
+
+static const int etc1modifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+	{ 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+static inline int ptc_clamp255(int v)
+{
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/**
+ * Gathers a 4x4 block of pixels in BGRA order
+ * @param pic the source pixels
+ * @param width
+ * @param height
+ * @param bx the block's left pixel column
+ * @param by the block's top pixel row
+ * @param rgba !0 if the source is RGBA rather than BGRA
+ * @param blk receives 16 pixels
+ */
+static void ptc_fetchblock(const unsigned char *pic, int width, int height,
+		int bx, int by, int rgba, unsigned char *blk)
+{
+	const unsigned char *src;
+	int x, y;
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++, blk += 4) {
+			src = &pic[(min(by + y, height - 1) * width + min(bx + x, width - 1)) * 4];
+			blk[0] = src[rgba ? 2 : 0];
+			blk[1] = src[1];
+			blk[2] = src[rgba ? 0 : 2];
+			blk[3] = src[3];
+		}
+	}
+}
+
+/**
+ * Projects each pixel of a block onto a colour axis
+ * @param blk the BGRA block
+ * @param db
+ * @param dg
+ * @param dr the axis
+ * @param dots receives 16 dot products
+ */
+static void ptc_dots(const unsigned char *blk, int db, int dg, int dr, int *dots)
+{
+	int i;
+#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	__m128i axis = _mm_setr_epi16(db, dg, dr, 0, db, dg, dr, 0);
+	__m128i px;
+	__m128 lo, hi;
+
+	for (i = 0; i < 16; i += 4) {
+		px = _mm_loadu_si128((const __m128i *)&blk[i * 4]);
+		lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(px, zero), axis));
+		hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(px, zero), axis));
+		_mm_storeu_si128((__m128i *)&dots[i], _mm_add_epi32(
+			_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))),
+			_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)))));
+	}
+#elif defined(__MMX__)
+	__m64 zero = _mm_setzero_si64();
+	__m64 axis = _mm_setr_pi16(db, dg, dr, 0);
+	__m64 px, m0, m1;
+
+	for (i = 0; i < 16; i += 2) {
+		px = *(const __m64 *)&blk[i * 4];
+		m0 = _mm_madd_pi16(_mm_unpacklo_pi8(px, zero), axis);	// B0*db+G0*dg, R0*dr
+		m1 = _mm_madd_pi16(_mm_unpackhi_pi8(px, zero), axis);
+		*(__m64 *)&dots[i] = _mm_add_pi32(_mm_unpacklo_pi32(m0, m1), _mm_unpackhi_pi32(m0, m1));
+	}
+	_mm_empty();
+#else
+	for (i = 0; i < 16; i++) {
+		dots[i] = blk[i * 4 + 0] * db + blk[i * 4 + 1] * dg + blk[i * 4 + 2] * dr;
+	}
+#endif
+}
+
+static inline int ptc_to565(const int *bgr)
+{
+	return (((bgr[2] * 31 + 127) / 255) << 11) |
+	       (((bgr[1] * 63 + 127) / 255) << 5) |
+	        ((bgr[0] * 31 + 127) / 255);
+}
+
+/**
+ * Decodes the four colours a DXT colour block can index
+ * @param c0
+ * @param c1 the 5:6:5 endpoints
+ * @param pal receives BGR triplets
+ */
+static void ptc_palette(int c0, int c1, int pal[4][3])
+{
+	int k;
+
+	pal[0][0] = ((c0 & 31) << 3) | ((c0 & 31) >> 2);
+	pal[0][1] = (((c0 >> 5) & 63) << 2) | (((c0 >> 5) & 63) >> 4);
+	pal[0][2] = ((c0 >> 11) << 3) | ((c0 >> 11) >> 2);
+	pal[1][0] = ((c1 & 31) << 3) | ((c1 & 31) >> 2);
+	pal[1][1] = (((c1 >> 5) & 63) << 2) | (((c1 >> 5) & 63) >> 4);
+	pal[1][2] = ((c1 >> 11) << 3) | ((c1 >> 11) >> 2);
+	for (k = 0; k < 3; k++) {
+		pal[2][k] = (2 * pal[0][k] + pal[1][k]) / 3;
+		pal[3][k] = (pal[0][k] + 2 * pal[1][k]) / 3;
+	}
+}
+
+/**
+ * Picks the colour index of each pixel by projecting it onto the endpoint axis
+ * @return 2 bits per pixel, first pixel lowest
+ */
+static unsigned int ptc_matchcolours(const unsigned char *blk, int c0, int c1)
+{
+	int pal[4][3], dots[16], stops[4];
+	int db, dg, dr, i, d, c1pt, halfpt, c0pt;
+	unsigned int indices = 0;
+
+	ptc_palette(c0, c1, pal);
+	db = pal[0][0] - pal[1][0];
+	dg = pal[0][1] - pal[1][1];
+	dr = pal[0][2] - pal[1][2];
+	if (!db && !dg && !dr) {
+		return 0;
+	}
+
+	ptc_dots(blk, db, dg, dr, dots);
+	for (i = 0; i < 4; i++) {
+		stops[i] = pal[i][0] * db + pal[i][1] * dg + pal[i][2] * dr;
+	}
+
+	// along the axis the colours run 1, 3, 2, 0; compare against the midpoints
+	c1pt = stops[1] + stops[3];
+	halfpt = stops[3] + stops[2];
+	c0pt = stops[2] + stops[0];
+	for (i = 15; i >= 0; i--) {
+		d = dots[i] * 2;
+		indices <<= 2;
+		if (d < halfpt) {
+			indices |= (d < c1pt) ? 1 : 3;
+		} else {
+			indices |= (d < c0pt) ? 2 : 0;
+		}
+	}
+
+	return indices;
+}
+
+static int ptc_colourerror(const unsigned char *blk, int c0, int c1, unsigned int indices)
+{
+	int pal[4][3], i, k, d, err = 0;
+
+	ptc_palette(c0, c1, pal);
+	for (i = 0; i < 16; i++, indices >>= 2) {
+		for (k = 0; k < 3; k++) {
+			d = blk[i * 4 + k] - pal[indices & 3][k];
+			err += d * d;
+		}
+	}
+	return err;
+}
+
+/**
+ * Solves for the endpoints that best fit a block given its colour indices
+ * @return 0 if every pixel uses the same weights, leaving the endpoints alone
+ */
+static int ptc_refinecolours(const unsigned char *blk, unsigned int indices, int *c0, int *c1)
+{
+	static const int weight0[4] = { 3, 0, 2, 1 };
+	int aa = 0, bb = 0, ab = 0, at[3] = { 0, 0, 0 }, bt[3] = { 0, 0, 0 };
+	int e0[3], e1[3], i, k, a, b, det, n;
+
+	for (i = 0; i < 16; i++, indices >>= 2) {
+		a = weight0[indices & 3];
+		b = 3 - a;
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+		for (k = 0; k < 3; k++) {
+			at[k] += a * blk[i * 4 + k];
+			bt[k] += b * blk[i * 4 + k];
+		}
+	}
+
+	det = aa * bb - ab * ab;
+	if (det == 0) {
+		return 0;
+	}
+	for (k = 0; k < 3; k++) {
+		n = 3 * (at[k] * bb - bt[k] * ab);
+		e0[k] = n <= 0 ? 0 : ptc_clamp255((n + det / 2) / det);
+		n = 3 * (bt[k] * aa - at[k] * ab);
+		e1[k] = n <= 0 ? 0 : ptc_clamp255((n + det / 2) / det);
+	}
+	*c0 = ptc_to565(e0);
+	*c1 = ptc_to565(e1);
+	return 1;
+}
+
+/**
+ * Chooses starting endpoints from the block's bounding box, taking the
+ * diagonal that follows the colours and insetting it a little
+ */
+static void ptc_boxendpoints(const unsigned char *blk, int *c0, int *c1)
+{
+	int mn[3] = { 255, 255, 255 }, mx[3] = { 0, 0, 0 }, mean[3] = { 0, 0, 0 };
+	int cov[3] = { 0, 0, 0 }, e0[3], e1[3], i, k, ref, inset;
+
+	for (i = 0; i < 16; i++) {
+		for (k = 0; k < 3; k++) {
+			mn[k] = min(mn[k], blk[i * 4 + k]);
+			mx[k] = max(mx[k], blk[i * 4 + k]);
+			mean[k] += blk[i * 4 + k];
+		}
+	}
+
+	ref = 0;
+	for (k = 1; k < 3; k++) {
+		if (mx[k] - mn[k] > mx[ref] - mn[ref]) ref = k;
+	}
+	for (i = 0; i < 16; i++) {
+		for (k = 0; k < 3; k++) {
+			cov[k] += (blk[i * 4 + k] * 16 - mean[k]) * (blk[i * 4 + ref] * 16 - mean[ref]);
+		}
+	}
+
+	for (k = 0; k < 3; k++) {
+		inset = (mx[k] - mn[k]) >> 4;
+		e0[k] = mx[k] - inset;
+		e1[k] = mn[k] + inset;
+		if (cov[k] < 0) {
+			inset = e0[k]; e0[k] = e1[k]; e1[k] = inset;
+		}
+	}
+	*c0 = ptc_to565(e0);
+	*c1 = ptc_to565(e1);
+}
+
+/**
+ * Chooses starting endpoints as the pixels furthest apart along the
+ * block's principal axis
+ */
+static void ptc_pcaendpoints(const unsigned char *blk, int *c0, int *c1)
+{
+	float mean[3] = { 0.f, 0.f, 0.f }, cov[6] = { 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+	float v[3], w[3], d[3], m;
+	int mn[3] = { 255, 255, 255 }, mx[3] = { 0, 0, 0 };
+	int dots[16], axis[3], e0[3], e1[3], i, k, lo, hi;
+
+	for (i = 0; i < 16; i++) {
+		for (k = 0; k < 3; k++) {
+			mean[k] += blk[i * 4 + k];
+			mn[k] = min(mn[k], blk[i * 4 + k]);
+			mx[k] = max(mx[k], blk[i * 4 + k]);
+		}
+	}
+	for (k = 0; k < 3; k++) {
+		mean[k] *= 1.f / 16.f;
+	}
+	for (i = 0; i < 16; i++) {
+		for (k = 0; k < 3; k++) {
+			d[k] = blk[i * 4 + k] - mean[k];
+		}
+		cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+	}
+
+	// power iteration from the bounding box diagonal
+	for (k = 0; k < 3; k++) {
+		v[k] = (float)(mx[k] - mn[k]);
+	}
+	for (i = 0; i < 4; i++) {
+		w[0] = v[0] * cov[0] + v[1] * cov[1] + v[2] * cov[2];
+		w[1] = v[0] * cov[1] + v[1] * cov[3] + v[2] * cov[4];
+		w[2] = v[0] * cov[2] + v[1] * cov[4] + v[2] * cov[5];
+		m = max(fabsf(w[0]), max(fabsf(w[1]), fabsf(w[2])));
+		if (m < 1e-6f) {
+			break;
+		}
+		for (k = 0; k < 3; k++) {
+			v[k] = w[k] / m;
+		}
+	}
+
+	m = max(fabsf(v[0]), max(fabsf(v[1]), fabsf(v[2])));
+	if (m < 1e-6f) {
+		// flat block, or one whose colours cancel out: use luminance
+		axis[0] = 29; axis[1] = 150; axis[2] = 77;
+	} else {
+		for (k = 0; k < 3; k++) {
+			axis[k] = (int)(v[k] * 255.f / m);
+		}
+	}
+
+	ptc_dots(blk, axis[0], axis[1], axis[2], dots);
+	lo = hi = 0;
+	for (i = 1; i < 16; i++) {
+		if (dots[i] < dots[lo]) lo = i;
+		if (dots[i] > dots[hi]) hi = i;
+	}
+	for (k = 0; k < 3; k++) {
+		e0[k] = blk[hi * 4 + k];
+		e1[k] = blk[lo * 4 + k];
+	}
+	*c0 = ptc_to565(e0);
+	*c1 = ptc_to565(e1);
+}
+
+/**
+ * Encodes the colours of a block into an 8-byte DXT colour block,
+ * always in four-colour mode
+ */
+static void ptc_encodecolours(const unsigned char *blk, unsigned char *out, int quality)
+{
+	int c0, c1, t0, t1, err, terr, pass;
+	unsigned int indices, tindices;
+
+	if (quality > 0) {
+		ptc_pcaendpoints(blk, &c0, &c1);
+	} else {
+		ptc_boxendpoints(blk, &c0, &c1);
+	}
+	indices = ptc_matchcolours(blk, c0, c1);
+
+	if (quality > 0) {
+		err = ptc_colourerror(blk, c0, c1, indices);
+		for (pass = (quality > 1) ? 8 : 1; pass > 0 && err > 0; pass--) {
+			t0 = c0; t1 = c1;
+			if (!ptc_refinecolours(blk, indices, &t0, &t1)) {
+				break;
+			}
+			tindices = ptc_matchcolours(blk, t0, t1);
+			terr = ptc_colourerror(blk, t0, t1, tindices);
+			if (terr >= err) {
+				break;
+			}
+			c0 = t0; c1 = t1; indices = tindices; err = terr;
+		}
+	}
+
+	// c0 > c1 selects four-colour mode; swapping the endpoints swaps
+	// indices 0<->1 and 2<->3
+	if (c0 < c1) {
+		t0 = c0; c0 = c1; c1 = t0;
+		indices ^= 0x55555555;
+	} else if (c0 == c1) {
+		indices = 0;
+	}
+
+	out[0] = c0 & 255; out[1] = c0 >> 8;
+	out[2] = c1 & 255; out[3] = c1 >> 8;
+	out[4] = indices & 255; out[5] = (indices >> 8) & 255;
+	out[6] = (indices >> 16) & 255; out[7] = indices >> 24;
+}
+
+/**
+ * Indexes each pixel's alpha against a DXT5 alpha palette
+ * @return the squared error, with the 48 bits of indices in *bits
+ */
+static int ptc_matchalpha(const unsigned char *blk, int a0, int a1, uint64_t *bits)
+{
+	int pal[8], i, k, best, d, bestd, err = 0;
+
+	pal[0] = a0;
+	pal[1] = a1;
+	if (a0 > a1) {
+		for (k = 1; k < 7; k++) {
+			pal[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+		}
+	} else {
+		for (k = 1; k < 5; k++) {
+			pal[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+		}
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+
+	*bits = 0;
+	for (i = 15; i >= 0; i--) {
+		best = 0;
+		bestd = 256;
+		for (k = 0; k < 8; k++) {
+			d = abs(blk[i * 4 + 3] - pal[k]);
+			if (d < bestd) {
+				bestd = d;
+				best = k;
+			}
+		}
+		*bits = (*bits << 3) | best;
+		err += bestd * bestd;
+	}
+	return err;
+}
+
+/**
+ * Encodes the alpha of a block into an 8-byte DXT5 alpha block
+ */
+static void ptc_encodealpha(const unsigned char *blk, unsigned char *out, int quality)
+{
+	int mn = 255, mx = 0, imn = 255, imx = 0, i, a, a0, a1, err;
+	uint64_t bits, tbits;
+
+	for (i = 0; i < 16; i++) {
+		a = blk[i * 4 + 3];
+		mn = min(mn, a);
+		mx = max(mx, a);
+		if (a > 0 && a < 255) {
+			imn = min(imn, a);
+			imx = max(imx, a);
+		}
+	}
+
+	// eight interpolated values between the extremes
+	a0 = mx; a1 = mn;
+	err = ptc_matchalpha(blk, a0, a1, &bits);
+
+	// or six between the inner values, with exact 0 and 255 for cutouts
+	if (quality > 0 && err > 0 && (mn == 0 || mx == 255)) {
+		if (imn > imx) {
+			imn = imx = 0;
+		}
+		if (ptc_matchalpha(blk, imn, imx, &tbits) < err) {
+			a0 = imn; a1 = imx; bits = tbits;
+		}
+	}
+
+	out[0] = a0;
+	out[1] = a1;
+	for (i = 2; i < 8; i++, bits >>= 8) {
+		out[i] = (unsigned char)(bits & 255);
+	}
+}
+
+/**
+ * Finds the best modifier table and selectors for one ETC1 subblock
+ * @param blk the BGRA block
+ * @param flip !0 for 4x2 subblocks, 0 for 2x4
+ * @param sub which subblock
+ * @param base the subblock's decoded base colour
+ * @param table receives the table codeword
+ * @param selectors accumulates the pixel index bits
+ * @return the squared error
+ */
+static int ptc_etc1subblock(const unsigned char *blk, int flip, int sub, const int *base,
+		int *table, unsigned int *selectors)
+{
+	int t, i, x, y, s, k, d, e, beste, err, besterr = 0x7fffffff;
+	int sel[8], tsel[8];
+	unsigned int bits;
+
+	for (t = 0; t < 8; t++) {
+		err = 0;
+		for (i = 0; i < 8 && err < besterr; i++) {
+			x = flip ? (i & 3) : (sub * 2 + (i >> 2));
+			y = flip ? (sub * 2 + (i >> 2)) : (i & 3);
+			beste = 0x7fffffff;
+			for (s = 0; s < 4; s++) {
+				// selector 0: +a, 1: +b, 2: -a, 3: -b
+				d = (s & 2) ? -etc1modifiers[t][s & 1] : etc1modifiers[t][s & 1];
+				e = 0;
+				for (k = 0; k < 3; k++) {
+					e += (ptc_clamp255(base[k] + d) - blk[(y * 4 + x) * 4 + k]) *
+					     (ptc_clamp255(base[k] + d) - blk[(y * 4 + x) * 4 + k]);
+				}
+				if (e < beste) {
+					beste = e;
+					tsel[i] = s;
+				}
+			}
+			err += beste;
+		}
+		if (err < besterr) {
+			besterr = err;
+			*table = t;
+			memcpy(sel, tsel, sizeof(sel));
+		}
+	}
+
+	for (i = 0; i < 8; i++) {
+		x = flip ? (i & 3) : (sub * 2 + (i >> 2));
+		y = flip ? (sub * 2 + (i >> 2)) : (i & 3);
+		bits = (x * 4 + y);
+		*selectors |= ((unsigned int)(sel[i] & 1) << bits) | ((unsigned int)(sel[i] >> 1) << (bits + 16));
+	}
+	return besterr;
+}
+
+/**
+ * Encodes a subblock pair with given quantised base colours
+ * @param diff !0 for 5-bit base plus 3-bit delta, 0 for two 4-bit bases
+ * @param q the quantised bases, BGR for subblock 0 then subblock 1
+ * @return the squared error, with the block in *hi and *lo
+ */
+static int ptc_etc1try(const unsigned char *blk, int flip, int diff, const int q[2][3],
+		unsigned int *hi, unsigned int *lo)
+{
+	int base[2][3], table[2], err, k, s;
+
+	for (s = 0; s < 2; s++) {
+		for (k = 0; k < 3; k++) {
+			base[s][k] = diff ? ((q[s][k] << 3) | (q[s][k] >> 2)) : (q[s][k] * 17);
+		}
+	}
+
+	*lo = 0;
+	err = ptc_etc1subblock(blk, flip, 0, base[0], &table[0], lo);
+	err += ptc_etc1subblock(blk, flip, 1, base[1], &table[1], lo);
+
+	if (diff) {
+		*hi = ((unsigned int)q[0][2] << 27) | (((q[1][2] - q[0][2]) & 7) << 24) |
+		      (q[0][1] << 19) | (((q[1][1] - q[0][1]) & 7) << 16) |
+		      (q[0][0] << 11) | (((q[1][0] - q[0][0]) & 7) << 8) | 2;
+	} else {
+		*hi = ((unsigned int)q[0][2] << 28) | (q[1][2] << 24) |
+		      (q[0][1] << 20) | (q[1][1] << 16) |
+		      (q[0][0] << 12) | (q[1][0] << 8);
+	}
+	*hi |= (table[0] << 5) | (table[1] << 2) | (flip ? 1 : 0);
+	return err;
+}
+
+/**
+ * Encodes a block into an 8-byte ETC1 block
+ */
+static void ptc_encodeetc1(const unsigned char *blk, unsigned char *out, int quality)
+{
+	int flip, s, k, i, x, y, j, jmin, jmax, diffok, err, besterr = 0x7fffffff;
+	int avg[2][3], q[2][3];
+	unsigned int hi, lo, besthi = 0, bestlo = 0;
+
+	for (flip = 0; flip < 2; flip++) {
+		for (s = 0; s < 2; s++) {
+			avg[s][0] = avg[s][1] = avg[s][2] = 0;
+			for (i = 0; i < 8; i++) {
+				x = flip ? (i & 3) : (s * 2 + (i >> 2));
+				y = flip ? (s * 2 + (i >> 2)) : (i & 3);
+				for (k = 0; k < 3; k++) {
+					avg[s][k] += blk[(y * 4 + x) * 4 + k];
+				}
+			}
+			for (k = 0; k < 3; k++) {
+				avg[s][k] = (avg[s][k] + 4) >> 3;
+			}
+		}
+
+		jmin = (quality > 1) ? -1 : 0;
+		jmax = (quality > 1) ? 1 : 0;
+
+		// differential: 5-bit bases no more than 4 steps apart
+		for (j = jmin; j <= jmax; j++) {
+			diffok = 1;
+			for (s = 0; s < 2; s++) {
+				for (k = 0; k < 3; k++) {
+					q[s][k] = (avg[s][k] * 31 + 127) / 255 + j;
+					if (q[s][k] < 0 || q[s][k] > 31) diffok = 0;
+				}
+			}
+			for (k = 0; k < 3; k++) {
+				if (q[1][k] - q[0][k] < -4 || q[1][k] - q[0][k] > 3) diffok = 0;
+			}
+			if (!diffok) {
+				continue;
+			}
+			err = ptc_etc1try(blk, flip, 1, q, &hi, &lo);
+			if (err < besterr) {
+				besterr = err; besthi = hi; bestlo = lo;
+			}
+		}
+		if (quality == 0 && besterr != 0x7fffffff) {
+			continue;
+		}
+
+		// individual: independent 4-bit bases
+		for (j = jmin; j <= jmax; j++) {
+			for (s = 0; s < 2; s++) {
+				for (k = 0; k < 3; k++) {
+					q[s][k] = (avg[s][k] * 15 + 127) / 255 + j;
+					q[s][k] = q[s][k] < 0 ? 0 : (q[s][k] > 15 ? 15 : q[s][k]);
+				}
+			}
+			err = ptc_etc1try(blk, flip, 0, q, &hi, &lo);
+			if (err < besterr) {
+				besterr = err; besthi = hi; bestlo = lo;
+			}
+		}
+	}
+
+	out[0] = besthi >> 24; out[1] = (besthi >> 16) & 255;
+	out[2] = (besthi >> 8) & 255; out[3] = besthi & 255;
+	out[4] = bestlo >> 24; out[5] = (bestlo >> 16) & 255;
+	out[6] = (bestlo >> 8) & 255; out[7] = bestlo & 255;
+}
+
+int ptcompress_getstorage(int width, int height, int format)
+{
+	int blocks = ((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format) {
+		case PTCOMPRESS_DXT1:
+		case PTCOMPRESS_ETC1:
+			return blocks * 8;
+		case PTCOMPRESS_DXT5:
+			return blocks * 16;
+		default:
+			return 0;
+	}
+}
+
+int ptcompress_compress(void * pixels, int width, int height, unsigned char * output, int format, int rgba)
+{
+	unsigned char blk[16 * 4];
+	int bx, by, quality;
+
+	if (format != PTCOMPRESS_DXT1 && format != PTCOMPRESS_DXT5 && format != PTCOMPRESS_ETC1) {
+		return -1;
+	}
+	quality = max(0, min(2, gltexcomprquality));
+
+	for (by = 0; by < height; by += 4) {
+		for (bx = 0; bx < width; bx += 4) {
+			ptc_fetchblock((const unsigned char *) pixels, width, height, bx, by, rgba, blk);
+			switch (format) {
+				case PTCOMPRESS_DXT1:
+					ptc_encodecolours(blk, output, quality);
+					output += 8;
+					break;
+				case PTCOMPRESS_DXT5:
+					ptc_encodealpha(blk, output, quality);
+					ptc_encodecolours(blk, output + 8, quality);
+					output += 16;
+					break;
+				case PTCOMPRESS_ETC1:
+					ptc_encodeetc1(blk, output, quality);
+					output += 8;
+					break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+#endif //USE_POLYMOST && USE_OPENGL
@@ -19,7 +19,8 @@ enum {
 	PTCOMPRESS_ETC1 = 3,
 };
 int ptcompress_getstorage(int width, int height, int format);
-int ptcompress_compress(void * bgra, int width, int height, unsigned char * output, int format);
+// pixels are BGRA, or RGBA when rgba is !0
+int ptcompress_compress(void * pixels, int width, int height, unsigned char * output, int format, int rgba);
 
 #ifdef __cplusplus
 }
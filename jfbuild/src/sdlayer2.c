@@ -347,6 +347,10 @@ int initsystem(void)
 	// Xbox: our internal GL shim is always available.
 	glunavailable = 0;
 	buildputs("Xbox: GL shim (NV2A pbkit) available.\n");
+#elif defined(GLBUILD_NULL)
+	// glbuild_null.c records OpenGL calls and discards them.
+	glunavailable = 0;
+	buildputs("OpenGL calls will be recorded and discarded.\n");
 #else
 	if (getenv("BUILD_NOGL")) {
 		buildputs("OpenGL disabled.\n");
@@ -735,6 +739,97 @@ int gettimerfreq(void)
 
 
 
+//
+//
+// ---------------------------------------
+//
+// All things Threads
+//
+// ---------------------------------------
+//
+//
+
+struct bthreadstart {
+	int (*func)(void *);
+	void *arg;
+	int lowpriority;
+};
+
+static int bthreadthunk(void *arg)
+{
+	struct bthreadstart start = *(struct bthreadstart *)arg;
+
+	free(arg);
+	if (start.lowpriority) SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+	return start.func(start.arg);
+}
+
+//
+// bthread_create() -- start a thread running func(arg), or NULL on failure
+//
+void *bthread_create(int (*func)(void *), void *arg, int lowpriority)
+{
+	struct bthreadstart *start;
+	SDL_Thread *thread;
+
+	start = (struct bthreadstart *)malloc(sizeof(struct bthreadstart));
+	if (!start) return NULL;
+
+	start->func = func;
+	start->arg = arg;
+	start->lowpriority = lowpriority;
+
+	thread = SDL_CreateThread(bthreadthunk, "bthread", start);
+	if (!thread) {
+		free(start);
+		return NULL;
+	}
+
+	return thread;
+}
+
+//
+// bthread_wait() -- wait for a thread to finish and return its result
+//
+int bthread_wait(void *thread)
+{
+	int status = 0;
+
+	if (thread) SDL_WaitThread((SDL_Thread *)thread, &status);
+	return status;
+}
+
+//
+// bthread_cpucount() -- how many processors there are to run threads on
+//
+int bthread_cpucount(void)
+{
+	return max(1, SDL_GetCPUCount());
+}
+
+void *bmutex_create(void)
+{
+	return SDL_CreateMutex();
+}
+
+void bmutex_destroy(void *mutex)
+{
+	if (mutex) SDL_DestroyMutex((SDL_mutex *)mutex);
+}
+
+void bmutex_lock(void *mutex)
+{
+	SDL_LockMutex((SDL_mutex *)mutex);
+}
+
+void bmutex_unlock(void *mutex)
+{
+	SDL_UnlockMutex((SDL_mutex *)mutex);
+}
+
+
+
 //
 //
 // ---------------------------------------
@@ -1058,7 +1153,7 @@ int setvideomode(int xdim, int ydim, int bitspp, int fullsc)
 	do {
 		flags = SDL_WINDOW_HIDDEN;
 
-#if USE_OPENGL && !defined(_XBOX)
+#if USE_OPENGL && !defined(_XBOX) && !defined(GLBUILD_NULL)
 		if (!glunavailable) {
 #if (USE_OPENGL == USE_GLES2)
 			SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
@@ -1202,8 +1297,8 @@ int setvideomode(int xdim, int ydim, int bitspp, int fullsc)
 			// Prepare the GLSL shader for 8-bit blitting.
 			int winx = xdim, winy = ydim;
 
-#ifdef _XBOX
-			// Xbox: no real GL context — glbuild_xbox.c provides our shim.
+#if defined(_XBOX) || defined(GLBUILD_NULL)
+			// No real GL context — glbuild_xbox.c or glbuild_null.c provides our shim.
 			if (glbuild_init()) {
 				glunavailable = 1;
 			} else {
@@ -1259,6 +1354,11 @@ int setvideomode(int xdim, int ydim, int bitspp, int fullsc)
 			return -1;
 		}
 		xbox_pbkit_init_for_polymost();
+#elif defined(GLBUILD_NULL)
+		if (glbuild_init()) {
+			shutdownvideo();
+			return -1;
+		}
 #else
 		sdl_glcontext = SDL_GL_CreateContext(sdl_window);
 		if (!sdl_glcontext) {
@@ -1393,7 +1493,11 @@ void showframe(void)
 			glbuild_draw_8bit_frame(&gl8bit);
 		}
 
+#ifdef GLBUILD_NULL
+		glbuild_null_endframe();
+#else
 		SDL_GL_SwapWindow(sdl_window);
+#endif
 		return;
 #endif
 	}
@@ -1542,11 +1646,13 @@ int setsysgamma(float shadergamma, float sysgamma)
 //
 // loadgldriver -- loads an OpenGL DLL
 //
-#ifdef _XBOX
+#if defined(_XBOX) || defined(GLBUILD_NULL)
 int loadgldriver(const char *soname)
 {
 	(void)soname;
+#ifdef _XBOX
 	buildputs("Xbox: GL driver loaded (internal shim)\n");
+#endif
 	return 0;
 }
 
@@ -1587,7 +1693,7 @@ void *getglprocaddress(const char *name, int ext)
 	(void)ext;
 	return (void*)SDL_GL_GetProcAddress(name);
 }
-#endif // _XBOX
+#endif // _XBOX || GLBUILD_NULL
 #endif
 
 
@@ -1030,6 +1030,99 @@ int gettimerfreq(void)
 
 
 
+//-------------------------------------------------------------------------------------------------
+//  THREADS
+//=================================================================================================
+
+struct bthreadstart {
+	int (*func)(void *);
+	void *arg;
+};
+
+static DWORD WINAPI bthreadthunk(LPVOID arg)
+{
+	struct bthreadstart start = *(struct bthreadstart *)arg;
+
+	free(arg);
+	return (DWORD)start.func(start.arg);
+}
+
+//
+// bthread_create() -- start a thread running func(arg), or NULL on failure
+//
+void *bthread_create(int (*func)(void *), void *arg, int lowpriority)
+{
+	struct bthreadstart *start;
+	HANDLE thread;
+
+	start = (struct bthreadstart *)malloc(sizeof(struct bthreadstart));
+	if (!start) return NULL;
+
+	start->func = func;
+	start->arg = arg;
+
+	thread = CreateThread(NULL, 0, bthreadthunk, start, 0, NULL);
+	if (!thread) {
+		free(start);
+		return NULL;
+	}
+	if (lowpriority) SetThreadPriority(thread, THREAD_PRIORITY_BELOW_NORMAL);
+
+	return thread;
+}
+
+//
+// bthread_wait() -- wait for a thread to finish and return its result
+//
+int bthread_wait(void *thread)
+{
+	DWORD status = 0;
+
+	if (!thread) return 0;
+	WaitForSingleObject((HANDLE)thread, INFINITE);
+	GetExitCodeThread((HANDLE)thread, &status);
+	CloseHandle((HANDLE)thread);
+
+	return (int)status;
+}
+
+//
+// bthread_cpucount() -- how many processors there are to run threads on
+//
+int bthread_cpucount(void)
+{
+	SYSTEM_INFO si;
+
+	GetSystemInfo(&si);
+	return max(1, (int)si.dwNumberOfProcessors);
+}
+
+void *bmutex_create(void)
+{
+	CRITICAL_SECTION *cs = (CRITICAL_SECTION *)malloc(sizeof(CRITICAL_SECTION));
+	if (cs) InitializeCriticalSection(cs);
+	return cs;
+}
+
+void bmutex_destroy(void *mutex)
+{
+	if (!mutex) return;
+	DeleteCriticalSection((CRITICAL_SECTION *)mutex);
+	free(mutex);
+}
+
+void bmutex_lock(void *mutex)
+{
+	EnterCriticalSection((CRITICAL_SECTION *)mutex);
+}
+
+void bmutex_unlock(void *mutex)
+{
+	LeaveCriticalSection((CRITICAL_SECTION *)mutex);
+}
+
+
+
 
 //-------------------------------------------------------------------------------------------------
 //  VIDEO
@@ -47,6 +47,9 @@ extern "C" {
 #define SCRIPTSPACE     (' ')
 #define SCRIPTDEFAULTVALUE ('~')
 #define MAXSCRIPTFILES 20
+#define SCRIPTHASHSIZE 64	// buckets for section and entry names, power of two
+#define SCRIPTFLAG_NAMEINBUFFER  1	// name points into a parsed buffer, not strdup'd
+#define SCRIPTFLAG_VALUEINBUFFER 2	// likewise the value
 #define SCRIPT(scripthandle,item) (scriptfiles[(scripthandle)]->item)
 
 typedef enum
@@ -70,6 +73,8 @@ typedef struct scriptentry
    char * value;
    struct scriptentry *nextentry;
    struct scriptentry *preventry;
+   struct scriptentry *hashnext;
+   uint8 flags;
    } ScriptEntryType;
 
 typedef struct scriptsection
@@ -79,6 +84,13 @@ typedef struct scriptsection
    ScriptLineType       *lastline;
    struct scriptsection *nextsection;
    struct scriptsection *prevsection;
+   struct scriptsection *hashnext;
+   ScriptEntryType      *lastentry;
+   ScriptEntryType      *entryhash[SCRIPTHASHSIZE];
+   ScriptEntryType      *cursorentry;	// where SCRIPT_Entry last stopped
+   int32                 cursorwhich;
+   int32                 numentries;
+   uint8 flags;
    } ScriptSectionType;
 
 typedef struct
@@ -87,6 +99,12 @@ typedef struct
    ScriptSectionType * lastsection;
    ScriptLineType * scriptlines;
    char scriptfilename[128];
+   ScriptSectionType * sectionhash[SCRIPTHASHSIZE];
+   ScriptSectionType * cursorsection;	// where SCRIPT_Section last stopped
+   int32 cursorwhich;
+   int32 numsections;
+   char ** buffers;	// parsed files, which names and values may point into
+   int32 numbuffers;
    } script_t;
 
 /*
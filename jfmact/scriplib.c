@@ -54,6 +54,16 @@ static script_t *scriptfiles[MAXSCRIPTFILES];
 #define SC(s) scriptfiles[s]
 
 
+static uint32 SCRIPT_Hash(const char *name)
+{
+	uint32 h = 0;
+
+	for (; *name; name++)
+		h = h * 31 + (uint32)tolower((uint8)*name);
+
+	return h & (SCRIPTHASHSIZE-1);
+}
+
 int32 SCRIPT_New(void)
 {
 	int32 i;
@@ -73,6 +83,7 @@ int32 SCRIPT_New(void)
 void SCRIPT_Delete(int32 scripthandle)
 {
 	ScriptSectionType *s;
+	int32 i;
 	
 	if (scripthandle < 0 || scripthandle >= MAXSCRIPTFILES) return;
 
@@ -86,9 +97,14 @@ void SCRIPT_Delete(int32 scripthandle)
 			SCRIPT(scripthandle,script) = s;
 		}
 
+		SCRIPT_FreeSection(SCRIPT(scripthandle,script));
 		SafeFree(SCRIPT(scripthandle,script));
 	}
 
+	for (i=0; i<SCRIPT(scripthandle,numbuffers); i++)
+		SafeFree(SCRIPT(scripthandle,buffers)[i]);
+	if (SCRIPT(scripthandle,buffers)) SafeFree(SCRIPT(scripthandle,buffers));
+
 	SafeFree(SC(scripthandle));
 	SC(scripthandle) = 0;
 }
@@ -98,54 +114,78 @@ void SCRIPT_FreeSection(ScriptSectionType * section)
 	ScriptEntryType *e;
 		
 	if (!section) return;
-	if (!section->entries) return;
 
-	while (section->entries->nextentry != section->entries) {
+	while (section->entries) {
 		e = section->entries->nextentry;
+		if (!(section->entries->flags & SCRIPTFLAG_NAMEINBUFFER)) free(section->entries->name);
+		if (!(section->entries->flags & SCRIPTFLAG_VALUEINBUFFER)) free(section->entries->value);
 		SafeFree(section->entries);
-		section->entries = e;
+		section->entries = (e != section->entries) ? e : NULL;
 	}
 
-	SafeFree(section->entries);
-	free(section->name);
+	if (!(section->flags & SCRIPTFLAG_NAMEINBUFFER)) free(section->name);
 }
 
 #define AllocSection(s) \
 	{ \
 		(s) = SafeMalloc(sizeof(ScriptSectionType)); \
-		(s)->name = NULL; \
-		(s)->entries = NULL; \
-		(s)->lastline = NULL; \
+		memset((s), 0, sizeof(ScriptSectionType)); \
 		(s)->nextsection = (s); \
 		(s)->prevsection = (s); \
 	}
 #define AllocEntry(e) \
 	{ \
 		(e) = SafeMalloc(sizeof(ScriptEntryType)); \
-		(e)->name = NULL; \
-		(e)->value = NULL; \
+		memset((e), 0, sizeof(ScriptEntryType)); \
 		(e)->nextentry = (e); \
 		(e)->preventry = (e); \
 	}
 
 ScriptSectionType * SCRIPT_SectionExists( int32 scripthandle, const char * sectionname )
 {
-	ScriptSectionType *s, *ls=NULL;
+	ScriptSectionType *s;
 
 	if (scripthandle < 0 || scripthandle >= MAXSCRIPTFILES) return NULL;
 	if (!sectionname) return NULL;
 	if (!SC(scripthandle)) return NULL;
-	if (!SCRIPT(scripthandle,script)) return NULL;
 
-	for (s = SCRIPT(scripthandle,script); ls != s; ls=s,s=s->nextsection)
+	for (s = SCRIPT(scripthandle,sectionhash)[SCRIPT_Hash(sectionname)]; s; s=s->hashnext)
 		if (!Bstrcasecmp(s->name, sectionname)) return s;
 
 	return NULL;
 }
 
+// Appends a section to the script. If 'flags' has SCRIPTFLAG_NAMEINBUFFER the
+// name is kept as given, otherwise it's copied.
+static ScriptSectionType * SCRIPT_NewSection( int32 scripthandle, char * sectionname, uint8 flags )
+{
+	ScriptSectionType *s;
+	uint32 h;
+
+	AllocSection(s);
+	s->name = (flags & SCRIPTFLAG_NAMEINBUFFER) ? sectionname : strdup(sectionname);
+	s->flags = flags;
+
+	if (!SCRIPT(scripthandle,script)) {
+		SCRIPT(scripthandle,script) = s;
+	} else {
+		SCRIPT(scripthandle,lastsection)->nextsection = s;
+		s->prevsection = SCRIPT(scripthandle,lastsection);
+	}
+	SCRIPT(scripthandle,lastsection) = s;
+	SCRIPT(scripthandle,numsections)++;
+	SCRIPT(scripthandle,cursorsection) = NULL;
+
+	h = SCRIPT_Hash(s->name);
+	s->hashnext = SCRIPT(scripthandle,sectionhash)[h];
+	SCRIPT(scripthandle,sectionhash)[h] = s;
+
+	return s;
+}
+
 ScriptSectionType * SCRIPT_AddSection( int32 scripthandle, const char * sectionname )
 {
-	ScriptSectionType *s,*s2;
+	ScriptSectionType *s;
 
 	if (scripthandle < 0 || scripthandle >= MAXSCRIPTFILES) return NULL;
 	if (!sectionname) return NULL;
@@ -154,247 +194,181 @@ ScriptSectionType * SCRIPT_AddSection( int32 scripthandle, const char * sectionn
 	s = SCRIPT_SectionExists(scripthandle, sectionname);
 	if (s) return s;
 	
-	AllocSection(s);
-	s->name = strdup(sectionname);
-	if (!SCRIPT(scripthandle,script)) {
-		SCRIPT(scripthandle,script) = s;
-	} else {
-		s2 = SCRIPT(scripthandle,script);
-		while (s2->nextsection != s2) s2=s2->nextsection;
-		s2->nextsection = s;
-		s->prevsection = s2;
-	}
-
-	return s;
+	return SCRIPT_NewSection(scripthandle, (char *)sectionname, 0);
 }
 
 ScriptEntryType * SCRIPT_EntryExists ( ScriptSectionType * section, const char * entryname )
 {
-	ScriptEntryType *e,*le=NULL;
+	ScriptEntryType *e;
 
 	if (!section) return NULL;
 	if (!entryname) return NULL;
-	if (!section->entries) return NULL;
 
-	for (e = section->entries; le != e; le=e,e=e->nextentry)
+	for (e = section->entryhash[SCRIPT_Hash(entryname)]; e; e=e->hashnext)
 		if (!Bstrcasecmp(e->name, entryname)) return e;
 
 	return NULL;
 }
 
-void SCRIPT_AddEntry ( int32 scripthandle, const char * sectionname, const char * entryname, const char * entryvalue )
+// Sets an entry of a section, appending it if it's new. 'flags' says whether
+// the name and value are kept as given or copied, as for SCRIPT_NewSection.
+static void SCRIPT_SetEntry( ScriptSectionType * s, char * entryname, char * entryvalue, uint8 flags )
 {
-	ScriptSectionType *s;
-	ScriptEntryType *e,*e2;
-
-	if (scripthandle < 0 || scripthandle >= MAXSCRIPTFILES) return;
-	if (!sectionname || !entryname || !entryvalue) return;
-	if (!SC(scripthandle)) return;
-
-//	s = SCRIPT_SectionExists(scripthandle, sectionname);
-//	if (!s) {
-		s = SCRIPT_AddSection(scripthandle, sectionname);
-		if (!s) return;
-//	}
+	ScriptEntryType *e;
+	uint32 h;
 
 	e = SCRIPT_EntryExists(s, entryname);
 	if (!e) {
 		AllocEntry(e);
-		e->name = strdup(entryname);
+		e->name = (flags & SCRIPTFLAG_NAMEINBUFFER) ? entryname : strdup(entryname);
+		e->flags = (flags & SCRIPTFLAG_NAMEINBUFFER) | SCRIPTFLAG_VALUEINBUFFER;
 		if (!s->entries) {
 			s->entries = e;
 		} else {
-			e2 = s->entries;
-			while (e2->nextentry != e2) e2=e2->nextentry;
-			e2->nextentry = e;
-			e->preventry = e2;
+			s->lastentry->nextentry = e;
+			e->preventry = s->lastentry;
 		}
+		s->lastentry = e;
+		s->numentries++;
+		s->cursorentry = NULL;
+
+		h = SCRIPT_Hash(e->name);
+		e->hashnext = s->entryhash[h];
+		s->entryhash[h] = e;
 	}
 
-	if (e->value) free(e->value);
-	e->value = strdup(entryvalue);
+	if (!(e->flags & SCRIPTFLAG_VALUEINBUFFER)) free(e->value);
+	if (flags & SCRIPTFLAG_VALUEINBUFFER) {
+		e->value = entryvalue;
+		e->flags |= SCRIPTFLAG_VALUEINBUFFER;
+	} else {
+		e->value = strdup(entryvalue);
+		e->flags &= ~SCRIPTFLAG_VALUEINBUFFER;
+	}
 }
 
+void SCRIPT_AddEntry ( int32 scripthandle, const char * sectionname, const char * entryname, const char * entryvalue )
+{
+	ScriptSectionType *s;
 
+	if (scripthandle < 0 || scripthandle >= MAXSCRIPTFILES) return;
+	if (!sectionname || !entryname || !entryvalue) return;
+	if (!SC(scripthandle)) return;
+
+	s = SCRIPT_AddSection(scripthandle, sectionname);
+	if (!s) return;
+
+	SCRIPT_SetEntry(s, (char *)entryname, (char *)entryvalue, 0);
+}
+
+
+// Parses a buffer in one pass, cutting the names and values out of it in place.
+// The script takes the buffer over and frees it in SCRIPT_Delete, so 'data'
+// must come from SafeMalloc and not be touched by the caller afterwards.
 int32 SCRIPT_ParseBuffer(int32 scripthandle, char *data, int32 length)
 {
-	char *fence = data + length;
-	char *dp, *sp, ch=0, lastch=0;
-	char *currentsection = "";
-	char *currententry = NULL;
-	char *currentvalue = NULL;
-	enum {
-		ParsingIdle,
-		ParsingSectionBegin,
-		ParsingSectionName,
-		ParsingEntry,
-		ParsingValueBegin,
-		ParsingValue
-	};
-	enum {
-		ExpectingSection = 1,
-		ExpectingEntry = 2,
-		ExpectingAssignment = 4,
-		ExpectingValue = 8,
-		ExpectingComment = 16
-	};
-	int state;
-	int expect;
+	char *fence, *p, *name, *value, *end, ch;
+	char *currentsection = NULL;
+	ScriptSectionType *section = NULL;
 	int linenum=1;
 	int rv = 0;
 #define SETRV(v) if (v>rv||rv==0) rv=v;
 
 	if (!data) return 1;
-	if (length < 0) return 1;
-	
-	dp = sp = data;
-	state = ParsingIdle;
-	expect = ExpectingSection | ExpectingEntry;
-
-#define EATLINE(p) while (length > 0 && *p != '\n' && *p != '\r') { p++; length--; }
-#define LETTER() { lastch = ch; ch = *(sp++); length--; }
-
-	while (length > 0) {
-		switch (state) {
-			case ParsingIdle:
-				LETTER();
-				switch (ch) {
-					// whitespace
-					case ' ':
-					case '\t': continue;
-					case '\n': if (lastch == '\r') continue; linenum++; continue;
-					case '\r': linenum++; continue;
-
-					case ';':
-					/*case '#':*/
-						  EATLINE(sp);
-						  continue;
-
-					case '[': if (!(expect & ExpectingSection)) {
-							  // Unexpected section start
-							  printf("Unexpected start of section on line %d.\n", linenum);
-							  SETRV(-1);
-							  EATLINE(sp);
-							  continue;
-						  } else {
-							  state = ParsingSectionBegin;
-							  continue;
-						  }
-
-					default:  if (isalpha(ch)) {
-							  if (!(expect & ExpectingEntry)) {
-								  // Unexpected name start
-								  printf("Unexpected entry label on line %d.\n", linenum);
-								  SETRV(-1);
-								  EATLINE(sp);
-								  continue;
-							  } else {
-								  currententry = dp = sp-1;
-								  state = ParsingEntry;
-								  continue;
-							  }
-						  } else {
-							  // Unexpected character
-							  printf("Illegal character (ASCII %d) on line %d.\n", ch, linenum);
-							  SETRV(-1);
-							  EATLINE(sp);
-							  continue;
-						  }
-				}
+	if (length < 0 || scripthandle < 0 || scripthandle >= MAXSCRIPTFILES || !SC(scripthandle)) {
+		SafeFree(data);
+		return 1;
+	}
 
-			case ParsingSectionBegin:
-				currentsection = dp = sp;
-				state = ParsingSectionName;
-				// fall through
-			case ParsingSectionName:
-				LETTER();
-				switch (ch) {
-					case '\n':
-					case '\r':	// Unexpected newline
-						printf("Unexpected newline on line %d.\n", linenum);
-						SETRV(-1);
-						state = ParsingIdle;
-						linenum++;
-						continue;
-
-					case ']':
-						*(dp) = 0;	// Add new section
-						expect = ExpectingSection | ExpectingEntry;
-						state = ParsingIdle;
-						EATLINE(sp);
-						continue;
-
-					default:
-						dp++;
-						continue;
+	SafeRealloc((void **)&SCRIPT(scripthandle,buffers), (SCRIPT(scripthandle,numbuffers)+1) * sizeof(char *));
+	SCRIPT(scripthandle,buffers)[ SCRIPT(scripthandle,numbuffers)++ ] = data;
+
+	p = data;
+	fence = data + length;
+
+#define EATLINE(p) while (p < fence && *p != '\n' && *p != '\r') p++;
+
+	while (p < fence) {
+		switch (*p) {
+			// whitespace
+			case ' ':
+			case '\t': p++; continue;
+			case '\r': if (p+1 < fence && p[1] == '\n') p++;
+				   // fall through
+			case '\n': p++; linenum++; continue;
+
+			case ';':
+			/*case '#':*/
+				   EATLINE(p);
+				   continue;
+
+			case '[':
+				name = ++p;
+				while (p < fence && *p != ']' && *p != '\n' && *p != '\r') p++;
+				if (p == fence) continue;
+				if (*p != ']') {
+					// Unexpected newline
+					printf("Unexpected newline on line %d.\n", linenum);
+					SETRV(-1);
+					continue;
 				}
-
-			case ParsingEntry:
-				LETTER();
-				switch (ch) {
-					case ';':
-					/*case '#':*/
-						// unexpected comment
-						EATLINE(sp);
-						printf("Unexpected comment on line %d.\n", linenum);
-						SETRV(-1);
-						state = ParsingIdle;
-						continue;
-
-					case '\n':
-					case '\r':
-						// Unexpected newline
-						printf("Unexpected newline on line %d.\n", linenum);
-						SETRV(-1);
-						expect = ExpectingSection | ExpectingEntry;
-						state = ParsingIdle;
-						linenum++;
-						continue;
-
-					case '=':
-						// Entry name finished, now for the value
-						while (*dp == ' ' || *dp == '\t') dp--;
-						*(++dp) = 0;
-						state = ParsingValueBegin;
-						continue;
-
-					default:
-						dp++;
-						continue;
+				*(p++) = 0;	// the section is added with its first entry
+				currentsection = name;
+				section = NULL;
+				EATLINE(p);
+				continue;
+
+			default:
+				if (!isalpha((uint8)*p)) {
+					// Unexpected character
+					printf("Illegal character (ASCII %d) on line %d.\n", *p, linenum);
+					SETRV(-1);
+					EATLINE(p);
+					continue;
 				}
+				break;
+		}
 
-			case ParsingValueBegin:
-				currentvalue = dp = sp;
-				state = ParsingValue;
-				// fall through
-			case ParsingValue:
-				LETTER();
-				switch (ch) {
-					case '\n':
-					case '\r':
-						// value complete, add it using parsed name
-						while (*dp == ' ' && *dp == '\t') dp--;
-						*(dp) = 0;
-						while (*currentvalue == ' ' || *currentvalue == '\t') currentvalue++;
-						state = ParsingIdle;
-						linenum++;
-
-						SCRIPT_AddSection(scripthandle,currentsection);
-						SCRIPT_AddEntry(scripthandle,currentsection,currententry,currentvalue);
-						continue;
-
-					default:
-						dp++;
-						continue;
-				}
+		name = p;
+		while (p < fence && *p != '=' && *p != ';' && *p != '\n' && *p != '\r') p++;
+		if (p == fence) continue;
+		if (*p == ';') {
+			// unexpected comment
+			EATLINE(p);
+			printf("Unexpected comment on line %d.\n", linenum);
+			SETRV(-1);
+			continue;
+		} else if (*p != '=') {
+			// Unexpected newline
+			printf("Unexpected newline on line %d.\n", linenum);
+			SETRV(-1);
+			continue;
+		}
 
-			default: length=0;
-				 continue;
+		// Entry name finished, now for the value
+		for (end = p; end > name && (end[-1] == ' ' || end[-1] == '\t'); end--) ;
+		*end = 0;
+
+		value = ++p;
+		EATLINE(p);
+		if (p == fence) continue;	// an unterminated last line is dropped
+
+		// value complete, add it using parsed name
+		ch = *p;
+		*(p++) = 0;
+		if (ch == '\r' && p < fence && *p == '\n') p++;
+		linenum++;
+		while (*value == ' ' || *value == '\t') value++;
+
+		if (!section && !currentsection) {
+			section = SCRIPT_AddSection(scripthandle, "");
+		} else if (!section) {
+			section = SCRIPT_SectionExists(scripthandle, currentsection);
+			if (!section) section = SCRIPT_NewSection(scripthandle, currentsection, SCRIPTFLAG_NAMEINBUFFER);
 		}
+		SCRIPT_SetEntry(section, name, value, SCRIPTFLAG_NAMEINBUFFER | SCRIPTFLAG_VALUEINBUFFER);
 	}
 
-	if (sp > fence) printf("Stepped outside the fence!\n");
-
 	return rv;
 }
 
@@ -439,17 +413,15 @@ int32 SCRIPT_Load ( const char * filename )
 		return -1;
 	}
 
-	SCRIPT_ParseBuffer(s,b,l);
-
-	SafeFree(b);
+	SCRIPT_ParseBuffer(s,b,l);	// takes over 'b'
 	
 	return s;
 }
 
 void SCRIPT_Save (int32 scripthandle, const char * filename)
 {
-	const char *section, *entry, *value;
-	int sec, ent, numsect, nument;
+	ScriptSectionType *s,*ls=NULL;
+	ScriptEntryType *e,*le;
 	FILE *fp;
 	
 
@@ -459,20 +431,14 @@ void SCRIPT_Save (int32 scripthandle, const char * filename)
 	fp = fopen(filename, "w");
 	if (!fp) return;
 
-	numsect = SCRIPT_NumberSections(scripthandle);
-	for (sec=0; sec<numsect; sec++) {
-		section = SCRIPT_Section(scripthandle, sec);
-		if (sec>0) fprintf(fp, "\n");
-		if (section[0] != 0)
-			fprintf(fp, "[%s]\n", section);
-
-		nument = SCRIPT_NumberEntries(scripthandle,section);
-		for (ent=0; ent<nument; ent++) {
-			entry = SCRIPT_Entry(scripthandle,section,ent);
-			value = SCRIPT_GetRaw(scripthandle,section,entry);
+	// walk the lists directly; they hold everything in the order it was added
+	for (s = SCRIPT(scripthandle,script); s && ls != s; ls=s,s=s->nextsection) {
+		if (ls) fprintf(fp, "\n");
+		if (s->name[0] != 0)
+			fprintf(fp, "[%s]\n", s->name);
 
-			fprintf(fp, "%s = %s\n", entry, value);
-		}
+		for (e = s->entries, le = NULL; e && le != e; le=e,e=e->nextentry)
+			fprintf(fp, "%s = %s\n", e->name, e->value);
 	}
 
 	fclose(fp);
@@ -480,25 +446,29 @@ void SCRIPT_Save (int32 scripthandle, const char * filename)
 
 int32 SCRIPT_NumberSections( int32 scripthandle )
 {
-	int32 c=0;
-	ScriptSectionType *s,*ls=NULL;
-
 	if (!SC(scripthandle)) return 0;
-	if (!SCRIPT(scripthandle,script)) return 0;
-
-	for (s = SCRIPT(scripthandle,script); ls != s; ls=s,s=s->nextsection) c++;
 
-	return c;
+	return SCRIPT(scripthandle,numsections);
 }
 
 char * SCRIPT_Section( int32 scripthandle, int32 which )
 {
 	ScriptSectionType *s,*ls=NULL;
+	int32 i = 0;
 
 	if (!SC(scripthandle)) return "";
 	if (!SCRIPT(scripthandle,script)) return ""; 
 
-	for (s = SCRIPT(scripthandle,script); which>0 && ls != s; ls=s, s=s->nextsection, which--) ;
+	// callers count upwards, so carry on from the last section asked for
+	s = SCRIPT(scripthandle,script);
+	if (SCRIPT(scripthandle,cursorsection) && which >= SCRIPT(scripthandle,cursorwhich)) {
+		s = SCRIPT(scripthandle,cursorsection);
+		i = SCRIPT(scripthandle,cursorwhich);
+	}
+	for (; i<which && ls != s; ls=s, s=s->nextsection, i++) ;
+
+	SCRIPT(scripthandle,cursorsection) = s;
+	SCRIPT(scripthandle,cursorwhich) = i;
 
 	return s->name;
 }
@@ -506,8 +476,6 @@ char * SCRIPT_Section( int32 scripthandle, int32 which )
 int32 SCRIPT_NumberEntries( int32 scripthandle, const char * sectionname )
 {
 	ScriptSectionType *s;
-	ScriptEntryType *e,*le=NULL;
-	int32 c=0;
 
 	if (!SC(scripthandle)) return 0;
 	if (!SCRIPT(scripthandle,script)) return 0;
@@ -515,22 +483,33 @@ int32 SCRIPT_NumberEntries( int32 scripthandle, const char * sectionname )
 	s = SCRIPT_SectionExists(scripthandle, sectionname);
 	if (!s) return 0;
 
-	for (e = s->entries; le != e; le=e,e=e->nextentry) c++;
-	return c;
+	return s->numentries;
 }
 
 const char * SCRIPT_Entry( int32 scripthandle, const char * sectionname, int32 which )
 {
 	ScriptSectionType *s;
 	ScriptEntryType *e,*le=NULL;
+	int32 i = 0;
 
 	if (!SC(scripthandle)) return 0;
 	if (!SCRIPT(scripthandle,script)) return 0;
 
 	s = SCRIPT_SectionExists(scripthandle, sectionname);
 	if (!s) return "";
+	if (!s->entries) return "";
+
+	// callers count upwards, so carry on from the last entry asked for
+	e = s->entries;
+	if (s->cursorentry && which >= s->cursorwhich) {
+		e = s->cursorentry;
+		i = s->cursorwhich;
+	}
+	for (; i<which && le != e; le=e, e=e->nextentry, i++) ;
+
+	s->cursorentry = e;
+	s->cursorwhich = i;
 
-	for (e = s->entries; which>0 && le != e; le=e, e=e->nextentry, which--) ;
 	return e->name;
 }
 
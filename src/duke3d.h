@@ -288,7 +288,6 @@ extern int movefifosendplc;
 typedef struct
 {
     char *ptr;
-    unsigned char lock;
     int  length, num;
 	 int numall;	// total number of this sound played in any way
 } SAMPLE;
@@ -42,12 +42,15 @@ extern void intomenusounds(void );
 extern void playmusic(char *fn);
 extern void stopmusic(void);
 extern char loadsound(unsigned short num);
+extern char precachesound(unsigned short num,int maxsize);
 extern int xyzsound(short num,short i,int x,int y,int z);
 extern void sound(short num);
 extern int spritesound(unsigned short num,short i);
 extern void stopsound(short num);
 extern void stopenvsound(short num,short i);
 extern void pan3dsound(void );
+extern void precachemusic(char *fn);
+extern void musicupdate(void);
 extern void testcallback(unsigned int num);
 extern void clearsoundlocks(void);
 extern short callsound(short sn,short whatsprite);
@@ -7670,6 +7670,39 @@ void compilecons(void)
     labeltype = NULL;
 }
 
+// Time taken by each stage of startup, reported once the game is ready to run
+static struct {
+    const char *name;
+    unsigned int ms;
+} startuptimes[20];
+static int numstartuptimes = 0;
+static unsigned int startupmark = 0;
+
+// Ends the stage of startup currently being timed and starts the next. A NULL
+// name drops the time since the last mark, such as waiting on the setup window.
+static void startuptime(const char *name)
+{
+    unsigned int now = getticks();
+
+    if (name && numstartuptimes < (int)(sizeof(startuptimes)/sizeof(startuptimes[0]))) {
+        startuptimes[numstartuptimes].name = name;
+        startuptimes[numstartuptimes].ms = now - startupmark;
+        numstartuptimes++;
+    }
+    startupmark = now;
+}
+
+static void startupreport(void)
+{
+    unsigned int total = 0;
+    int i;
+
+    for(i=0;i<numstartuptimes;i++) total += startuptimes[i].ms;
+    buildprintf("Startup took %ums:\n", total);
+    for(i=0;i<numstartuptimes;i++)
+        buildprintf("  %-20s %6ums\n", startuptimes[i].name, startuptimes[i].ms);
+}
+
 void Startup(void)
 {
     int i;
@@ -7691,11 +7724,13 @@ void Startup(void)
 #ifdef _XBOX
     xbox_log("DUKE3D: initengine done\n");
 #endif
+    startuptime("initengine");
 
 #ifdef _XBOX
     xbox_log("DUKE3D: compilecons\n");
 #endif
     compilecons();
+    startuptime("compilecons");
 #ifdef _XBOX
     xbox_log("DUKE3D: CONTROL_Startup\n");
 #endif
@@ -7745,6 +7780,7 @@ void Startup(void)
 
     CONTROL_JoystickEnabled = (UseJoystick && CONTROL_JoyPresent);
     CONTROL_MouseEnabled = (UseMouse && CONTROL_MousePresent);
+    startuptime("input");
 
 #ifdef _XBOX
     xbox_log("DUKE3D: inittimer\n");
@@ -7758,12 +7794,14 @@ void Startup(void)
     buildprintf("Loading art header.\n");
     if (loadpics("tiles000.art",MAXCACHE1DSIZE) < 0)
         gameexit("Failed loading art.");
+    startuptime("loadpics");
 
 #ifdef _XBOX
     xbox_log("DUKE3D: genspriteremaps\n");
 #endif
     buildprintf("Loading palette/lookups.\n");
     genspriteremaps();
+    startuptime("genspriteremaps");
 
 #ifdef _XBOX
     xbox_log("DUKE3D: readsavenames\n");
@@ -8003,7 +8041,9 @@ int app_main(int argc, char const * const argv[])
        exit(1);
     }
 
+    startuptime(NULL);
     configloaded = CONFIG_ReadSetup();
+    startuptime("CONFIG_ReadSetup");
     if (getenv("DUKE3DGRP")) {
         strncpy(duke3dgrp, getenv("DUKE3DGRP"), BMAX_PATH);
     }
@@ -8034,6 +8074,7 @@ int app_main(int argc, char const * const argv[])
     startwin_settings.input.controller = UseJoystick;
     startwin_settings.network.netoverride = netparam > 0;
     startwin_settings.alwaysshow = ForceSetup;
+    startuptime("startwin_scan_gamedata");
 
 #ifndef _XBOX
     if (configloaded < 0 || (ForceSetup && CommandSetup == 0) || (CommandSetup > 0)) {
@@ -8131,6 +8172,7 @@ int app_main(int argc, char const * const argv[])
 #endif /* !_XBOX */
 
     startwin_free_gamedata();
+    startuptime(NULL);
 
 #ifdef _XBOX
     xbox_log("DUKE3D: GRP=%s\n", duke3dgrp);
@@ -8170,6 +8212,7 @@ int app_main(int argc, char const * const argv[])
         free(CommandGrps);
         CommandGrps = s;
     }
+    startuptime("initgroupfile");
 
     RegisterShutdownFunction( Shutdown );
 
@@ -8217,7 +8260,9 @@ int app_main(int argc, char const * const argv[])
 #ifdef _XBOX
     xbox_log("DUKE3D: loaddefs\n");
 #endif
+    startuptime(NULL);
     if (!loaddefinitionsfile(duke3ddef)) buildprintf("Definitions file loaded.\n");
+    startuptime("loaddefinitionsfile");
 
     ud.multimode = numplayers;
     if (!netsuccess && numplayers == 1 && CommandFakeMulti) {
@@ -8252,6 +8297,7 @@ int app_main(int argc, char const * const argv[])
 #endif
    RTS_Init(ud.rtsname);
    if(numlumps) buildprintf("Using .RTS file:%s\n",ud.rtsname);
+   startuptime("RTS_Init");
 
 #ifdef _XBOX
     xbox_log("DUKE3D: setgamemode %dx%dx%d\n", ScreenWidth, ScreenHeight, ScreenBPP);
@@ -8276,6 +8322,7 @@ int app_main(int argc, char const * const argv[])
 #ifdef _XBOX
     xbox_log("DUKE3D: setgamemode done\n");
 #endif
+    startuptime("setgamemode");
     {
         // Send JFAudioLib output into the JFBuild console.
         extern void (*ASS_MessageOutputString)(const char *);
@@ -8307,6 +8354,7 @@ int app_main(int argc, char const * const argv[])
         xbox_log("DUKE3D: SoundStartup FXDevice=%d MusicDevice=%d\n", FXDevice, MusicDevice);
 #endif
         SoundStartup();
+        startuptime("SoundStartup");
 #ifdef _XBOX
         /* Play a test sound immediately after SoundStartup to verify the FX pipeline. */
         sound(EXITMENUSOUND);
@@ -8315,14 +8363,17 @@ int app_main(int argc, char const * const argv[])
 #endif
         buildprintf("Checking music inits.\n");
         MusicStartup();
+        startuptime("MusicStartup");
 #ifdef _XBOX
         xbox_log("DUKE3D: loadtmb\n");
 #endif
         loadtmb();
+        startuptime("loadtmb");
 #ifdef _XBOX
         xbox_log("DUKE3D: after loadtmb\n");
 #endif
     }
+    startupreport();
 
 if (VOLUMEONE) {
         if(numplayers > 4 || ud.multimode > 4)
@@ -8409,6 +8460,7 @@ if (VOLUMEONE) {
         }
 
         OSD_DispatchQueued();
+        musicupdate();
 
         if( ud.recstat == 2 || ud.multimode > 1 || ( ud.show_help == 0 && (ps[myconnectindex].gm&MODE_MENU) != MODE_MENU ) )
             if( ps[myconnectindex].gm&MODE_GAME )
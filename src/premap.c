@@ -240,29 +240,16 @@ void cachegoodsprites(void)
 
 char getsound(unsigned short num)
 {
-    short fp;
-    int   l;
-
     if(num >= NUM_SOUNDS || SoundToggle == 0) return 0;
     if (FXDevice < 0) return 0;
 
     if (!sounds[num][0]) return 0;
-    fp = kopen4load(sounds[num],loadfromgrouponly);
-    if(fp == -1) return 0;
-
-    l = kfilelength( fp );
-    soundsiz[num] = l;
 
-    if( (ud.level_number == 0 && ud.volume_number == 0 && (num == 189 || num == 232 || num == 99 || num == 233 || num == 17 ) ) ||
-        ( l < 12288 ) )
-    {
-        Sound[num].lock = 199;
-        allocache((void **)&Sound[num].ptr,l,&Sound[num].lock);
-        if(Sound[num].ptr != NULL)
-            kread( fp, Sound[num].ptr , l);
-    }
-    kclose( fp );
-    return 1;
+    // Prewarm the decoded sound cache with the short effects and the
+    // first level's ambience; everything else decodes on first play.
+    if( ud.level_number == 0 && ud.volume_number == 0 && (num == 189 || num == 232 || num == 99 || num == 233 || num == 17 ) )
+        return precachesound(num, 0x7fffffff);
+    return precachesound(num, 12288-1);
 }
 
 void precachenecessarysounds(void)
@@ -285,7 +272,8 @@ void precachenecessarysounds(void)
 void cacheit(void)
 {
     int i,j;
-    unsigned int starttime, endtime;
+    int tiledone = 0, tiletotal = 0, percent, lastpercent = -1, lastclock;
+    unsigned int starttime, endtime, tilestart, tiletime;
 
     starttime = getticks();
 #if USE_POLYMOST && USE_OPENGL
@@ -324,6 +312,31 @@ void cacheit(void)
         }
     }
 
+    // stream the tiles in from the ART files in file order, so that
+    // neighbouring tiles come in with one read
+    tilestart = getticks();
+    precachetiles_begin();
+    lastclock = totalclock;
+    while (precachetiles_run(&tiledone, &tiletotal)) {
+        handleevents();
+        getpackets();
+
+        if (totalclock - lastclock < TICRATE/10) {
+            continue;
+        }
+        percent = (int)((double)tiledone * 100.0 / (double)tiletotal);
+        if (percent == lastpercent) {
+            continue;
+        }
+
+        lastpercent = percent;
+        lastclock = totalclock;
+
+        sprintf(buf,"Loading art ... %d%%\n",percent);
+        dofrontscreens(buf);
+    }
+    tiletime = getticks() - tilestart;
+
 #if USE_POLYMOST && USE_OPENGL
     if (useprecache) {
         int cycles = 0;
@@ -362,6 +375,7 @@ void cacheit(void)
     }
 #endif
 
+    // anything the texture precache pushed out of the cache
     j = 0;
     for(i=0;i<MAXTILES;i++) {
         if(gotpic[i>>3] & pow2char[i&7]) {
@@ -377,7 +391,9 @@ void cacheit(void)
     clearbufbyte(gotpic,sizeof(gotpic),0L);
 
     endtime = getticks();
-    buildprintf("Cache time: %dms\n", endtime-starttime);
+    buildprintf("Cache time: %dms, art: %dKB in %dms (%.2f MB/s)\n",
+        endtime-starttime, tiletotal>>10, tiletime,
+        tiletime ? (double)tiletotal / 1048576.0 / ((double)tiletime / 1000.0) : 0.0);
 }
 
 
@@ -1412,7 +1428,7 @@ void resetmys(void)
 int enterlevel(unsigned char g)
 {
     short i;
-    int l;
+    int l, loadtime;
     char levname[BMAX_PATH+1], *path, *dot;
 
     if( (g&MODE_DEMO) != MODE_DEMO ) ud.recstat = ud.m_recstat;
@@ -1442,9 +1458,12 @@ int enterlevel(unsigned char g)
     else
         path = level_file_names[ (ud.volume_number*11)+ud.level_number];
 
+    loadtime = getticks();
     l = loadboard( path, VOLUMEONE, &ps[0].posx, &ps[0].posy, &ps[0].posz, &ps[0].ang,&ps[0].cursectnum );
     if(l == 0)
     {
+        buildprintf("Map %s loaded in %dms (%d sectors, %d walls)\n",
+            path, getticks()-loadtime, numsectors, numwalls);
         strcpy(levname, path);
 
         dot = Bstrrchr(levname,'.');
@@ -1484,6 +1503,11 @@ int enterlevel(unsigned char g)
     {
         music_select = (ud.volume_number*11) + ud.level_number;
         playmusic(&music_fn[0][music_select][0]);
+
+        // playmusic() has this level's song rendered if need be; have the
+        // next level's done in the background too
+        if(ud.level_number < 10)
+            precachemusic(&music_fn[0][music_select+1][0]);
     }
 
     if( (g&MODE_GAME) || (g&MODE_EOL) )
@@ -29,6 +29,7 @@ Modifications for JonoF's port by Jonathon Fowler (jf@jonof.id.au)
 #include <stdio.h>
 #include <string.h>
 #include "duke3d.h"
+#include "crc32.h"
 
 #ifdef RENDERTYPEWIN
 #include "winlayer.h"
@@ -50,6 +51,9 @@ static int MusicLen = 0;
 static int MusicVoice = -1;
 static int MusicPaused = 0;
 
+static void soundcache_flush(void);
+static void stopmusicrender(void);
+
 
 /*
 ===================
@@ -118,6 +122,8 @@ void SoundShutdown( void )
 	  sprintf(buf, "Sound shutdown error: %s", FX_ErrorString( FX_Error ));
       gameexit(buf);
    }
+
+   soundcache_flush();
 }
 
 /*
@@ -181,6 +187,7 @@ void MusicShutdown( void )
       return;
    
    stopmusic();
+   stopmusicrender();
    
    status = MUSIC_Shutdown();
    if ( status != MUSIC_Ok )
@@ -266,6 +273,337 @@ void intomenusounds(void)
     menunum %= 17;
 }
 
+/*
+===================
+=
+= Pre-rendered music
+=
+= MIDI songs are rendered to PCM by a low priority worker and kept on
+= disk under the CRC of the MIDI data. Once a song has been rendered it
+= plays as an ordinary looped voice, so no synth runs during the game.
+=
+= The song playing from a render and the one being rendered share a
+= memory budget. The worker renders no more than what is left of it, and
+= a render cut short by the budget is thrown away so the song carries on
+= through the MIDI driver rather than being cached truncated.
+=
+===================
+*/
+
+#define MUSICRENDERRATE 22050
+#define MUSICRENDERMAXSECONDS 300
+#define MUSICRENDERMINSECONDS 30    // don't start a render with less budget than this
+#define MUSICRENDERQUEUE 16
+#define MUSICRENDERBUDGET (8<<20)
+#define MUSICPRECACHED 64
+#define MUSICCACHEDIR "musiccache"
+
+typedef struct
+{
+    unsigned int crc;
+    char *data;
+    int len;
+} MUSICRENDERJOB;
+
+static MUSICRENDERJOB musicjobs[MUSICRENDERQUEUE];
+static int musicjobhead, musicjobcount;
+static void *musicjoblock = NULL;
+static void *musicworker = NULL;
+static volatile int musicworkerdone, musicworkercancel;
+static volatile unsigned int musicrendercount;
+static unsigned int MusicCRC;
+static int musicresident;   // bytes of MusicPtr that came from a render
+static int musicrendering;  // most bytes the worker's current render may take
+static unsigned int musicprecached[MUSICPRECACHED];    // CRCs of file names
+static int nummusicprecached;
+
+static void musiccachename(char *fn, int fnsiz, unsigned int crc, const char *ext)
+{
+    Bsnprintf(fn, fnsiz, MUSICCACHEDIR "/%08x.%s", crc, ext);
+}
+
+static int musicrenderthread(void *arg)
+{
+    MUSICRENDERJOB job;
+    char fn[BMAX_PATH], tmpfn[BMAX_PATH];
+    char *wave;
+    int wavelen, ok, seconds;
+    FILE *fp;
+
+    (void)arg;
+
+    while(1)
+    {
+        bmutex_lock(musicjoblock);
+        seconds = (MUSICRENDERBUDGET - musicresident) / (MUSICRENDERRATE*2);
+        if(seconds > MUSICRENDERMAXSECONDS) seconds = MUSICRENDERMAXSECONDS;
+        if(musicjobcount == 0 || musicworkercancel || seconds < MUSICRENDERMINSECONDS)
+        {
+            // jobs left for want of memory are picked up by musicupdate()
+            musicworkerdone = 1;
+            bmutex_unlock(musicjoblock);
+            return 0;
+        }
+        job = musicjobs[musicjobhead];
+        musicjobhead = (musicjobhead+1) % MUSICRENDERQUEUE;
+        musicjobcount--;
+        musicrendering = 44 + seconds * MUSICRENDERRATE * 2;
+        bmutex_unlock(musicjoblock);
+
+        ok = MUSIC_RenderSong(job.data, job.len, MUSICRENDERRATE, seconds,
+                              &musicworkercancel, &wave, &wavelen) == MUSIC_Ok;
+        if(ok && seconds < MUSICRENDERMAXSECONDS && wavelen >= musicrendering)
+        {
+            // cut short by the budget rather than by the song ending
+            free(wave);
+            ok = 0;
+        }
+
+        if(ok)
+        {
+            // write under a temporary name so a partial file is never picked up
+            musiccachename(fn, sizeof(fn), job.crc, "wav");
+            musiccachename(tmpfn, sizeof(tmpfn), job.crc, "tmp");
+
+            ok = 0;
+            fp = fopen(tmpfn, "wb");
+            if(fp)
+            {
+                ok = fwrite(wave, wavelen, 1, fp) == 1;
+                if(fclose(fp)) ok = 0;
+                if(ok) ok = rename(tmpfn, fn) == 0;
+                if(!ok) remove(tmpfn);
+            }
+            if(ok) musicrendercount++;
+            free(wave);
+        }
+        free(job.data);
+
+        bmutex_lock(musicjoblock);
+        musicrendering = 0;
+        bmutex_unlock(musicjoblock);
+    }
+}
+
+static char musicqueued(unsigned int crc)
+{
+    int i;
+
+    for(i=0;i<musicjobcount;i++)
+        if(musicjobs[(musicjobhead+i) % MUSICRENDERQUEUE].crc == crc) return 1;
+    return 0;
+}
+
+static void startmusicrender(void)
+{
+    if(musicworker)
+    {
+        if(!musicworkerdone) return;
+        bthread_wait(musicworker);
+    }
+    musicworkerdone = 0;
+    musicworkercancel = 0;
+    musicworker = bthread_create(musicrenderthread, NULL, 1);
+}
+
+static char musiccached(unsigned int crc)
+{
+    char fn[BMAX_PATH];
+    struct Bstat st;
+
+    musiccachename(fn, sizeof(fn), crc, "wav");
+    return Bstat(fn, &st) == 0;
+}
+
+/*
+ * Queues a copy of a MIDI song for the worker if it hasn't been
+ * rendered yet, starting the worker if it isn't running.
+ */
+static void queuemusicrender(char *song, int len, unsigned int crc)
+{
+    static char madedir = 0;
+    char *data;
+    int i, start;
+
+    if(musicjoblock)
+    {
+        bmutex_lock(musicjoblock);
+        i = musicqueued(crc);
+        bmutex_unlock(musicjoblock);
+        if(i) return;
+    }
+    if(musiccached(crc)) return;
+
+    if(!musicjoblock)
+    {
+        musicjoblock = bmutex_create();
+        if(!musicjoblock) return;
+    }
+    if(!madedir)
+    {
+        Bmkdir(MUSICCACHEDIR, S_IRWXU);
+        madedir = 1;
+    }
+
+    bmutex_lock(musicjoblock);
+    if(musicqueued(crc) || musicjobcount == MUSICRENDERQUEUE)
+    {
+        bmutex_unlock(musicjoblock);
+        return;
+    }
+    data = (char *)malloc(len);
+    if(!data)
+    {
+        bmutex_unlock(musicjoblock);
+        return;
+    }
+    memcpy(data, song, len);
+    i = (musicjobhead+musicjobcount) % MUSICRENDERQUEUE;
+    musicjobs[i].crc = crc;
+    musicjobs[i].data = data;
+    musicjobs[i].len = len;
+    musicjobcount++;
+    start = (!musicworker || musicworkerdone);
+    bmutex_unlock(musicjoblock);
+
+    if(start) startmusicrender();
+}
+
+static void stopmusicrender(void)
+{
+    if(musicworker)
+    {
+        musicworkercancel = 1;
+        bthread_wait(musicworker);
+        musicworker = NULL;
+    }
+
+    if(musicjoblock)
+    {
+        for(;musicjobcount>0;musicjobcount--)
+        {
+            free(musicjobs[musicjobhead].data);
+            musicjobhead = (musicjobhead+1) % MUSICRENDERQUEUE;
+        }
+        bmutex_destroy(musicjoblock);
+        musicjoblock = NULL;
+    }
+}
+
+static void freerenderedmusic(void)
+{
+    if(musicjoblock) bmutex_lock(musicjoblock);
+    musicresident = 0;
+    if(musicjoblock) bmutex_unlock(musicjoblock);
+}
+
+/*
+ * Swaps MusicPtr for the rendered version of the song it holds, if there is
+ * one and it fits in what the worker leaves of the budget.
+ */
+static char loadrenderedmusic(unsigned int crc)
+{
+    char fn[BMAX_PATH];
+    char *wave;
+    int fil, len, fits;
+
+    musiccachename(fn, sizeof(fn), crc, "wav");
+    fil = Bopen(fn, BO_BINARY|BO_RDONLY, BS_IREAD);
+    if(fil < 0) return 0;
+
+    len = Blseek(fil, 0, BSEEK_END);
+    Blseek(fil, 0, BSEEK_SET);
+
+    // claim the memory before reading so the worker can't take it meanwhile
+    fits = 0;
+    if(musicjoblock) bmutex_lock(musicjoblock);
+    if(len > 44 && len <= MUSICRENDERBUDGET - musicrendering)
+    {
+        musicresident = len;
+        fits = 1;
+    }
+    if(musicjoblock) bmutex_unlock(musicjoblock);
+
+    wave = fits ? (char *)malloc(len) : NULL;
+    if(!wave || Bread(fil, wave, len) != len)
+    {
+        if(wave) free(wave);
+        if(fits) freerenderedmusic();
+        Bclose(fil);
+        return 0;
+    }
+    Bclose(fil);
+
+    free(MusicPtr);
+    MusicPtr = wave;
+    MusicLen = len;
+    return 1;
+}
+
+/*
+ * Queues a song for rendering ahead of it being played. Songs already seen
+ * are recognised by name, before any file is opened.
+ */
+void precachemusic(char *fn)
+{
+    char *song;
+    int fp, len, i;
+    unsigned int namecrc;
+
+    if(MusicToggle == 0 || MusicDevice < 0 || FXDevice < 0 || !fn[0]) return;
+
+    namecrc = crc32once((unsigned char *)fn, strlen(fn));
+    for(i=0;i<nummusicprecached;i++)
+        if(musicprecached[i] == namecrc) return;
+    if(nummusicprecached < MUSICPRECACHED)
+        musicprecached[nummusicprecached++] = namecrc;
+
+    fp = kopen4load(fn, 0);
+    if(fp < 0) return;
+
+    len = kfilelength(fp);
+    song = (char *)malloc(len);
+    if(song && kread(fp, song, len) == len && len >= 4 && !memcmp(song, "MThd", 4))
+        queuemusicrender(song, len, crc32once((unsigned char *)song, len));
+    if(song) free(song);
+    kclose(fp);
+}
+
+/*
+ * Called once a frame to switch a song playing through the MIDI driver
+ * over to its rendered version as soon as the worker finishes it.
+ */
+void musicupdate(void)
+{
+    static unsigned int musicseen = 0;
+
+    if(musicworker && musicworkerdone)
+    {
+        bthread_wait(musicworker);
+        musicworker = NULL;
+    }
+
+    // the worker stops short of its queue when the budget runs out, so
+    // carry on once the playing song has let go of enough of it
+    if(!musicworker && musicjobcount > 0 &&
+       MUSICRENDERBUDGET - musicresident >= MUSICRENDERMINSECONDS*MUSICRENDERRATE*2)
+        startmusicrender();
+
+    // something new has been rendered; see if it's what is playing
+    if(musicrendercount == musicseen) return;
+    musicseen = musicrendercount;
+
+    if(!MusicCRC || MusicIsWaveform || !loadrenderedmusic(MusicCRC)) return;
+    MusicCRC = 0;
+
+    MUSIC_StopSong();
+    MusicVoice = FX_PlayLoopedAuto(MusicPtr, MusicLen, 0, 0, 0,
+                                   MusicVolume, MusicVolume, MusicVolume,
+                                   FX_MUSIC_PRIORITY, MUSIC_ID);
+    MusicIsWaveform = 1;
+    if(MusicPaused && MusicVoice >= 0) FX_PauseSound(MusicVoice, TRUE);
+}
+
 void playmusic(char *fn)
 {
     int fp=-1;
@@ -381,6 +719,13 @@ void playmusic(char *fn)
     xbox_play:
 #endif
     
+    if (!memcmp(MusicPtr, "MThd", 4) && FXDevice >= 0) {
+       // play the rendered copy if there is one, otherwise have one made
+       MusicCRC = crc32once((unsigned char *)MusicPtr, MusicLen);
+       if (loadrenderedmusic(MusicCRC)) MusicCRC = 0;
+       else queuemusicrender(MusicPtr, MusicLen, MusicCRC);
+    }
+
     if (!memcmp(MusicPtr, "MThd", 4)) {
        MUSIC_PlaySong( MusicPtr, MusicLen, MUSIC_LoopSong );
        MusicIsWaveform = 0;
@@ -407,40 +752,198 @@ void stopmusic(void)
     }
 
     MusicPaused = 0;
+    MusicCRC = 0;
 
     if (MusicPtr) {
        free(MusicPtr);
        MusicPtr = 0;
        MusicLen = 0;
     }
+    freerenderedmusic();
 }
 
-char loadsound(unsigned short num)
+/*
+ * Decoded sound cache. Each sound is parsed once into flat PCM (keeping
+ * its own rate, sample width and channel count) so starting a voice is a
+ * pointer hand-off. Entries sit on an LRU list under a memory budget and
+ * are only evicted while none of their voices are playing. Files that
+ * only the streaming parsers understand are cached as loaded.
+ */
+#define SOUNDCACHEBUDGET (6<<20)
+
+typedef struct
 {
-    int   fp, l;
+    unsigned int rate;
+    int bits, channels;     // bits == 0: raw VOC/WAV container
+    unsigned int frames;
+    int size;
+    short prev, next;       // LRU links, most recent at soundcachehead
+} SOUNDCACHE;
+
+static SOUNDCACHE soundcache[NUM_SOUNDS];
+static short soundcachehead = -1, soundcachetail = -1;
+static int soundcacheused = 0;
+
+static void soundcache_unlink(int num)
+{
+    SOUNDCACHE *e = &soundcache[num];
 
-    if(num >= NUM_SOUNDS || SoundToggle == 0) return 0;
-    if (FXDevice < 0) return 0;
+    if (e->prev >= 0) soundcache[e->prev].next = e->next;
+    else soundcachehead = e->next;
+    if (e->next >= 0) soundcache[e->next].prev = e->prev;
+    else soundcachetail = e->prev;
+    e->prev = e->next = -1;
+}
 
-    fp = kopen4load(sounds[num],loadfromgrouponly);
-    if(fp == -1)
+static void soundcache_touch(int num)
+{
+    SOUNDCACHE *e = &soundcache[num];
+
+    if (soundcachehead == num) return;
+    if (e->prev >= 0 || e->next >= 0 || soundcachetail == num)
+        soundcache_unlink(num);
+
+    e->prev = -1;
+    e->next = soundcachehead;
+    if (soundcachehead >= 0) soundcache[soundcachehead].prev = num;
+    soundcachehead = num;
+    if (soundcachetail < 0) soundcachetail = num;
+}
+
+static void soundcache_free(int num)
+{
+    soundcache_unlink(num);
+    soundcacheused -= soundcache[num].size;
+    free(Sound[num].ptr);
+    Sound[num].ptr = 0;
+    soundcache[num].size = 0;
+}
+
+// Frees least recently used sounds that aren't playing until 'need' more bytes fit.
+static int soundcache_makeroom(int need)
+{
+    int num, prev;
+
+    for (num = soundcachetail; num >= 0 && soundcacheused + need > SOUNDCACHEBUDGET; num = prev)
     {
-        sprintf(&fta_quotes[113][0],"Sound %s(#%d) not found.",sounds[num],num);
-        FTA(113,&ps[myconnectindex]);
-        return 0;
+        prev = soundcache[num].prev;
+        if (Sound[num].numall > 0) continue;
+        soundcache_free(num);
+    }
+
+    return soundcacheused + need <= SOUNDCACHEBUDGET;
+}
+
+static void soundcache_flush(void)
+{
+    while (soundcachetail >= 0)
+        soundcache_free(soundcachetail);
+}
+
+// Returns 1 if cached (or larger than maxsize), 0 if out of budget,
+// -1 if the file can't be read.
+static int soundcache_load(unsigned short num, int evict, int maxsize)
+{
+    SOUNDCACHE *e = &soundcache[num];
+    char *file, *pcm;
+    int fp, l, pcmlen;
+
+    if (Sound[num].ptr) {
+        soundcache_touch(num);
+        return 1;
     }
 
+    fp = kopen4load(sounds[num],loadfromgrouponly);
+    if(fp == -1) return -1;
+
     l = kfilelength( fp );
     soundsiz[num] = l;
 
-    Sound[num].lock = 200;
+    if (l > maxsize)
+    {
+        kclose( fp );
+        return 1;
+    }
 
-    allocache((void **)&Sound[num].ptr,l,&Sound[num].lock);
-    kread( fp, Sound[num].ptr , l);
+    if (evict) soundcache_makeroom(l);
+    if (soundcacheused + l > SOUNDCACHEBUDGET || (file = (char *)malloc(l)) == NULL)
+    {
+        kclose( fp );
+        return 0;
+    }
+    kread( fp, file, l);
     kclose( fp );
+
+    e->bits = 0;
+    e->frames = 0;
+    e->size = l;
+    Sound[num].ptr = file;
+
+    pcmlen = FX_DecodeSound(file, l, NULL, &e->rate, &e->bits, &e->channels);
+    if (pcmlen > 0 && (pcm = (char *)malloc(pcmlen)) != NULL)
+    {
+        FX_DecodeSound(file, l, pcm, &e->rate, &e->bits, &e->channels);
+        free(file);
+        e->frames = pcmlen / (e->channels * e->bits / 8);
+        e->size = pcmlen;
+        Sound[num].ptr = pcm;
+    }
+    else e->bits = 0;
+
+    e->prev = e->next = -1;
+    soundcacheused += e->size;
+    soundcache_touch(num);
     return 1;
 }
 
+static int soundcache_playlooped(int num, int pitch, int vol, int left, int right)
+{
+    SOUNDCACHE *e = &soundcache[num];
+
+    soundcache_touch(num);
+    if (e->bits)
+        return FX_PlayLoopedPCM(Sound[num].ptr, e->frames, 0, -1, e->rate, e->bits, e->channels,
+                                pitch, vol, left, right, soundpr[num], num);
+    return FX_PlayLoopedAuto(Sound[num].ptr, soundsiz[num], 0, -1,
+                             pitch, vol, left, right, soundpr[num], num);
+}
+
+static int soundcache_play3d(int num, int pitch, int angle, int distance)
+{
+    SOUNDCACHE *e = &soundcache[num];
+
+    soundcache_touch(num);
+    if (e->bits)
+        return FX_PlayPCM3D(Sound[num].ptr, e->frames, e->rate, e->bits, e->channels,
+                            pitch, angle, distance, soundpr[num], num);
+    return FX_PlayAuto3D(Sound[num].ptr, soundsiz[num], pitch, angle, distance, soundpr[num], num);
+}
+
+// Caches a sound without evicting anything, skipping files over maxsize bytes.
+char precachesound(unsigned short num, int maxsize)
+{
+    if(num >= NUM_SOUNDS || SoundToggle == 0) return 0;
+    if (FXDevice < 0) return 0;
+
+    return soundcache_load(num, 0, maxsize) > 0;
+}
+
+char loadsound(unsigned short num)
+{
+    int r;
+
+    if(num >= NUM_SOUNDS || SoundToggle == 0) return 0;
+    if (FXDevice < 0) return 0;
+
+    r = soundcache_load(num, 1, 0x7fffffff);
+    if(r < 0)
+    {
+        sprintf(&fta_quotes[113][0],"Sound %s(#%d) not found.",sounds[num],num);
+        FTA(113,&ps[myconnectindex]);
+    }
+    return r > 0;
+}
+
 int xyzsound(short num,short i,int x,int y,int z)
 {
     int sndist, cx, cy, cz, j,k;
@@ -539,13 +1042,7 @@ int xyzsound(short num,short i,int x,int y,int z)
         sndang &= 2047;
     }
 
-    if(Sound[num].ptr == 0) { if( loadsound(num) == 0 ) return 0; }
-    else
-    {
-       if (Sound[num].lock < 200)
-          Sound[num].lock = 200;
-       else Sound[num].lock++;
-    }
+    if( loadsound(num) == 0 ) return 0;
 
     if( soundm[num]&16 ) sndist = 0;
 
@@ -556,12 +1053,11 @@ int xyzsound(short num,short i,int x,int y,int z)
     {
         if(Sound[num].num > 0) return -1;
 
-        voice = FX_PlayLoopedAuto( Sound[num].ptr, soundsiz[num], 0, -1,
-                    pitch,sndist>>6,sndist>>6,0,soundpr[num],num);
+        voice = soundcache_playlooped(num, pitch, sndist>>6, sndist>>6, 0);
     }
     else
     {
-        voice = FX_PlayAuto3D( Sound[ num ].ptr, soundsiz[num], pitch,sndang>>6,sndist>>6, soundpr[num], num );
+        voice = soundcache_play3d(num, pitch, sndang>>6, sndist>>6);
     }
 
     if ( voice > FX_Ok )
@@ -571,7 +1067,6 @@ int xyzsound(short num,short i,int x,int y,int z)
         Sound[num].num++;
 		  Sound[num].numall++;
     }
-    else Sound[num].lock--;
     return (voice);
 }
 
@@ -608,27 +1103,20 @@ void sound(short num)
     }
     else pitch = pitchs;
 
-    if(Sound[num].ptr == 0) { if( loadsound(num) == 0 ) {
+    if( loadsound(num) == 0 ) {
 #ifdef _XBOX
         xbox_log("sound(%d): loadsound FAILED\n", (int)num);
 #endif
         return;
-    } }
-    else
-    {
-       if (Sound[num].lock < 200)
-          Sound[num].lock = 200;
-       else Sound[num].lock++;
     }
 
     if( soundm[num]&1 )
     {
-         voice = FX_PlayLoopedAuto( Sound[num].ptr, soundsiz[num], 0, -1,
-                 pitch,LOUDESTVOLUME,LOUDESTVOLUME,LOUDESTVOLUME,soundpr[num],num);
+         voice = soundcache_playlooped(num, pitch, LOUDESTVOLUME, LOUDESTVOLUME, LOUDESTVOLUME);
     }
     else
     {
-        voice = FX_PlayAuto3D( Sound[ num ].ptr, soundsiz[num], pitch,0,255-LOUDESTVOLUME,soundpr[num], num );
+        voice = soundcache_play3d(num, pitch, 0, 255-LOUDESTVOLUME);
     }
 
 #ifdef _XBOX
@@ -641,9 +1129,7 @@ void sound(short num)
 #endif
     if(voice > FX_Ok) {
 		 Sound[num].numall++;
-		 return;
 	 }
-    Sound[num].lock--;
 }
 
 int spritesound(unsigned short num, short i)
@@ -683,10 +1169,17 @@ void stopenvsound(short num,short i)
     }
 }
 
+#define MAXPANEMITTERS 256
+
+static short panemitnum[MAXPANEMITTERS], panemitspr[MAXPANEMITTERS];
+static int panemitdx[MAXPANEMITTERS], panemitdy[MAXPANEMITTERS], panemitdz[MAXPANEMITTERS];
+static int panemitdist[MAXPANEMITTERS];
+static int panvoice[MAXPANEMITTERS], panang[MAXPANEMITTERS], pandist[MAXPANEMITTERS];
+
 void pan3dsound(void)
 {
-    int sndist, sx, sy, sz, cx, cy, cz;
-    short sndang,ca,j,k,i,cs;
+    int sndist, cx, cy, cz, e, numemit, numpan;
+    short sndang,ca,j,k,i,cs,stopped;
 
     numenvsnds = 0;
 
@@ -707,13 +1200,35 @@ void pan3dsound(void)
         ca = sprite[ud.camerasprite].ang;
     }
 
-    for(j=0;j<NUM_SOUNDS;j++) for(k=0;k<Sound[j].num;k++)
+    // Gather every owned voice into a compact emitter list. The stop
+    // callbacks reshuffle SoundOwner, so nothing below reads it again.
+    numemit = 0;
+    for(j=0;j<NUM_SOUNDS;j++) for(k=0;k<Sound[j].num && numemit<MAXPANEMITTERS;k++)
     {
         i = SoundOwner[j][k].i;
 
-        sx = sprite[i].x;
-        sy = sprite[i].y;
-        sz = sprite[i].z;
+        panemitnum[numemit] = j;
+        panemitspr[numemit] = i;
+        panvoice[numemit] = SoundOwner[j][k].voice;
+        panemitdx[numemit] = cx-sprite[i].x;
+        panemitdy[numemit] = cy-sprite[i].y;
+        panemitdz[numemit] = (cz-sprite[i].z)>>4;
+        numemit++;
+    }
+
+    // Listener relative distances in one pass over the emitters
+    for(e=0;e<numemit;e++)
+        panemitdist[e] = FindDistance3D(panemitdx[e],panemitdy[e],panemitdz[e]);
+
+    numpan = 0;
+    stopped = -1;
+    for(e=0;e<numemit;e++)
+    {
+        j = panemitnum[e];
+        i = panemitspr[e];
+
+        // The rest of a sound's voices wait for next frame once one is stopped
+        if(j == stopped) continue;
 
         if( PN == APLAYER && sprite[i].yvel == screenpeek)
         {
@@ -722,9 +1237,9 @@ void pan3dsound(void)
         }
         else
         {
-            sndang = 2048 + ca - getangle(cx-sx,cy-sy);
+            sndang = 2048 + ca - getangle(panemitdx[e],panemitdy[e]);
             sndang &= 2047;
-            sndist = FindDistance3D((cx-sx),(cy-sy),(cz-sz)>>4);
+            sndist = panemitdist[e];
             if( i >= 0 && (soundm[j]&16) == 0 && PN == MUSICANDSFX && SLT < 999 && (sector[SECT].lotag&0xff) < 9 )
                 sndist = divscale14(sndist,(SHT+1));
         }
@@ -732,9 +1247,6 @@ void pan3dsound(void)
         sndist += soundvo[j];
         if(sndist < 0) sndist = 0;
 
-        if( sndist && PN != MUSICANDSFX && !cansee(cx,cy,cz-(24<<8),cs,sx,sy,sz-(24<<8),SECT) )
-            sndist += sndist>>5;
-
         if(PN == MUSICANDSFX && SLT < 999)
             numenvsnds++;
 
@@ -743,13 +1255,23 @@ void pan3dsound(void)
             case PIPEBOMB_EXPLODE:
             case LASERTRIP_EXPLODE:
             case RPG_EXPLODE:
+                if( sndist && PN != MUSICANDSFX && !cansee(cx,cy,cz-(24<<8),cs,SX,SY,SZ-(24<<8),SECT) )
+                    sndist += sndist>>5;
                 if(sndist > (6144)) sndist = (6144);
                 break;
             default:
-                if( sndist > 31444 && PN != MUSICANDSFX)
+                if( PN != MUSICANDSFX )
                 {
-                    stopsound(j);
-                    continue;
+                    // Occlusion only makes a sound quieter, so anything already
+                    // out of range is culled before paying for the cansee
+                    if( sndist <= 31444 && sndist && !cansee(cx,cy,cz-(24<<8),cs,SX,SY,SZ-(24<<8),SECT) )
+                        sndist += sndist>>5;
+                    if( sndist > 31444 )
+                    {
+                        stopsound(j);
+                        stopped = j;
+                        continue;
+                    }
                 }
         }
 
@@ -759,8 +1281,14 @@ void pan3dsound(void)
         if(sndist < ((255-LOUDESTVOLUME)<<6) )
             sndist = ((255-LOUDESTVOLUME)<<6);
 
-        FX_Pan3D(SoundOwner[j][k].voice,sndang>>6,sndist>>6);
+        panvoice[numpan] = panvoice[e];
+        panang[numpan] = sndang>>6;
+        pandist[numpan] = sndist>>6;
+        numpan++;
     }
+
+    if(numpan > 0)
+        FX_Pan3DBatch(panvoice,panang,pandist,numpan);
 }
 
 void testcallback(unsigned int num)
@@ -803,17 +1331,12 @@ void testcallback(unsigned int num)
         }
 
 		  Sound[num].numall--;
-        Sound[num].lock--;
 }
 
 void clearsoundlocks(void)
 {
     int i;
 
-    for(i=0;i<NUM_SOUNDS;i++)
-        if(Sound[i].lock >= 200)
-            Sound[i].lock = 199;
-
     for(i=0;i<11;i++)
         if(lumplockbyte[i] >= 200)
             lumplockbyte[i] = 199;